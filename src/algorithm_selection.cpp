@@ -0,0 +1,156 @@
+#include "algorithm_selection.h"
+#include "compression_level.h"
+#include "factor_stream.h"
+#include "slice.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+    // Below, the repetitions of LZDR save too few factors to be worth their cost
+    constexpr double MIN_REPETITION_RATIO = 0.005;
+    constexpr double MIN_LONG_RUN_RATIO = 0.05;
+    // Above, the input is most likely compressed or encrypted
+    constexpr double MAX_BYTE_ENTROPY = 7.5;
+    // Smaller blocks lose too many factors of the shared base
+    constexpr size_t MIN_BLOCK_SIZE = 1024 * 1024;
+
+    // With three significant digits
+    std::string format_number(const double value) {
+        std::ostringstream out;
+        out.precision(3);
+        out << value;
+        return out.str();
+    }
+
+    std::string format_ratio(const double ratio) {
+        return format_number(100 * ratio) + "%";
+    }
+
+    std::string format_throughput(const double throughput) {
+        return format_number(throughput) + " MB/s";
+    }
+
+    // The LZDR throughput on the sample, scaled by the throughput of the level relative to LZDR on the reference corpus
+    double expected_throughput(const InputProfile &profile, const int level) {
+        return profile.lzdr_throughput * compression_level(level).throughput_target / compression_level(2).throughput_target;
+    }
+}
+
+InputProfile profile_input(const Slice input, const size_t sample_size) {
+    const Slice sample = input.slice(0, std::min(sample_size, input.size()));
+    InputProfile profile = {sample.size(), 0, 0, 0, 0, 0, 0};
+    if (sample.size() == 0) {
+        return profile;
+    }
+
+    std::array<size_t, 256> byte_counts = {};
+    size_t num_runs = 0;
+    size_t num_long_run_bytes = 0;
+    size_t run_length = 0;
+    for (size_t i = 0; i < sample.size(); ++i) {
+        byte_counts[sample[i]] += 1;
+        ++run_length;
+        if (i + 1 == sample.size() || sample[i + 1] != sample[i]) {
+            ++num_runs;
+            if (run_length >= LONG_RUN_LENGTH) {
+                num_long_run_bytes += run_length;
+            }
+            run_length = 0;
+        }
+    }
+    for (const size_t count: byte_counts) {
+        if (count > 0) {
+            const double p = static_cast<double>(count) / static_cast<double>(sample.size());
+            profile.byte_entropy -= p * std::log2(p);
+        }
+    }
+    profile.mean_run_length = static_cast<double>(sample.size()) / static_cast<double>(num_runs);
+    profile.long_run_ratio = static_cast<double>(num_long_run_bytes) / static_cast<double>(sample.size());
+
+    // Short LZDR factorization of the sample
+    const auto start = std::chrono::steady_clock::now();
+    LzdrFactorStream factors(sample);
+    size_t num_repetitions = 0;
+    while (const StreamedFactor *factor = factors.next()) {
+        if (factor->type() == FactorType::REPETITION) {
+            ++num_repetitions;
+        }
+        profile.num_factors = factor->index;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    profile.repetition_ratio = static_cast<double>(num_repetitions) / static_cast<double>(profile.num_factors);
+    profile.lzdr_throughput = static_cast<double>(sample.size()) / BYTES_PER_MB / std::max(elapsed.count(), 1e-9);
+    return profile;
+}
+
+AlgorithmChoice choose_algorithm(const InputProfile &profile, const size_t input_size, const double target_throughput,
+                                 const size_t num_threads) {
+    AlgorithmChoice choice = {2, 0, 0, {}};
+    const bool hardly_compressible = profile.byte_entropy > MAX_BYTE_ENTROPY;
+    if (hardly_compressible) {
+        choice.level = 1;
+        choice.reasons.push_back("byte entropy of " + format_number(profile.byte_entropy) +
+                                 " bits: the input is hardly compressible, so the cheapest algorithm (LZD+) is used");
+    } else if (profile.repetition_ratio >= MIN_REPETITION_RATIO) {
+        choice.reasons.push_back(format_ratio(profile.repetition_ratio) + " of the early factors are repetitions: LZDR pays off");
+    } else if (profile.long_run_ratio >= MIN_LONG_RUN_RATIO) {
+        choice.reasons.push_back(format_ratio(profile.long_run_ratio) + " of the bytes are in runs of at least " +
+                                 std::to_string(LONG_RUN_LENGTH) + " equal bytes: LZDR pays off");
+    } else {
+        choice.level = 1;
+        choice.reasons.push_back("only " + format_ratio(profile.repetition_ratio) +
+                                 " of the early factors are repetitions: LZD+ is nearly as good and cheaper");
+    }
+    choice.expected_throughput = expected_throughput(profile, choice.level);
+    if (target_throughput <= 0) {
+        return choice;
+    }
+
+    if (choice.expected_throughput >= target_throughput) {
+        // Spend the time the target leaves on more candidate lengths, unless the input is hardly compressible
+        const int chosen_level = choice.level;
+        if (!hardly_compressible) {
+            while (choice.level < MAX_COMPRESSION_LEVEL && expected_throughput(profile, choice.level + 1) >= target_throughput) {
+                ++choice.level;
+            }
+            choice.expected_throughput = expected_throughput(profile, choice.level);
+        }
+        if (choice.level > chosen_level) {
+            choice.reasons.push_back(compression_level(choice.level).name + std::string(" is expected to reach ") +
+                                     format_throughput(choice.expected_throughput) + ", the target is " + format_throughput(target_throughput));
+        }
+        return choice;
+    }
+
+    choice.reasons.push_back(compression_level(choice.level).name + std::string(" is expected to reach only ") +
+                             format_throughput(choice.expected_throughput) + ", the target is " + format_throughput(target_throughput));
+    if (choice.level == 2 && expected_throughput(profile, 1) >= target_throughput) {
+        choice.level = 1;
+        choice.expected_throughput = expected_throughput(profile, 1);
+        choice.reasons.emplace_back("LZD+ is expected to meet the target");
+        return choice;
+    }
+    const size_t num_blocks = std::min(num_threads, input_size / MIN_BLOCK_SIZE);
+    if (num_blocks < 2) {
+        choice.reasons.push_back("too few threads or bytes for parallel blocks (at least 2 blocks of " +
+                                 std::to_string(MIN_BLOCK_SIZE) + " bytes), the target cannot be met");
+        return choice;
+    }
+    // Every block is compressed by LZDR on its own thread
+    choice.level = 2;
+    choice.block_size = (input_size + num_blocks - 1) / num_blocks;
+    choice.expected_throughput = expected_throughput(profile, 2) * static_cast<double>(num_blocks);
+    choice.reasons.push_back("LZDR in " + std::to_string(num_blocks) + " parallel blocks of " + std::to_string(choice.block_size) +
+                             " bytes is expected to reach " + format_throughput(choice.expected_throughput) +
+                             (choice.expected_throughput >= target_throughput ? "" : ", which is the fastest choice"));
+    return choice;
+}
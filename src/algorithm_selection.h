@@ -0,0 +1,47 @@
+#ifndef ALGORITHM_SELECTION_H
+#define ALGORITHM_SELECTION_H
+#include "slice.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Profile of the beginning of an input, used to choose the algorithm without tuning it by hand.
+struct InputProfile {
+    size_t sample_size;
+    // Entropy of the byte distribution in bits per byte (0 to 8)
+    double byte_entropy;
+    // Mean length of the runs of equal bytes
+    double mean_run_length;
+    // Fraction of the bytes that are part of a run of at least LONG_RUN_LENGTH equal bytes
+    double long_run_ratio;
+    // LZDR factors of the sample and the fraction of them that are repetitions
+    size_t num_factors;
+    double repetition_ratio;
+    // Throughput of the LZDR factorization of the sample in MB/s
+    double lzdr_throughput;
+};
+
+constexpr size_t LONG_RUN_LENGTH = 8;
+
+// The choice of -a auto: either a compression level or LZDR in parallel blocks (if block_size is not 0),
+// with the reasons for it
+struct AlgorithmChoice {
+    int level;
+    size_t block_size;
+    // Expected throughput in MB/s, scaled from the throughput of the profile
+    double expected_throughput;
+    std::vector<std::string> reasons;
+};
+
+// Profiles the first sample_size bytes of input with a short LZDR factorization
+InputProfile profile_input(Slice input, size_t sample_size);
+
+// Chooses LZD+ if the repetitions of LZDR do not pay off, LZDR otherwise.
+// If target_throughput (MB/s) is not 0, the slowest level that is expected to meet it is chosen
+// (LZD+ stays chosen for hardly compressible inputs), and if no level meets it, LZDR in one block per thread
+// (if there are enough threads and bytes).
+// The throughput of the other levels is expected to be in the same ratio to LZDR as their throughput targets
+AlgorithmChoice choose_algorithm(const InputProfile &profile, size_t input_size, double target_throughput, size_t num_threads);
+
+#endif //ALGORITHM_SELECTION_H
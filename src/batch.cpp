@@ -0,0 +1,121 @@
+#include "batch.h"
+#include "compression_level.h"
+#include "slice.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+    // Buffers of a worker, kept over all its files so their capacity gets reused
+    struct WorkerBuffers {
+        std::vector<uint8_t> input;
+        std::vector<uint8_t> compressed;
+    };
+
+    void read_file(const std::string &path, std::vector<uint8_t> &out) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Could not open " + path);
+        }
+        out.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(out.data()), static_cast<std::streamsize>(out.size()));
+        if (!file) {
+            throw std::runtime_error("I/O error while reading " + path);
+        }
+    }
+
+    void write_file(const std::string &path, const std::vector<uint8_t> &data) {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            throw std::runtime_error("I/O error while writing " + path);
+        }
+    }
+}
+
+std::vector<std::string> batch_input_paths(const std::string &path) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    if (std::filesystem::is_directory(path, error)) {
+        for (auto it = std::filesystem::recursive_directory_iterator(path, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (it->is_regular_file(error) && it->path().extension() != ".lzdr") {
+                paths.push_back(it->path().string());
+            }
+        }
+        if (error) {
+            throw std::runtime_error("Could not read directory " + path);
+        }
+        // The directory order is unspecified
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    std::ifstream list(path);
+    if (!list) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    std::string line;
+    while (std::getline(list, line)) {
+        if (!line.empty()) {
+            paths.push_back(line);
+        }
+    }
+    return paths;
+}
+
+std::vector<BatchFileResult> compress_batch(const std::vector<std::string> &input_paths, const int level,
+                                            const bool check_decompressed_equals_input, const double time_budget_seconds,
+                                            const double time_budget_per_mb, const size_t num_workers) {
+    // Check the level before starting any worker
+    compression_level(level);
+
+    std::vector<BatchFileResult> results(input_paths.size());
+    for (size_t i = 0; i < input_paths.size(); ++i) {
+        std::error_code error;
+        const uintmax_t size = std::filesystem::file_size(input_paths[i], error);
+        results[i] = {input_paths[i], input_paths[i] + ".lzdr", error ? 0 : static_cast<size_t>(size), 0, 0, ""};
+    }
+
+    // Largest files first, so no large file is started last and determines the end of the batch
+    std::vector<size_t> order(input_paths.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&results](const size_t a, const size_t b) {
+        return results[a].input_size > results[b].input_size;
+    });
+
+    std::vector<WorkerBuffers> worker_buffers(std::max<size_t>(num_workers, 1));
+    run_work_stealing(worker_buffers.size(), order.size(), [&](const size_t task, const size_t worker) {
+        BatchFileResult &result = results[order[task]];
+        WorkerBuffers &buffers = worker_buffers[worker];
+        try {
+            read_file(result.input_path, buffers.input);
+            result.input_size = buffers.input.size();
+            const double file_time_budget = time_budget_per_mb > 0
+                ? time_budget_per_mb * static_cast<double>(buffers.input.size()) / (1024.0 * 1024.0)
+                : time_budget_seconds;
+            buffers.compressed.clear();
+            // The stats of the workers are dropped, they must not write to std::cout at the same time
+            std::ostream no_stats(nullptr);
+            result.num_factors = compress_with_level(level, Slice(buffers.input), check_decompressed_equals_input,
+                                                     &buffers.compressed, file_time_budget, no_stats);
+            write_file(result.output_path, buffers.compressed);
+            result.compressed_size = buffers.compressed.size();
+        } catch (const std::exception &e) {
+            result.error = e.what();
+        }
+    });
+    return results;
+}
@@ -0,0 +1,34 @@
+#ifndef BATCH_H
+#define BATCH_H
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Compressing many files in one process, so process start-up and allocator warm-up are paid only once.
+// Each file is a task of a work-stealing pool (see run_work_stealing), the largest files are started first.
+
+struct BatchFileResult {
+    std::string input_path;
+    // input_path + ".lzdr"
+    std::string output_path;
+    size_t input_size;
+    size_t compressed_size;
+    size_t num_factors;
+    // Empty if the file got compressed
+    std::string error;
+};
+
+// Returns the input files of a batch: a directory is searched recursively for regular files
+// (except for .lzdr outputs of a previous batch), any other file is read as a list with one path per line.
+// Throws std::runtime_error if the path cannot be read
+std::vector<std::string> batch_input_paths(const std::string &path);
+
+// Compresses every input file with the given level into input_path + ".lzdr" on num_workers threads.
+// The time budget of a file is time_budget_per_mb times its size in MiB if that is not 0, otherwise time_budget_seconds.
+// A file that cannot be read, compressed or written gets an error in its result and does not stop the batch.
+// The statistics the algorithms print to std::cout are discarded while the batch runs.
+// Returns the results in the order of input_paths
+std::vector<BatchFileResult> compress_batch(const std::vector<std::string> &input_paths, int level, bool check_decompressed_equals_input,
+                                            double time_budget_seconds, double time_budget_per_mb, size_t num_workers);
+
+#endif //BATCH_H
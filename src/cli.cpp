@@ -1,29 +1,93 @@
 #include "cli.h"
+#include "algorithm_selection.h"
+#include "batch.h"
+#include "compression_level.h"
+#include "compressor.h"
+#include "estimator.h"
+#include "io_pipeline.h"
 #include "slice.h"
 #include "flexible_lzw_naive.h"
 #include "lzdr_linear_time.h"
 #include "lzd_radix_tree.h"
+#include "lzw.h"
 #include "std_flexible_lzw_naive.h"
 #include "std_flexible_lzdr_radix_trie.h"
 #include "flexible_lzdr_radix_trie.h"
 #include "flexible_lzdr_max_radix_trie.h"
+#include "kernel_benchmark.h"
 #include "lzd_plus_linear_time.h"
+#include "lzdr_checkpoint.h"
+#include "lzdr_dictionary.h"
+#include "lzdr_parallel_blocks.h"
+#include "lzdr_pattern_search.h"
+#include "lzdr_random_access.h"
 #include "test.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <optional>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace {
+    // Blocks handed from the reader thread to the factorization and from it to the writer thread
+    constexpr size_t PIPELINE_INPUT_BLOCK_SIZE = 256 * 1024;
+    constexpr size_t PIPELINE_OUTPUT_BLOCK_SIZE = 1024 * 1024;
+
     void print_help() {
         std::cout << "  --factors\n      Print factors" << std::endl;
         std::cout << std::endl;
-        std::cout << "  -c\n      Check decompressing compressed output equals input\n      (not available for LZW variants and Alternative Flexible LZDR Max.)" << std::endl;
+        std::cout << "  -c\n      Check decompressing compressed output equals input\n      (not available for the naive LZW variants and Alternative Flexible LZDR Max.;\n      LZD+, LZDR and the levels check on a second thread while compressing and stop at the first mismatching factor)" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  -a <ALGO_NAME>\n      Run single algorithm\n      (available: lzdr, lzd+, lzw, auto (chosen from a profile of the first --sample-size <BYTES> bytes (default: 262144)\n      to meet the throughput target given with --throughput <MB/s>, if any))" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  -<LEVEL>\n      Compress with level 1 (fastest) to 9 (fewest factors)\n      (1: LZD+, 2: LZDR, 3-9: Flexible LZDR testing 2 to 32 candidate lengths per position;\n      not with --dict, --engine=st, --blocks or --small-alphabet)" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --engine=<ENGINE>\n      Engine used for -a lzdr\n      (available: trie (default), st (suffix array based LCE queries))" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --time-budget <SECONDS>, --time-budget-per-mb <SECONDS>\n      Time budget of the Flexible LZDR parsings of --factors and -<LEVEL> (for the whole input or per MiB)\n      (fewer candidate lengths are tested while behind the budget, only the longest once it is used up)" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  -o <FILE>\n      Write the compressed output of -a or -<LEVEL> to FILE\n      (-a only for lzdr, lzd+ and lzw; -a lzdr and -2 overlap reading, factorizing and writing if the input is a file)" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --dict <FILE>\n      Use the pre-trained dictionary FILE for -a lzdr (trie engine only) and --decompress\n      (the compressed data identifies its dictionary, so --decompress rejects a missing or different one)" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --symbol-width <1|2|4>\n      Factorize the input as little-endian symbols of 1 (default), 2 or 4 bytes\n      (-a lzdr and -a lzd+ with the trie engine only; the width is stored, so --decompress detects it)" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --lzw-max-bits <BITS>\n      Maximum code width of -a lzw from 9 to 24 bits (default: 16), the dictionary is reset once it is full" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --small-alphabet\n      Factorize the ranks of the bytes for -a lzdr if the input has at most 32 distinct bytes (e.g. DNA or proteins)\n      (trie engine only; the compressed output is the same)" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --batch <FILELIST|DIR>\n      Compress every file listed in FILELIST (one path per line) or found in DIR (recursively)\n      with the level given as -<LEVEL> (default: 2) into <FILE>.lzdr and print a manifest\n      (largest files first, on all cores or the number of threads given with --threads <N>)" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --estimate <FILE>\n      Estimate the number of factors and the compressed size of FILE with the level given as -<LEVEL> (default: 2)\n      from --samples <N> (default: 16) blocks of --sample-size <BYTES> (default: 262144),\n      scaled with the growth of the factors on prefixes of up to --prefix <BYTES> (default: 4194304, 0: no scaling)\n      and an eighth of the file; if that is at least as many bytes as FILE, FILE is compressed as a whole" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --blocks <BLOCK_SIZE>\n      Compress with -a lzdr in blocks of BLOCK_SIZE bytes in parallel (--threads <N>, default: all cores),\n      where every block starts with the factors of the first block as shared dictionary" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --train\n      Factorize the input as sample corpus and write an LZDR dictionary to the file given with -o" << std::endl;
         std::cout << std::endl;
-        std::cout << "  -a <ALGO_NAME>\n      Run single algorithm\n      (available: lzdr, lzd+)" << std::endl;
+        std::cout << "  --append <FILE>\n      Compress the input with LZDR and append it to FILE, continuing the factorization\n      from the checkpoint FILE.ckpt (both are created if FILE does not exist)" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --decompress\n      Read LZDR/LZD+ compressed data and output the decompressed bytes" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --extract <FROM>:<TO>\n      Read LZDR/LZD+ compressed data and output the decompressed bytes in [FROM, TO)\n      without decompressing everything" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --grep <PATTERN>\n      Read LZDR/LZD+ compressed data and output the positions of all occurrences of PATTERN\n      without decompressing everything" << std::endl;
+        std::cout << std::endl;
+        std::cout << "  --bench-kernels\n      Measure the byte comparison kernels supported by the CPU" << std::endl;
         std::cout << std::endl;
         std::cout << "  --test\n      Run tests" << std::endl;
         std::cout << std::endl;
@@ -33,22 +97,418 @@ namespace {
         std::cout << "The input is read from stdin." << std::endl;
     }
 
-    void run_algo(const char* algo, const std::vector<uint8_t> &data, const bool check_decompressed_equals_input) {
+    void write_file(const char* path, const std::vector<uint8_t> &data) {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            std::cerr << "I/O error while writing " << path << std::endl;
+            std::exit(1);
+        }
+    }
+
+    // Returns the number of bytes left in stdin if it is a regular file, otherwise 0 (the size of a pipe is unknown)
+    size_t stdin_file_size() {
+        struct stat file_stat = {};
+        if (fstat(STDIN_FILENO, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+            return 0;
+        }
+        const off_t offset = lseek(STDIN_FILENO, 0, SEEK_CUR);
+        if (offset < 0 || offset >= file_stat.st_size) {
+            return 0;
+        }
+        return static_cast<size_t>(file_stat.st_size - offset);
+    }
+
+    // LZDR (radix trie) that factorizes stdin while it is read and writes the compressed output while it is produced.
+    // The output is written to output_path + ".tmp" and renamed once complete, so a failure leaves no partial file
+    void pipelined_lzdr(const size_t input_size, const bool check_decompressed_equals_input, const char* output_path) {
+        int output_fd = -1;
+        std::string temp_path;
+        if (output_path != nullptr) {
+            temp_path = std::string(output_path) + ".tmp";
+            output_fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (output_fd < 0) {
+                std::cerr << "I/O error while writing " << temp_path << std::endl;
+                std::exit(1);
+            }
+        }
+        try {
+            PipelinedInput input(STDIN_FILENO, input_size, PIPELINE_INPUT_BLOCK_SIZE);
+            std::optional<PipelinedOutput> output;
+            if (output_fd >= 0) {
+                output.emplace(output_fd, PIPELINE_OUTPUT_BLOCK_SIZE);
+            }
+            const size_t lzdr_pipelined_num_factors = lzdr_linear_time_pipelined(input, check_decompressed_equals_input,
+                                                                                 output ? &*output : nullptr);
+            if (output) {
+                output->finish();
+            }
+            std::cout << "Num factors: " << lzdr_pipelined_num_factors << std::endl;
+        } catch (const std::exception &error) {
+            // I/O errors (std::runtime_error) and mismatches of -c (std::out_of_range)
+            std::cerr << error.what() << std::endl;
+            if (output_fd >= 0) {
+                close(output_fd);
+                unlink(temp_path.c_str());
+            }
+            std::exit(1);
+        }
+        if (output_fd >= 0) {
+            if (close(output_fd) != 0) {
+                unlink(temp_path.c_str());
+                std::cerr << "I/O error while writing " << temp_path << std::endl;
+                std::exit(1);
+            }
+            if (rename(temp_path.c_str(), output_path) != 0) {
+                unlink(temp_path.c_str());
+                std::cerr << "I/O error while writing " << output_path << std::endl;
+                std::exit(1);
+            }
+        }
+    }
+
+    // Little-endian symbols of sizeof(Symbol) bytes
+    template<typename Symbol>
+    std::vector<Symbol> symbols_from_bytes(const std::vector<uint8_t> &data) {
+        if (data.size() % sizeof(Symbol) != 0) {
+            std::cout << "The input size is not a multiple of the symbol width." << std::endl;
+            std::exit(1);
+        }
+        std::vector<Symbol> symbols(data.size() / sizeof(Symbol));
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            symbols[i] = static_cast<Symbol>(symbol_from_bytes(data.data() + i * sizeof(Symbol), sizeof(Symbol)));
+        }
+        return symbols;
+    }
+
+    template<typename Symbol>
+    std::vector<uint8_t> symbols_to_bytes(const std::vector<Symbol> &symbols) {
+        std::vector<uint8_t> data;
+        data.reserve(symbols.size() * sizeof(Symbol));
+        for (const Symbol symbol: symbols) {
+            for (size_t i = 0; i < sizeof(Symbol); ++i) {
+                data.push_back(static_cast<uint8_t>(symbol >> (8 * i)));
+            }
+        }
+        return data;
+    }
+
+    template<typename Symbol>
+    void run_symbol_algo(const char* algo, const std::vector<uint8_t> &data, const bool check_decompressed_equals_input,
+                         const char* output_path) {
+        std::vector<uint8_t> compressed;
+        std::vector<uint8_t> *compressed_output = output_path != nullptr ? &compressed : nullptr;
+        const std::vector<Symbol> symbols = symbols_from_bytes<Symbol>(data);
         if (strcmp(algo, "lzdr") == 0) {
+            std::cout << "LZDR (radix trie, " << 8 * sizeof(Symbol) << "-bit symbols)" << std::endl;
+            const size_t lzdr_linear_time_num_factors = lzdr_linear_time(BasicSlice<Symbol>(symbols), check_decompressed_equals_input, compressed_output);
+            std::cout << "Num factors: " << lzdr_linear_time_num_factors << std::endl;
+        } else if (strcmp(algo, "lzd+") == 0) {
+            std::cout << "LZD+ (linear-time, " << 8 * sizeof(Symbol) << "-bit symbols)" << std::endl;
+            const size_t lzd_plus_linear_time_num_factors = lzd_plus_linear_time(BasicSlice<Symbol>(symbols), check_decompressed_equals_input, compressed_output);
+            std::cout << "Num factors: " << lzd_plus_linear_time_num_factors << std::endl;
+        } else {
+            std::cout << "The algorithm \"" << algo << "\" does not support --symbol-width." << std::endl;
+            std::exit(1);
+        }
+        if (output_path != nullptr) {
+            write_file(output_path, compressed);
+        }
+    }
+
+    // For the commands that only support bytes
+    void require_byte_symbols(const size_t symbol_width) {
+        if (symbol_width != 1) {
+            std::cout << "--symbol-width is only supported by -a lzdr, -a lzd+ and --decompress." << std::endl;
+            std::exit(1);
+        }
+    }
+
+    void run_algo(const char* algo, const char* engine, const std::vector<uint8_t> &data, const bool check_decompressed_equals_input,
+                  const char* output_path, const char* dict_path, const size_t block_size, const size_t num_threads,
+                  const bool small_alphabet = false, const unsigned lzw_max_code_bits = LZW_DEFAULT_MAX_CODE_BITS) {
+        std::vector<uint8_t> compressed;
+        std::vector<uint8_t> *compressed_output = output_path != nullptr ? &compressed : nullptr;
+        if (small_alphabet && (strcmp(algo, "lzdr") != 0 || strcmp(engine, "trie") != 0 || dict_path != nullptr || block_size > 0)) {
+            std::cout << "--small-alphabet is only supported for -a lzdr with the trie engine and without a dictionary or blocks." << std::endl;
+            std::exit(1);
+        }
+        if (dict_path != nullptr && (strcmp(algo, "lzdr") != 0 || strcmp(engine, "trie") != 0)) {
+            std::cout << "A dictionary is only supported for -a lzdr with the trie engine." << std::endl;
+            std::exit(1);
+        }
+        if (block_size > 0 && (strcmp(algo, "lzdr") != 0 || strcmp(engine, "trie") != 0 || dict_path != nullptr)) {
+            std::cout << "Blocks are only supported for -a lzdr with the trie engine and without a dictionary." << std::endl;
+            std::exit(1);
+        }
+        if (block_size > 0) {
+            std::cout << "LZDR (radix trie, parallel blocks)" << std::endl;
+            const size_t lzdr_parallel_blocks_num_factors = lzdr_parallel_blocks(Slice(data), block_size, num_threads, check_decompressed_equals_input, compressed_output);
+            std::cout << "Num factors: " << lzdr_parallel_blocks_num_factors << std::endl;
+        } else if (dict_path != nullptr) {
+            std::cout << "LZDR (radix trie, dictionary)" << std::endl;
+            const LzdrDictionary dictionary = LzdrDictionary::open(dict_path);
+            // Marks the compressed data, so it is not decompressed without the dictionary or with another one
+            if (compressed_output != nullptr) {
+                append_dictionary_data_header(*compressed_output, dictionary);
+            }
+            const size_t lzdr_dictionary_num_factors = lzdr_linear_time_with_dictionary(Slice(data), dictionary, check_decompressed_equals_input, compressed_output);
+            std::cout << "Num factors: " << lzdr_dictionary_num_factors << std::endl;
+        } else if (strcmp(algo, "lzdr") == 0 && strcmp(engine, "st") == 0) {
+            std::cout << "LZDR (suffix array)" << std::endl;
+            const size_t lzdr_suffix_array_num_factors = lzdr_suffix_array(Slice(data), check_decompressed_equals_input, compressed_output);
+            std::cout << "Num factors: " << lzdr_suffix_array_num_factors << std::endl;
+        } else if (strcmp(algo, "lzdr") == 0 && small_alphabet) {
+            std::cout << "LZDR (radix trie, small alphabet)" << std::endl;
+            const size_t lzdr_small_alphabet_num_factors = lzdr_linear_time_small_alphabet(Slice(data), check_decompressed_equals_input, compressed_output);
+            std::cout << "Num factors: " << lzdr_small_alphabet_num_factors << std::endl;
+        } else if (strcmp(algo, "lzdr") == 0) {
             std::cout << "LZDR (radix trie)" << std::endl;
-            const size_t lzdr_linear_time_num_factors = lzdr_linear_time(Slice(data), check_decompressed_equals_input);
+            const size_t lzdr_linear_time_num_factors = lzdr_linear_time(Slice(data), check_decompressed_equals_input, compressed_output);
             std::cout << "Num factors: " << lzdr_linear_time_num_factors << std::endl;
         } else if (strcmp(algo, "lzd+") == 0) {
             std::cout << "LZD+ (linear-time)" << std::endl;
-            const size_t lzd_plus_linear_time_num_factors = lzd_plus_linear_time(Slice(data), check_decompressed_equals_input);
+            const size_t lzd_plus_linear_time_num_factors = lzd_plus_linear_time(Slice(data), check_decompressed_equals_input, compressed_output);
             std::cout << "Num factors: " << lzd_plus_linear_time_num_factors << std::endl;
+        } else if (strcmp(algo, "lzw") == 0) {
+            std::cout << "LZW (trie)" << std::endl;
+            const size_t lzw_num_factors = lzw_compress(Slice(data), check_decompressed_equals_input, compressed_output, lzw_max_code_bits);
+            std::cout << "Num factors: " << lzw_num_factors << std::endl;
         } else {
             std::cout << "The algorithm \"" << algo << "\" is not implemented right now." << std::endl;
             std::exit(1);
         }
+        if (output_path != nullptr) {
+            write_file(output_path, compressed);
+        }
+    }
+
+    // Only one of the budgets is not 0
+    double time_budget(const size_t input_size, const double time_budget_seconds, const double time_budget_per_mb) {
+        if (time_budget_per_mb > 0) {
+            return time_budget_per_mb * static_cast<double>(input_size) / (1024.0 * 1024.0);
+        }
+        return time_budget_seconds;
+    }
+
+    void compress(const int level, const std::vector<uint8_t> &data, const bool check_decompressed_equals_input, const char* output_path,
+                  const double time_budget_seconds) {
+        std::vector<uint8_t> compressed;
+        std::cout << "Level " << level << ": " << compression_level(level).name << std::endl;
+        const size_t num_factors = compress_with_level(level, Slice(data), check_decompressed_equals_input,
+                                                       output_path != nullptr ? &compressed : nullptr, time_budget_seconds);
+        std::cout << "Num factors: " << num_factors << std::endl;
+        if (output_path != nullptr) {
+            write_file(output_path, compressed);
+        }
     }
 
-    void print_factors(const std::vector<uint8_t> &data, const bool check_decompressed_equals_input) {
+    void auto_compress(const std::vector<uint8_t> &data, const bool check_decompressed_equals_input, const char* output_path,
+                       const size_t sample_size, const double target_throughput, const size_t num_threads, const double time_budget_seconds) {
+        const InputProfile profile = profile_input(Slice(data), sample_size);
+        std::cout << "Profile of the first " << profile.sample_size << " bytes" << std::endl;
+        std::cout << "  Byte entropy: " << profile.byte_entropy << " bits" << std::endl;
+        std::cout << "  Mean run length: " << profile.mean_run_length << ", in runs of at least " << LONG_RUN_LENGTH << " bytes: "
+                  << 100 * profile.long_run_ratio << "%" << std::endl;
+        std::cout << "  LZDR factors: " << profile.num_factors << ", repetitions: " << 100 * profile.repetition_ratio << "%" << std::endl;
+        std::cout << "  LZDR throughput: " << profile.lzdr_throughput << " MB/s" << std::endl;
+        const AlgorithmChoice choice = choose_algorithm(profile, data.size(), target_throughput, num_threads);
+        for (const std::string &reason: choice.reasons) {
+            std::cout << "Reason: " << reason << std::endl;
+        }
+        std::cout << "Expected throughput: " << choice.expected_throughput << " MB/s" << std::endl;
+        if (choice.block_size > 0) {
+            run_algo("lzdr", "trie", data, check_decompressed_equals_input, output_path, nullptr, choice.block_size, num_threads);
+        } else {
+            compress(choice.level, data, check_decompressed_equals_input, output_path, time_budget_seconds);
+        }
+    }
+
+    void batch(const char* path, const int level, const bool check_decompressed_equals_input, const double time_budget_seconds,
+               const double time_budget_per_mb, const size_t num_threads) {
+        const std::vector<std::string> input_paths = batch_input_paths(path);
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<BatchFileResult> results = compress_batch(input_paths, level, check_decompressed_equals_input,
+                                                                    time_budget_seconds, time_budget_per_mb, num_threads);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        // Manifest: one line per file with input size, compressed size and number of factors (or the error)
+        size_t num_failed = 0;
+        size_t total_input_size = 0;
+        size_t total_compressed_size = 0;
+        for (const BatchFileResult &result: results) {
+            if (!result.error.empty()) {
+                std::cout << result.input_path << "\tError: " << result.error << '\n';
+                ++num_failed;
+                continue;
+            }
+            std::cout << result.input_path << '\t' << result.input_size << '\t' << result.compressed_size << '\t'
+                      << result.num_factors << '\n';
+            total_input_size += result.input_size;
+            total_compressed_size += result.compressed_size;
+        }
+        std::cout << "Level " << level << ": " << compression_level(level).name << std::endl;
+        std::cout << "Files: " << results.size() - num_failed << " compressed, " << num_failed << " failed" << std::endl;
+        std::cout << "Bytes: " << total_input_size << " -> " << total_compressed_size << std::endl;
+        std::cout << "Time: " << elapsed.count() << " s" << std::endl;
+        if (num_failed > 0) {
+            std::exit(1);
+        }
+    }
+
+    void estimate(const char* path, const int level, const size_t num_samples, const size_t sample_size, const size_t max_prefix,
+                  const size_t num_threads) {
+        const auto start = std::chrono::steady_clock::now();
+        const FactorEstimate estimate = estimate_factors(path, level, num_samples, sample_size, max_prefix, num_threads);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "Level " << level << ": " << compression_level(level).name << std::endl;
+        if (estimate.num_samples == 0) {
+            std::cout << "Input of " << estimate.input_size << " bytes compressed as a whole (exact)" << std::endl;
+        } else {
+            std::cout << "Samples: " << estimate.num_samples << " of " << estimate.sample_size << " bytes, factor growth exponent: "
+                      << estimate.growth_exponent << std::endl;
+        }
+        std::cout << "Factors per MiB: " << estimate.factors_per_mb << " (95%: " << estimate.factors_per_mb_low << " - "
+                  << estimate.factors_per_mb_high << ")" << std::endl;
+        std::cout << "Num factors: " << static_cast<uint64_t>(estimate.factors()) << " (95%: " << static_cast<uint64_t>(estimate.factors_low())
+                  << " - " << static_cast<uint64_t>(estimate.factors_high()) << ")" << std::endl;
+        std::cout << "Compressed size: " << static_cast<uint64_t>(estimate.compressed_size()) << " bytes" << std::endl;
+        std::cout << "Time: " << elapsed.count() << " s" << std::endl;
+    }
+
+    void train(const std::vector<uint8_t> &corpus, const char* output_path) {
+        if (output_path == nullptr) {
+            std::cout << "No output file provided, pass -o <FILE>." << std::endl;
+            std::exit(1);
+        }
+        write_file(output_path, LzdrDictionary::train(Slice(corpus)));
+    }
+
+    // The header of data compressed with a dictionary identifies the dictionary, --dict has to match it
+    void require_dictionary(const std::vector<uint8_t> &compressed, const LzdrDictionary *dictionary) {
+        try {
+            check_dictionary_data_header(compressed, dictionary);
+        } catch (const std::runtime_error &error) {
+            std::cout << error.what() << (dictionary == nullptr ? ", pass it with --dict." : ".") << std::endl;
+            std::exit(1);
+        }
+    }
+
+    void decompress(const std::vector<uint8_t> &compressed, const char* dict_path, const size_t num_threads, const size_t symbol_width) {
+        std::vector<uint8_t> decompressed;
+        const bool wide_symbols = symbol_width != 1 || is_lzdr_symbols(compressed);
+        if (wide_symbols && dict_path != nullptr) {
+            std::cout << "A dictionary is not supported with --symbol-width." << std::endl;
+            std::exit(1);
+        }
+        try {
+            if (wide_symbols) {
+                // The symbol width is stored in the compressed data, --symbol-width only has to match it
+                size_t stored_symbol_width = 0;
+                try {
+                    stored_symbol_width = lzdr_symbol_width(compressed);
+                } catch (const std::runtime_error &error) {
+                    std::cout << error.what() << "." << std::endl;
+                    std::exit(1);
+                }
+                if (symbol_width != 1 && symbol_width != stored_symbol_width) {
+                    std::cout << "The data was compressed with --symbol-width " << stored_symbol_width << ", not " << symbol_width << "." << std::endl;
+                    std::exit(1);
+                }
+                if (stored_symbol_width == 2) {
+                    decompressed = symbols_to_bytes(lzdr_decompress_symbols<uint16_t>(compressed));
+                } else {
+                    decompressed = symbols_to_bytes(lzdr_decompress_symbols<uint32_t>(compressed));
+                }
+            } else if (is_lzw(compressed)) {
+                // Written block by block, so only the dictionary and one block are kept in memory
+                LzwDecoder decoder;
+                for (size_t offset = 0; offset < compressed.size(); offset += PIPELINE_OUTPUT_BLOCK_SIZE) {
+                    const Slice compressed_block = Slice(compressed).slice(offset, std::min(PIPELINE_OUTPUT_BLOCK_SIZE, compressed.size() - offset));
+                    decoder.decode(compressed_block, decompressed);
+                    std::cout.write(reinterpret_cast<const char *>(decompressed.data()), static_cast<std::streamsize>(decompressed.size()));
+                    decompressed.clear();
+                }
+                decoder.finish();
+            } else if (is_lzdr_blocks(compressed)) {
+                decompressed = lzdr_blocks_decompress(compressed, num_threads);
+            } else if (dict_path != nullptr) {
+                const LzdrDictionary dictionary = LzdrDictionary::open(dict_path);
+                require_dictionary(compressed, &dictionary);
+                decompressed = lzdr_decompress(compressed, &dictionary);
+            } else if (is_lzdr_dictionary_data(compressed)) {
+                require_dictionary(compressed, nullptr);
+            } else {
+                decompressed = lzdr_decompress(compressed);
+            }
+            std::cout.write(reinterpret_cast<const char *>(decompressed.data()), static_cast<std::streamsize>(decompressed.size()));
+            std::cout.flush();
+        } catch (const std::exception &error) {
+            // Malformed compressed data (std::out_of_range) and I/O errors of the dictionary (std::runtime_error)
+            std::cerr << error.what() << std::endl;
+            std::exit(1);
+        }
+    }
+
+    void extract(const char* range, const std::vector<uint8_t> &compressed) {
+        char *range_end = nullptr;
+        const uint64_t from = strtoull(range, &range_end, 10);
+        if (*range_end != ':') {
+            std::cout << "Invalid range \"" << range << "\", expected <FROM>:<TO>." << std::endl;
+            std::exit(1);
+        }
+        const char *to_str = range_end + 1;
+        const uint64_t to = strtoull(to_str, &range_end, 10);
+        if (*to_str == '\0' || *range_end != '\0' || from > to) {
+            std::cout << "Invalid range \"" << range << "\", expected <FROM>:<TO>." << std::endl;
+            std::exit(1);
+        }
+
+        if (is_lzdr_dictionary_data(compressed)) {
+            std::cout << "--extract does not support data compressed with a dictionary." << std::endl;
+            std::exit(1);
+        }
+        try {
+            const LzdrRandomAccess random_access{Slice(compressed)};
+            if (from > random_access.size()) {
+                std::cout << "Invalid range \"" << range << "\", the decompressed data has only " << random_access.size() << " bytes." << std::endl;
+                std::exit(1);
+            }
+            const std::vector<uint8_t> extracted = random_access.extract(from, std::min(to, random_access.size()));
+            std::cout.write(reinterpret_cast<const char *>(extracted.data()), static_cast<std::streamsize>(extracted.size()));
+            std::cout.flush();
+        } catch (const std::exception &error) {
+            // Malformed compressed data (std::out_of_range)
+            std::cerr << error.what() << std::endl;
+            std::exit(1);
+        }
+    }
+
+    void grep(const char* pattern, const std::vector<uint8_t> &compressed) {
+        if (*pattern == '\0') {
+            std::cout << "The pattern must not be empty." << std::endl;
+            std::exit(1);
+        }
+        if (is_lzdr_dictionary_data(compressed)) {
+            std::cout << "--grep does not support data compressed with a dictionary." << std::endl;
+            std::exit(1);
+        }
+        try {
+            const LzdrRandomAccess random_access{Slice(compressed)};
+            const LzdrPatternSearch search(random_access, Slice(pattern));
+            for (const uint64_t position: search.find_all()) {
+                std::cout << position << '\n';
+            }
+            std::cout.flush();
+        } catch (const std::exception &error) {
+            // Malformed compressed data (std::out_of_range)
+            std::cerr << error.what() << std::endl;
+            std::exit(1);
+        }
+    }
+
+    void print_factors(const std::vector<uint8_t> &data, const bool check_decompressed_equals_input, const double time_budget_seconds) {
         std::cout << "LZDR (radix trie)" << std::endl;
         const size_t lzdr_linear_time_num_factors = lzdr_linear_time(Slice(data), check_decompressed_equals_input);
         std::cout << "Num factors: " << lzdr_linear_time_num_factors << std::endl;
@@ -56,13 +516,13 @@ namespace {
         std::cout << std::endl;
 
         std::cout << "Standard Flexible LZDR (radix trie)" << std::endl;
-        const size_t std_flexible_lzdr_radix_trie_num_factors = std_flexible_lzdr_radix_trie(Slice(data), check_decompressed_equals_input);
+        const size_t std_flexible_lzdr_radix_trie_num_factors = std_flexible_lzdr_radix_trie(Slice(data), check_decompressed_equals_input, time_budget_seconds);
         std::cout << "Num factors: " << std_flexible_lzdr_radix_trie_num_factors << std::endl;
 
         std::cout << std::endl;
 
         std::cout << "Alternative Flexible LZDR (radix trie)" << std::endl;
-        const size_t flexible_lzdr_radix_trie_num_factors = flexible_lzdr_radix_trie(Slice(data), check_decompressed_equals_input);
+        const size_t flexible_lzdr_radix_trie_num_factors = flexible_lzdr_radix_trie(Slice(data), check_decompressed_equals_input, nullptr, 0, time_budget_seconds);
         std::cout << "Num factors: " << flexible_lzdr_radix_trie_num_factors << std::endl;
 
         std::cout << std::endl;
@@ -85,6 +545,13 @@ namespace {
 
         std::cout << std::endl;
 
+        // With the largest dictionary, as the naive LZW variants never reset theirs
+        std::cout << "LZW (trie)" << std::endl;
+        const size_t lzw_num_factors = lzw_compress(Slice(data), check_decompressed_equals_input, nullptr, LZW_MAX_CODE_BITS);
+        std::cout << "Num factors: " << lzw_num_factors << std::endl;
+
+        std::cout << std::endl;
+
         std::cout << "Standard Flexible LZW (naive)" << std::endl;
         const size_t std_flexible_lzw_naive_num_factors = std_flexible_lzw_naive(Slice(data));
         std::cout << "Num factors: " << std_flexible_lzw_naive_num_factors << std::endl;
@@ -105,12 +572,196 @@ void parse_args(const int argc, char *argv[]) {
             break;
         }
     }
+    const char* engine = "trie";
+    const char* output_path = nullptr;
+    const char* dict_path = nullptr;
+    double time_budget_seconds = 0;
+    double time_budget_per_mb = 0;
+    const char* batch_path = nullptr;
+    size_t block_size = 0;
+    const char* estimate_path = nullptr;
+    size_t num_samples = 16;
+    size_t sample_size = 256 * 1024;
+    size_t max_prefix = 4 * 1024 * 1024;
+    double target_throughput = 0;
+    size_t symbol_width = 1;
+    bool small_alphabet = false;
+    unsigned lzw_max_code_bits = LZW_DEFAULT_MAX_CODE_BITS;
+    int level = 2;
+    size_t num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 >= argc) {
+                std::cout << "No output file provided." << std::endl;
+                std::exit(1);
+            }
+            output_path = argv[i + 1];
+        }
+        if (strcmp(argv[i], "--dict") == 0) {
+            if (i + 1 >= argc) {
+                std::cout << "No dictionary file provided." << std::endl;
+                std::exit(1);
+            }
+            dict_path = argv[i + 1];
+        }
+        if (strcmp(argv[i], "--time-budget") == 0 || strcmp(argv[i], "--time-budget-per-mb") == 0) {
+            char *seconds_end = nullptr;
+            const double seconds = i + 1 < argc ? strtod(argv[i + 1], &seconds_end) : 0;
+            if (i + 1 >= argc || *seconds_end != '\0' || !(seconds > 0)) {
+                std::cout << "No valid time budget in seconds provided." << std::endl;
+                std::exit(1);
+            }
+            if (strcmp(argv[i], "--time-budget") == 0) {
+                time_budget_seconds = seconds;
+            } else {
+                time_budget_per_mb = seconds;
+            }
+        }
+        if (strcmp(argv[i], "--throughput") == 0) {
+            char *throughput_end = nullptr;
+            const double throughput = i + 1 < argc ? strtod(argv[i + 1], &throughput_end) : 0;
+            if (i + 1 >= argc || *throughput_end != '\0' || !(throughput > 0)) {
+                std::cout << "No valid throughput in MB/s provided." << std::endl;
+                std::exit(1);
+            }
+            target_throughput = throughput;
+        }
+        if (strcmp(argv[i], "--batch") == 0) {
+            if (i + 1 >= argc) {
+                std::cout << "No file list or directory provided." << std::endl;
+                std::exit(1);
+            }
+            batch_path = argv[i + 1];
+        }
+        if (strcmp(argv[i], "--estimate") == 0) {
+            if (i + 1 >= argc) {
+                std::cout << "No input file provided." << std::endl;
+                std::exit(1);
+            }
+            estimate_path = argv[i + 1];
+        }
+        if (strcmp(argv[i], "--samples") == 0 || strcmp(argv[i], "--sample-size") == 0 || strcmp(argv[i], "--prefix") == 0) {
+            char *value_end = nullptr;
+            const unsigned long long value = i + 1 < argc ? strtoull(argv[i + 1], &value_end, 10) : 0;
+            // Only the prefix can be 0 (no fitted growth)
+            if (i + 1 >= argc || *value_end != '\0' || (value == 0 && strcmp(argv[i], "--prefix") != 0)) {
+                std::cout << "No valid number provided for " << argv[i] << "." << std::endl;
+                std::exit(1);
+            }
+            if (strcmp(argv[i], "--samples") == 0) {
+                num_samples = value;
+            } else if (strcmp(argv[i], "--sample-size") == 0) {
+                sample_size = value;
+            } else {
+                max_prefix = value;
+            }
+        }
+        if (strcmp(argv[i], "--blocks") == 0) {
+            char *block_size_end = nullptr;
+            const unsigned long long size = i + 1 < argc ? strtoull(argv[i + 1], &block_size_end, 10) : 0;
+            if (i + 1 >= argc || *block_size_end != '\0' || size == 0) {
+                std::cout << "No valid block size provided." << std::endl;
+                std::exit(1);
+            }
+            block_size = size;
+        }
+        if (strcmp(argv[i], "--symbol-width") == 0) {
+            if (i + 1 >= argc || (strcmp(argv[i + 1], "1") != 0 && strcmp(argv[i + 1], "2") != 0 && strcmp(argv[i + 1], "4") != 0)) {
+                std::cout << "No valid symbol width (1, 2 or 4) provided." << std::endl;
+                std::exit(1);
+            }
+            symbol_width = argv[i + 1][0] - '0';
+        }
+        if (strcmp(argv[i], "--lzw-max-bits") == 0) {
+            char *bits_end = nullptr;
+            const unsigned long bits = i + 1 < argc ? strtoul(argv[i + 1], &bits_end, 10) : 0;
+            if (i + 1 >= argc || *bits_end != '\0' || bits < LZW_MIN_CODE_BITS || bits > LZW_MAX_CODE_BITS) {
+                std::cout << "No valid maximum LZW code width (" << LZW_MIN_CODE_BITS << " to " << LZW_MAX_CODE_BITS << " bits) provided." << std::endl;
+                std::exit(1);
+            }
+            lzw_max_code_bits = bits;
+        }
+        if (strcmp(argv[i], "--small-alphabet") == 0) {
+            small_alphabet = true;
+        }
+        if (strcmp(argv[i], "--threads") == 0) {
+            char *threads_end = nullptr;
+            const unsigned long threads = i + 1 < argc ? strtoul(argv[i + 1], &threads_end, 10) : 0;
+            if (i + 1 >= argc || *threads_end != '\0' || threads == 0) {
+                std::cout << "No valid number of threads provided." << std::endl;
+                std::exit(1);
+            }
+            num_threads = threads;
+        }
+        if (argv[i][0] == '-' && argv[i][1] >= '0' + MIN_COMPRESSION_LEVEL && argv[i][1] <= '0' + MAX_COMPRESSION_LEVEL && argv[i][2] == '\0') {
+            level = argv[i][1] - '0';
+        }
+        if (strncmp(argv[i], "--engine=", 9) == 0) {
+            engine = argv[i] + 9;
+            if (strcmp(engine, "trie") != 0 && strcmp(engine, "st") != 0) {
+                std::cout << "The engine \"" << engine << "\" is not implemented right now." << std::endl;
+                std::exit(1);
+            }
+        }
+    }
+    if (estimate_path != nullptr) {
+        // Takes precedence, because -<LEVEL> is the level of the estimate then
+        require_byte_symbols(symbol_width);
+        estimate(estimate_path, level, num_samples, sample_size, max_prefix, num_threads);
+        return;
+    }
+    if (batch_path != nullptr) {
+        // Takes precedence, because -<LEVEL> is the level of the batch then
+        require_byte_symbols(symbol_width);
+        batch(batch_path, level, check_decompressed_equals_input, time_budget_seconds, time_budget_per_mb, num_threads);
+        return;
+    }
     bool cmd_found = false;
     for (int i = 0; i < argc; ++i) {
         if (strcmp(argv[i], "-a") == 0) {
+            if (i + 1 < argc && strcmp(engine, "trie") != 0 && strcmp(argv[i+1], "lzdr") != 0) {
+                std::cout << "The engine \"" << engine << "\" is only supported for -a lzdr." << std::endl;
+                std::exit(1);
+            }
+            if (i + 1 < argc && strcmp(argv[i+1], "auto") == 0) {
+                require_byte_symbols(symbol_width);
+                if (dict_path != nullptr || block_size > 0) {
+                    std::cout << "-a auto chooses the blocks itself and does not support a dictionary." << std::endl;
+                    std::exit(1);
+                }
+                const std::vector<uint8_t> data = read_stdin();
+                auto_compress(data, check_decompressed_equals_input, output_path, sample_size, target_throughput, num_threads,
+                              time_budget(data.size(), time_budget_seconds, time_budget_per_mb));
+                cmd_found = true;
+                break;
+            }
+            // Reading and writing overlap with the factorization if the size of the input is known
+            if (i + 1 < argc && symbol_width != 1) {
+                if (strcmp(engine, "trie") != 0 || dict_path != nullptr || block_size > 0 || small_alphabet) {
+                    std::cout << "--symbol-width is only supported with the trie engine and without a dictionary, blocks or --small-alphabet." << std::endl;
+                    std::exit(1);
+                }
+                const std::vector<uint8_t> data = read_stdin();
+                if (symbol_width == 2) {
+                    run_symbol_algo<uint16_t>(argv[i+1], data, check_decompressed_equals_input, output_path);
+                } else {
+                    run_symbol_algo<uint32_t>(argv[i+1], data, check_decompressed_equals_input, output_path);
+                }
+                cmd_found = true;
+                break;
+            }
+            if (const size_t input_size = stdin_file_size();
+                i + 1 < argc && strcmp(argv[i+1], "lzdr") == 0 && strcmp(engine, "trie") == 0 && dict_path == nullptr && block_size == 0 &&
+                !small_alphabet && input_size > 0) {
+                std::cout << "LZDR (radix trie)" << std::endl;
+                pipelined_lzdr(input_size, check_decompressed_equals_input, output_path);
+                cmd_found = true;
+                break;
+            }
             if (i + 1 < argc) {
                 const std::vector<uint8_t> data = read_stdin();
-                run_algo(argv[i+1], data, check_decompressed_equals_input);
+                run_algo(argv[i+1], engine, data, check_decompressed_equals_input, output_path, dict_path, block_size, num_threads,
+                         small_alphabet, lzw_max_code_bits);
                 cmd_found = true;
                 break;
             } else {
@@ -118,19 +769,95 @@ void parse_args(const int argc, char *argv[]) {
                 std::exit(1);
             }
         }
+        if (argv[i][0] == '-' && argv[i][1] >= '0' + MIN_COMPRESSION_LEVEL && argv[i][1] <= '0' + MAX_COMPRESSION_LEVEL && argv[i][2] == '\0') {
+            require_byte_symbols(symbol_width);
+            if (strcmp(engine, "trie") != 0 || dict_path != nullptr || block_size > 0 || small_alphabet) {
+                std::cout << "The levels are only supported with the trie engine and without a dictionary, blocks or --small-alphabet." << std::endl;
+                std::exit(1);
+            }
+            if (const size_t input_size = stdin_file_size();
+                compression_level(argv[i][1] - '0').algorithm == CompressionLevel::Algorithm::LZDR && input_size > 0) {
+                std::cout << "Level " << argv[i][1] << ": " << compression_level(argv[i][1] - '0').name << std::endl;
+                pipelined_lzdr(input_size, check_decompressed_equals_input, output_path);
+                cmd_found = true;
+                break;
+            }
+            const std::vector<uint8_t> data = read_stdin();
+            compress(argv[i][1] - '0', data, check_decompressed_equals_input, output_path,
+                     time_budget(data.size(), time_budget_seconds, time_budget_per_mb));
+            cmd_found = true;
+            break;
+        }
+        if (strcmp(argv[i], "--train") == 0) {
+            require_byte_symbols(symbol_width);
+            const std::vector<uint8_t> corpus = read_stdin();
+            train(corpus, output_path);
+            cmd_found = true;
+            break;
+        }
+        if (strcmp(argv[i], "--append") == 0) {
+            require_byte_symbols(symbol_width);
+            if (i + 1 < argc) {
+                const std::vector<uint8_t> data = read_stdin();
+                std::cout << "LZDR (radix trie, append)" << std::endl;
+                const size_t lzdr_append_num_factors = lzdr_append(argv[i+1], Slice(data));
+                std::cout << "Num factors: " << lzdr_append_num_factors << std::endl;
+                cmd_found = true;
+                break;
+            } else {
+                std::cout << "No compressed file provided." << std::endl;
+                std::exit(1);
+            }
+        }
+        if (strcmp(argv[i], "--decompress") == 0) {
+            const std::vector<uint8_t> compressed = read_stdin();
+            decompress(compressed, dict_path, num_threads, symbol_width);
+            cmd_found = true;
+            break;
+        }
+        if (strcmp(argv[i], "--extract") == 0) {
+            require_byte_symbols(symbol_width);
+            if (i + 1 < argc) {
+                const std::vector<uint8_t> compressed = read_stdin();
+                extract(argv[i+1], compressed);
+                cmd_found = true;
+                break;
+            } else {
+                std::cout << "No range provided." << std::endl;
+                std::exit(1);
+            }
+        }
+        if (strcmp(argv[i], "--grep") == 0) {
+            require_byte_symbols(symbol_width);
+            if (i + 1 < argc) {
+                const std::vector<uint8_t> compressed = read_stdin();
+                grep(argv[i+1], compressed);
+                cmd_found = true;
+                break;
+            } else {
+                std::cout << "No pattern provided." << std::endl;
+                std::exit(1);
+            }
+        }
         if (strcmp(argv[i], "--help") == 0) {
             print_help();
             cmd_found = true;
             break;
         }
+        if (strcmp(argv[i], "--bench-kernels") == 0) {
+            run_kernel_benchmark();
+            cmd_found = true;
+            break;
+        }
         if (strcmp(argv[i], "--test") == 0) {
             run_tests();
             cmd_found = true;
             break;
         }
         if (strcmp(argv[i], "--factors") == 0) {
+            require_byte_symbols(symbol_width);
             const std::vector<uint8_t> data = read_stdin();
-            print_factors(data, check_decompressed_equals_input);
+            print_factors(data, check_decompressed_equals_input, time_budget(data.size(), time_budget_seconds, time_budget_per_mb));
             cmd_found = true;
             break;
         }
@@ -0,0 +1,52 @@
+#include "compression_level.h"
+#include "flexible_lzdr_radix_trie.h"
+#include "lzd_plus_linear_time.h"
+#include "lzdr_linear_time.h"
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // Index 0 is level 1.
+    // The throughput targets are met by a release build on the concatenation of all Calgary and Canterbury files
+    // (about 6 MB, the best of 3 runs rounded down; 4 to 6 candidates are within the noise of each other). Testing all candidate lengths is quadratic in the factor length, so even level 9 has a cap.
+    // More candidates do not always give fewer factors (8 and 24 give more than 6 and 16 on that corpus),
+    // so the candidate counts are chosen to make the number of factors decrease from level to level.
+    constexpr CompressionLevel COMPRESSION_LEVELS[] = {
+        {CompressionLevel::Algorithm::LZD_PLUS, 0, "LZD+", 7},
+        {CompressionLevel::Algorithm::LZDR, 0, "LZDR", 5.4},
+        {CompressionLevel::Algorithm::FLEXIBLE_LZDR, 2, "Flexible LZDR (2 candidates)", 1.7},
+        {CompressionLevel::Algorithm::FLEXIBLE_LZDR, 3, "Flexible LZDR (3 candidates)", 1.1},
+        {CompressionLevel::Algorithm::FLEXIBLE_LZDR, 4, "Flexible LZDR (4 candidates)", 1},
+        {CompressionLevel::Algorithm::FLEXIBLE_LZDR, 5, "Flexible LZDR (5 candidates)", 0.95},
+        {CompressionLevel::Algorithm::FLEXIBLE_LZDR, 6, "Flexible LZDR (6 candidates)", 0.9},
+        {CompressionLevel::Algorithm::FLEXIBLE_LZDR, 16, "Flexible LZDR (16 candidates)", 0.7},
+        {CompressionLevel::Algorithm::FLEXIBLE_LZDR, 32, "Flexible LZDR (32 candidates)", 0.5},
+    };
+}
+
+const CompressionLevel &compression_level(const int level) {
+    if (level < MIN_COMPRESSION_LEVEL || level > MAX_COMPRESSION_LEVEL) {
+        throw std::out_of_range("Invalid compression level");
+    }
+    return COMPRESSION_LEVELS[level - MIN_COMPRESSION_LEVEL];
+}
+
+size_t compress_with_level(const int level, const Slice input, const bool check_decompressed_equals_input,
+                           std::vector<uint8_t> *compressed_output, const double time_budget_seconds, std::ostream &stats) {
+    const CompressionLevel &settings = compression_level(level);
+    switch (settings.algorithm) {
+        case CompressionLevel::Algorithm::LZD_PLUS:
+            return lzd_plus_linear_time(input, check_decompressed_equals_input, compressed_output, stats);
+        case CompressionLevel::Algorithm::LZDR:
+            return lzdr_linear_time(input, check_decompressed_equals_input, compressed_output, stats);
+        case CompressionLevel::Algorithm::FLEXIBLE_LZDR:
+            return flexible_lzdr_radix_trie(input, check_decompressed_equals_input, compressed_output, settings.max_candidates,
+                                            time_budget_seconds, stats);
+    }
+    throw std::out_of_range("Invalid compression level");
+}
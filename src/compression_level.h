@@ -0,0 +1,43 @@
+#ifndef COMPRESSION_LEVEL_H
+#define COMPRESSION_LEVEL_H
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// Compression levels 1 (fastest) to 9 (fewest factors), mapped onto the existing algorithms.
+// All levels produce LZDR compressed data (LZD+ is a subset of it), so they are decompressed the same way.
+struct CompressionLevel {
+    enum class Algorithm {
+        LZD_PLUS,
+        LZDR,
+        FLEXIBLE_LZDR,
+    };
+
+    Algorithm algorithm;
+    // Only used for FLEXIBLE_LZDR: the number of longest factor lengths tested at each position (0 = all)
+    size_t max_candidates;
+    const char* name;
+    // Throughput target in MB/s on the Calgary and Canterbury corpora (release build, single thread).
+    // -a auto scales the measured LZDR throughput of the input by the ratio to level 2, so the targets have to be
+    // measured together and decrease from level to level
+    double throughput_target;
+};
+
+constexpr int MIN_COMPRESSION_LEVEL = 1;
+constexpr int MAX_COMPRESSION_LEVEL = 9;
+
+// Throws std::out_of_range if the level is not between MIN_COMPRESSION_LEVEL and MAX_COMPRESSION_LEVEL
+const CompressionLevel &compression_level(int level);
+
+// If compressed_output is not null, the compressed data is appended to it.
+// time_budget_seconds is only used by the Flexible LZDR levels (0 means no budget).
+// The stats are printed to stats (std::ostream(nullptr) prints nothing, e.g. on worker threads).
+// Returns the number of factors
+size_t compress_with_level(int level, Slice input, bool check_decompressed_equals_input,
+                           std::vector<uint8_t> *compressed_output = nullptr, double time_budget_seconds = 0,
+                           std::ostream &stats = std::cout);
+
+#endif //COMPRESSION_LEVEL_H
@@ -17,3 +17,22 @@ uint32_t u32_from_bytes(const uint8_t *bytes) {
     value |= static_cast<uint32_t>(bytes[3]) << 24;
     return value;
 }
+
+void u64_to_bytes(const uint64_t value, uint8_t *bytes) {
+    u32_to_bytes(static_cast<uint32_t>(value & 0xFFFFFFFF), bytes);
+    u32_to_bytes(static_cast<uint32_t>(value >> 32), bytes + 4);
+}
+
+uint64_t u64_from_bytes(const uint8_t *bytes) {
+    uint64_t value = 0;
+    value |= static_cast<uint64_t>(u32_from_bytes(bytes));
+    value |= static_cast<uint64_t>(u32_from_bytes(bytes + 4)) << 32;
+    return value;
+}
+
+uint64_t uint_from_bytes(const uint8_t *bytes, const bool wide) {
+    if (wide) {
+        return u64_from_bytes(bytes);
+    }
+    return u32_from_bytes(bytes);
+}
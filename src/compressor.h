@@ -13,6 +13,27 @@ void u32_to_bytes(uint32_t value, uint8_t *bytes);
 
 uint32_t u32_from_bytes(const uint8_t *bytes);
 
+void u64_to_bytes(uint64_t value, uint8_t *bytes);
+
+uint64_t u64_from_bytes(const uint8_t *bytes);
+
+// Reads a factor, length or repetition field of the narrow (uint32_t) or wide (uint64_t) format
+uint64_t uint_from_bytes(const uint8_t *bytes, bool wide);
+
+// Reads a symbol of symbol_width (1, 2 or 4) bytes (little-endian like the other fields)
+inline uint32_t symbol_from_bytes(const uint8_t *bytes, const size_t symbol_width) {
+    uint32_t symbol = 0;
+    for (size_t i = 0; i < symbol_width; ++i) {
+        symbol |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    }
+    return symbol;
+}
+
+// Returns true if the value does not fit into a field of the narrow format
+inline bool requires_wide_format(const uint64_t value) {
+    return value > UINT32_MAX;
+}
+
 class Compressor {
     std::vector<uint8_t> internal_data;
     size_t written_bytes;
@@ -40,6 +61,30 @@ public:
         u32_to_bytes(value, internal_data.data() + written_bytes);
         written_bytes += 4;
     }
+
+    void write_u64(const uint64_t value) {
+        if (written_bytes + 7 >= internal_data.size()) {
+            throw std::out_of_range("Index out of bounds");
+        }
+        u64_to_bytes(value, internal_data.data() + written_bytes);
+        written_bytes += 8;
+    }
+
+    // Writes a symbol of symbol_width (1, 2 or 4) bytes
+    void write_symbol(const uint32_t symbol, const size_t symbol_width) {
+        for (size_t i = 0; i < symbol_width; ++i) {
+            write_byte(static_cast<uint8_t>(symbol >> (8 * i)));
+        }
+    }
+
+    // Writes a factor, length or repetition field in the narrow or wide format
+    void write_uint(const uint64_t value, const bool wide) {
+        if (wide) {
+            write_u64(value);
+        } else {
+            write_u32(static_cast<uint32_t>(value));
+        }
+    }
 };
 
 struct NextFactorResult {
@@ -48,12 +93,15 @@ struct NextFactorResult {
     bool used_extra_truncation;
 };
 
-struct NextFactorResult2 {
-    Slice factor_slice;
+template<typename Symbol>
+struct BasicNextFactorResult2 {
+    BasicSlice<Symbol> factor_slice;
     std::vector<uint8_t> compressed_data;
     bool used_extra_truncation;
-    RadixTrieNode* insertion_node;
-    Slice insertion_slice;
+    BasicRadixTrieNode<Symbol>* insertion_node;
+    BasicSlice<Symbol> insertion_slice;
 };
 
+using NextFactorResult2 = BasicNextFactorResult2<uint8_t>;
+
 #endif //COMPRESSOR_H
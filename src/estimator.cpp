@@ -0,0 +1,178 @@
+#include "estimator.h"
+#include "compression_level.h"
+#include "slice.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+    // Two-sided 95% quantile of the normal distribution
+    constexpr double Z_95 = 1.96;
+    // The prefixes are at most this fraction of the input, so they take a fraction of the time of compressing it
+    constexpr uint64_t MAX_PREFIX_FRACTION = 8;
+
+    // Returns size bytes of the input starting at offset
+    using ReadFn = std::function<std::vector<uint8_t>(uint64_t, size_t)>;
+
+    struct SampleRun {
+        uint64_t offset;
+        size_t size;
+        size_t num_factors;
+        size_t compressed_size;
+    };
+
+    // Least squares slope of log(num_factors) over log(size)
+    double fit_growth_exponent(const std::vector<SampleRun> &prefixes) {
+        double mean_x = 0;
+        double mean_y = 0;
+        for (const SampleRun &prefix: prefixes) {
+            mean_x += std::log(static_cast<double>(prefix.size));
+            mean_y += std::log(static_cast<double>(prefix.num_factors));
+        }
+        mean_x /= static_cast<double>(prefixes.size());
+        mean_y /= static_cast<double>(prefixes.size());
+        double covariance = 0;
+        double variance = 0;
+        for (const SampleRun &prefix: prefixes) {
+            const double dx = std::log(static_cast<double>(prefix.size)) - mean_x;
+            covariance += dx * (std::log(static_cast<double>(prefix.num_factors)) - mean_y);
+            variance += dx * dx;
+        }
+        return covariance / variance;
+    }
+
+    FactorEstimate estimate(const uint64_t input_size, const ReadFn &read, const int level, const size_t num_samples,
+                            const size_t sample_size, const size_t max_prefix, const size_t num_workers) {
+        if (num_samples == 0 || sample_size == 0) {
+            throw std::out_of_range("Number of samples and sample size must be greater than 0");
+        }
+        // Check the level before starting any worker
+        compression_level(level);
+
+        std::vector<SampleRun> prefixes;
+        for (size_t prefix_size = sample_size; prefix_size <= max_prefix && prefix_size <= input_size / MAX_PREFIX_FRACTION;
+             prefix_size *= 2) {
+            prefixes.push_back({0, prefix_size, 0, 0});
+        }
+        if (prefixes.size() < 2) {
+            prefixes.clear();
+        }
+        // Compressing the input as a whole takes no longer than compressing as many bytes in samples and prefixes
+        uint64_t sampled_size = static_cast<uint64_t>(num_samples) * sample_size;
+        for (const SampleRun &prefix: prefixes) {
+            sampled_size += prefix.size;
+        }
+        const bool exact = sampled_size >= input_size;
+        std::vector<SampleRun> samples;
+        if (exact) {
+            prefixes.clear();
+            samples.push_back({0, static_cast<size_t>(input_size), 0, 0});
+        } else {
+            for (size_t i = 0; i < num_samples; ++i) {
+                const uint64_t offset = num_samples == 1 ? (input_size - sample_size) / 2 : (input_size - sample_size) * i / (num_samples - 1);
+                samples.push_back({offset, sample_size, 0, 0});
+            }
+        }
+
+        // Largest prefixes first, as they take the longest
+        std::vector<SampleRun *> runs;
+        for (auto it = prefixes.rbegin(); it != prefixes.rend(); ++it) {
+            runs.push_back(&*it);
+        }
+        for (SampleRun &sample: samples) {
+            runs.push_back(&sample);
+        }
+        run_work_stealing(num_workers, runs.size(), [&](const size_t task, size_t) {
+            SampleRun &run = *runs[task];
+            const std::vector<uint8_t> data = read(run.offset, run.size);
+            std::vector<uint8_t> compressed;
+            // The stats of the workers are dropped, they must not write to std::cout at the same time
+            std::ostream no_stats(nullptr);
+            run.num_factors = compress_with_level(level, Slice(data), false, &compressed, 0, no_stats);
+            run.compressed_size = compressed.size();
+        });
+
+        FactorEstimate result = {input_size, exact ? 0 : num_samples, exact ? static_cast<size_t>(input_size) : sample_size,
+                                 prefixes.empty() ? 1.0 : fit_growth_exponent(prefixes), 0, 0, 0, 0};
+        // Factors per byte of the samples
+        double mean = 0;
+        size_t total_factors = 0;
+        size_t total_compressed_size = 0;
+        for (const SampleRun &sample: samples) {
+            mean += static_cast<double>(sample.num_factors) / static_cast<double>(std::max<size_t>(sample.size, 1));
+            total_factors += sample.num_factors;
+            total_compressed_size += sample.compressed_size;
+        }
+        mean /= static_cast<double>(samples.size());
+        double variance = 0;
+        for (const SampleRun &sample: samples) {
+            const double d = static_cast<double>(sample.num_factors) / static_cast<double>(std::max<size_t>(sample.size, 1)) - mean;
+            variance += d * d;
+        }
+        const double standard_error = samples.size() > 1
+            ? std::sqrt(variance / static_cast<double>(samples.size() - 1) / static_cast<double>(samples.size()))
+            : 0;
+
+        const double scale = exact ? BYTES_PER_MB : BYTES_PER_MB * std::pow(static_cast<double>(input_size) / static_cast<double>(sample_size),
+                                                                           result.growth_exponent - 1);
+        result.factors_per_mb = mean * scale;
+        result.factors_per_mb_low = std::max(0.0, mean - Z_95 * standard_error) * scale;
+        result.factors_per_mb_high = (mean + Z_95 * standard_error) * scale;
+        result.compressed_bytes_per_factor = total_factors > 0 ? static_cast<double>(total_compressed_size) / static_cast<double>(total_factors) : 0;
+        return result;
+    }
+}
+
+double FactorEstimate::factors() const {
+    return factors_per_mb * static_cast<double>(input_size) / BYTES_PER_MB;
+}
+
+double FactorEstimate::factors_low() const {
+    return factors_per_mb_low * static_cast<double>(input_size) / BYTES_PER_MB;
+}
+
+double FactorEstimate::factors_high() const {
+    return factors_per_mb_high * static_cast<double>(input_size) / BYTES_PER_MB;
+}
+
+double FactorEstimate::compressed_size() const {
+    return factors() * compressed_bytes_per_factor;
+}
+
+FactorEstimate estimate_factors(const Slice input, const int level, const size_t num_samples, const size_t sample_size,
+                                const size_t max_prefix, const size_t num_workers) {
+    return estimate(input.size(), [input](const uint64_t offset, const size_t size) {
+        const Slice part = input.slice(static_cast<size_t>(offset), size);
+        return std::vector<uint8_t>(part.begin(), part.end());
+    }, level, num_samples, sample_size, max_prefix, num_workers);
+}
+
+FactorEstimate estimate_factors(const std::string &path, const int level, const size_t num_samples, const size_t sample_size,
+                                const size_t max_prefix, const size_t num_workers) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    const auto input_size = static_cast<uint64_t>(file.tellg());
+    // Every worker reads with its own stream
+    return estimate(input_size, [&path](const uint64_t offset, const size_t size) {
+        std::ifstream sample_file(path, std::ios::binary);
+        sample_file.seekg(static_cast<std::streamoff>(offset));
+        std::vector<uint8_t> data(size);
+        sample_file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(size));
+        if (!sample_file) {
+            throw std::runtime_error("I/O error while reading " + path);
+        }
+        return data;
+    }, level, num_samples, sample_size, max_prefix, num_workers);
+}
@@ -0,0 +1,52 @@
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Estimates the number of factors and the compressed size of an input from a factorization of samples.
+//
+// num_samples blocks of sample_size bytes, evenly spread over the input, are compressed with a compression level.
+// Their factors per byte are the estimate for an input of sample_size bytes. As the dictionary grows, the factors
+// get longer, so the estimate is scaled to the input size with the growth of the number of factors z(p) = a * p^b
+// fitted (least squares on log-log scale) on prefixes of sample_size, 2 * sample_size, ... up to max_prefix bytes
+// and an eighth of the input.
+// Without at least two prefixes, b is 1 (no scaling), which overestimates the factors of large inputs.
+// The bounds are the 95% confidence interval of the mean over the samples, so they only cover the sampling error
+// and not the error of the fitted growth.
+// If the samples and prefixes would be at least as many bytes as the input, the input is compressed as a whole
+// and the estimate is exact.
+struct FactorEstimate {
+    uint64_t input_size;
+    // 0 if the estimate is exact
+    size_t num_samples;
+    size_t sample_size;
+    // The exponent b of the fitted growth (1 if not fitted)
+    double growth_exponent;
+    double factors_per_mb;
+    double factors_per_mb_low;
+    double factors_per_mb_high;
+    double compressed_bytes_per_factor;
+
+    [[nodiscard]] double factors() const;
+
+    [[nodiscard]] double factors_low() const;
+
+    [[nodiscard]] double factors_high() const;
+
+    [[nodiscard]] double compressed_size() const;
+};
+
+// The samples and prefixes are compressed in parallel on num_workers threads.
+// Throws std::out_of_range if num_samples or sample_size is 0
+FactorEstimate estimate_factors(Slice input, int level, size_t num_samples, size_t sample_size, size_t max_prefix,
+                                size_t num_workers);
+
+// Same as above, but reads only the samples and prefixes from the file at path.
+// Throws std::runtime_error if the file cannot be read
+FactorEstimate estimate_factors(const std::string &path, int level, size_t num_samples, size_t sample_size, size_t max_prefix,
+                                size_t num_workers);
+
+#endif //ESTIMATOR_H
@@ -0,0 +1,91 @@
+#include "factor_search.h"
+#include "compressor.h"
+#include "lzdr_linear_time.h"
+#include "slice.h"
+#include "small_alphabet.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace factor_search {
+    template<typename Symbol>
+    BasicNextFactorResult2<Symbol> combination_factor_to_result(const BasicSlice<Symbol> &rest_input, const BasicCombinationFactor<Symbol> &factor) {
+        const bool wide = requires_wide_format(std::max({factor.first_factor, factor.second_factor, factor.length}));
+        Compressor compressor = lzdr_compressor::create_compressor_for_combination(factor.first_is_byte, factor.second_is_byte, wide, sizeof(Symbol));
+        if (factor.first_is_byte) {
+            compressor.write_symbol(static_cast<Symbol>(factor.first_factor), sizeof(Symbol));
+        } else {
+            compressor.write_uint(factor.first_factor, wide);
+        }
+        if (factor.second_is_byte) {
+            compressor.write_symbol(static_cast<Symbol>(factor.second_factor), sizeof(Symbol));
+        } else {
+            compressor.write_uint(factor.second_factor, wide);
+        }
+        compressor.write_uint(factor.length, wide);
+        const BasicSlice<Symbol> insertion_slice = rest_input.slice(factor.first_node_length, factor.length - factor.first_node_length);
+        return BasicNextFactorResult2<Symbol>{rest_input.slice(0, factor.length), std::move(compressor.data()), factor.used_extra_truncation, factor.insertion_node, insertion_slice};
+    }
+
+    template<typename Symbol>
+    BasicNextFactorResult2<Symbol> truncation_factor_to_result(const BasicSlice<Symbol> &rest_input, const BasicTruncationFactor<Symbol> &factor) {
+        const bool wide = requires_wide_format(std::max(factor.factor_index, factor.length));
+        Compressor compressor = lzdr_compressor::create_compressor_for_truncation(wide);
+        compressor.write_uint(factor.factor_index, wide);
+        compressor.write_uint(factor.length, wide);
+        const BasicSlice<Symbol> insertion_slice = rest_input.slice(factor.last_node_length, factor.length - factor.last_node_length);
+        return BasicNextFactorResult2<Symbol>{rest_input.slice(0, factor.length), std::move(compressor.data()), false, factor.insertion_node, insertion_slice};
+    }
+
+    template<typename Symbol>
+    BasicNextFactorResult2<Symbol> repetition_factor_to_result(const BasicSlice<Symbol> &rest_input, const BasicRepetitionFactor<Symbol> &factor) {
+        const bool wide = requires_wide_format(std::max(factor.factor, factor.total_length));
+        Compressor compressor = lzdr_compressor::create_compressor_for_repetition(factor.factor_is_byte, wide, sizeof(Symbol));
+        if (factor.factor_is_byte) {
+            compressor.write_symbol(static_cast<Symbol>(factor.factor), sizeof(Symbol));
+        } else {
+            compressor.write_uint(factor.factor, wide);
+        }
+        compressor.write_uint(factor.total_length, wide);
+        const bool used_extra_truncation = factor.total_length % factor.factor_length != 0;
+        const BasicSlice<Symbol> insertion_slice = factor.factor_is_byte ? rest_input.slice(0, factor.total_length) : rest_input.slice(factor.factor_length, factor.total_length - factor.factor_length);
+        BasicNextFactorResult2<Symbol> result = {rest_input.slice(0, factor.total_length), std::move(compressor.data()), used_extra_truncation, factor.insertion_node, insertion_slice};
+        return result;
+    }
+
+    template NextFactorResult2 combination_factor_to_result(const Slice &, const CombinationFactor &);
+    template NextFactorResult2 truncation_factor_to_result(const Slice &, const TruncationFactor &);
+    template NextFactorResult2 repetition_factor_to_result(const Slice &, const RepetitionFactor &);
+    template BasicNextFactorResult2<uint16_t> combination_factor_to_result(const BasicSlice<uint16_t> &, const BasicCombinationFactor<uint16_t> &);
+    template BasicNextFactorResult2<uint16_t> truncation_factor_to_result(const BasicSlice<uint16_t> &, const BasicTruncationFactor<uint16_t> &);
+    template BasicNextFactorResult2<uint16_t> repetition_factor_to_result(const BasicSlice<uint16_t> &, const BasicRepetitionFactor<uint16_t> &);
+    template BasicNextFactorResult2<uint32_t> combination_factor_to_result(const BasicSlice<uint32_t> &, const BasicCombinationFactor<uint32_t> &);
+    template BasicNextFactorResult2<uint32_t> truncation_factor_to_result(const BasicSlice<uint32_t> &, const BasicTruncationFactor<uint32_t> &);
+    template BasicNextFactorResult2<uint32_t> repetition_factor_to_result(const BasicSlice<uint32_t> &, const BasicRepetitionFactor<uint32_t> &);
+    template BasicNextFactorResult2<RankSymbol<2> > combination_factor_to_result(const BasicSlice<RankSymbol<2> > &,
+                                                                             const BasicCombinationFactor<RankSymbol<2> > &);
+    template BasicNextFactorResult2<RankSymbol<2> > truncation_factor_to_result(const BasicSlice<RankSymbol<2> > &,
+                                                                             const BasicTruncationFactor<RankSymbol<2> > &);
+    template BasicNextFactorResult2<RankSymbol<2> > repetition_factor_to_result(const BasicSlice<RankSymbol<2> > &,
+                                                                             const BasicRepetitionFactor<RankSymbol<2> > &);
+    template BasicNextFactorResult2<RankSymbol<3> > combination_factor_to_result(const BasicSlice<RankSymbol<3> > &,
+                                                                             const BasicCombinationFactor<RankSymbol<3> > &);
+    template BasicNextFactorResult2<RankSymbol<3> > truncation_factor_to_result(const BasicSlice<RankSymbol<3> > &,
+                                                                             const BasicTruncationFactor<RankSymbol<3> > &);
+    template BasicNextFactorResult2<RankSymbol<3> > repetition_factor_to_result(const BasicSlice<RankSymbol<3> > &,
+                                                                             const BasicRepetitionFactor<RankSymbol<3> > &);
+    template BasicNextFactorResult2<RankSymbol<4> > combination_factor_to_result(const BasicSlice<RankSymbol<4> > &,
+                                                                             const BasicCombinationFactor<RankSymbol<4> > &);
+    template BasicNextFactorResult2<RankSymbol<4> > truncation_factor_to_result(const BasicSlice<RankSymbol<4> > &,
+                                                                             const BasicTruncationFactor<RankSymbol<4> > &);
+    template BasicNextFactorResult2<RankSymbol<4> > repetition_factor_to_result(const BasicSlice<RankSymbol<4> > &,
+                                                                             const BasicRepetitionFactor<RankSymbol<4> > &);
+    template BasicNextFactorResult2<RankSymbol<5> > combination_factor_to_result(const BasicSlice<RankSymbol<5> > &,
+                                                                             const BasicCombinationFactor<RankSymbol<5> > &);
+    template BasicNextFactorResult2<RankSymbol<5> > truncation_factor_to_result(const BasicSlice<RankSymbol<5> > &,
+                                                                             const BasicTruncationFactor<RankSymbol<5> > &);
+    template BasicNextFactorResult2<RankSymbol<5> > repetition_factor_to_result(const BasicSlice<RankSymbol<5> > &,
+                                                                             const BasicRepetitionFactor<RankSymbol<5> > &);
+}
@@ -0,0 +1,352 @@
+#ifndef FACTOR_SEARCH_H
+#define FACTOR_SEARCH_H
+#include "compressor.h"
+#include "mismatch.h"
+#include "slice.h"
+#include "radix_trie.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// The search for the longest next factor of LZD, LZD+ and LZDR (also on counted radix tries),
+// as one state machine with compile-time policies.
+namespace factor_search {
+    template<typename Symbol>
+    struct BasicCombinationFactor {
+        size_t first_factor;
+        size_t second_factor;
+        bool first_is_byte;
+        bool second_is_byte;
+        size_t length;
+        bool used_extra_truncation;
+        // Only used for uncounted radix tries with truncation
+        BasicRadixTrieNode<Symbol>* insertion_node;
+        size_t first_node_length;
+    };
+    template<typename Symbol>
+    struct BasicTruncationFactor {
+        size_t factor_index;
+        size_t length;
+        // Only used for uncounted radix tries
+        BasicRadixTrieNode<Symbol>* insertion_node;
+        size_t last_node_length;
+    };
+    template<typename Symbol>
+    struct BasicRepetitionFactor {
+        size_t factor;
+        bool factor_is_byte;
+        size_t factor_length;
+        size_t total_length;
+        // Only used for uncounted radix tries
+        BasicRadixTrieNode<Symbol>* insertion_node;
+    };
+
+    // The longest candidate of each factor type
+    template<typename Symbol>
+    struct BasicFactorCandidates {
+        BasicCombinationFactor<Symbol> combination;
+        // Only set if truncation is allowed
+        std::optional<BasicTruncationFactor<Symbol> > truncation;
+        // Only valid if repetition is allowed
+        BasicRepetitionFactor<Symbol> repetition;
+    };
+
+    using CombinationFactor = BasicCombinationFactor<uint8_t>;
+    using TruncationFactor = BasicTruncationFactor<uint8_t>;
+    using RepetitionFactor = BasicRepetitionFactor<uint8_t>;
+    using FactorCandidates = BasicFactorCandidates<uint8_t>;
+
+    // Trie is either a RadixTrie (of bytes or wider symbols) or a CountedRadixTrie.
+    // The counted variant supports limiting the factors to a usable length (for the flexible parsings),
+    // but does not track where a factor has to be inserted.
+    template<bool AllowTruncation, bool AllowRepetition, typename Trie>
+    struct Policy {
+        static constexpr bool allow_truncation = AllowTruncation;
+        static constexpr bool allow_repetition = AllowRepetition;
+        static constexpr bool counted = std::is_same_v<Trie, CountedRadixTrie>;
+        // Insertion nodes are only needed if a factor does not always start at a factor node (truncation)
+        static constexpr bool track_insertion = AllowTruncation && !counted;
+        using TrieType = Trie;
+        using Node = std::remove_reference_t<decltype(std::declval<Trie &>().root_node)>;
+        using Edge = typename decltype(std::declval<Node &>().edges)::mapped_type;
+        using EdgeTextIterator = decltype(std::declval<Edge &>().rest_text.begin());
+        using Symbol = typename decltype(std::declval<Node &>().edges)::key_type;
+        // The root jump table indexes two bytes
+        static constexpr bool use_root_jump_table = !counted && std::is_same_v<Symbol, uint8_t>;
+    };
+
+    using LzdPolicy = Policy<false, false, RadixTrie>;
+    using LzdPlusPolicy = Policy<true, false, RadixTrie>;
+    using LzdrPolicy = Policy<true, true, RadixTrie>;
+    using CountedLzdrPolicy = Policy<true, true, CountedRadixTrie>;
+
+    template<typename Symbol>
+    size_t naive_lce(const BasicSlice<Symbol> &s, const size_t start1, const size_t start2) {
+        if (start1 >= s.size() || start2 >= s.size()) {
+            return 0;
+        }
+        return s.slice(start1).common_prefix_length(s.slice(start2));
+    }
+
+    // A byte operand (symbol) of a wide-symbol alphabet takes sizeof(Symbol) bytes of the record
+    template<typename Symbol>
+    BasicNextFactorResult2<Symbol> combination_factor_to_result(const BasicSlice<Symbol> &rest_input, const BasicCombinationFactor<Symbol> &factor);
+
+    template<typename Symbol>
+    BasicNextFactorResult2<Symbol> truncation_factor_to_result(const BasicSlice<Symbol> &rest_input, const BasicTruncationFactor<Symbol> &factor);
+
+    template<typename Symbol>
+    BasicNextFactorResult2<Symbol> repetition_factor_to_result(const BasicSlice<Symbol> &rest_input, const BasicRepetitionFactor<Symbol> &factor);
+
+    // This method requires rest_input to be not empty!
+    // Maximizes all factor types allowed by P by walking the trie of the previous factors.
+    // usable_rest_input_len is only used for counted tries, otherwise it has to be rest_input.size().
+    template<typename P>
+    BasicFactorCandidates<typename P::Symbol> search_factor_candidates(
+        const BasicSlice<typename P::Symbol> &entire_input, const size_t bytes_already_read,
+        const BasicSlice<typename P::Symbol> &rest_input, const size_t usable_rest_input_len,
+        typename P::TrieType &previous_factors) {
+        using Node = typename P::Node;
+        using Edge = typename P::Edge;
+        using Symbol = typename P::Symbol;
+        using TruncationFactor = BasicTruncationFactor<Symbol>;
+        using RepetitionFactor = BasicRepetitionFactor<Symbol>;
+
+        // Current nodes
+        Node* current_node = &previous_factors.root_node;
+        Edge* current_edge = nullptr;
+        bool finished_first_factor_node = false;
+        typename P::EdgeTextIterator edge_rest_text_iter = {};
+        // For truncation: combination first node is not always same, as truncation allows splitting nodes
+        size_t truncation_last_node_length = 0;
+        bool optimal_repetition_factor_found = false;
+        // Depth one node reached via the root jump table and the edge of the next byte from it
+        Node* jump_depth_one_node = nullptr;
+        Edge* jump_second_edge = nullptr;
+
+        // Factors
+        // Note: The combination factor is initialized with second_factor=0 and second_is_byte=false
+        //       so that the second factor is empty by default in case only one factor is needed for the input.
+        //       The same is done for the first factor to check if it has been initialized,
+        //       that fact will later be used in the while loop.
+        BasicFactorCandidates<Symbol> candidates = {{0, 0, false, false, 0, false, nullptr, 0}, std::nullopt, {}};
+        BasicCombinationFactor<Symbol> &combination_factor = candidates.combination;
+        std::optional<TruncationFactor> &truncation_factor = candidates.truncation;
+        RepetitionFactor &repetition_factor = candidates.repetition;
+        if constexpr (P::track_insertion) {
+            combination_factor.insertion_node = &previous_factors.root_node;
+        }
+        if constexpr (P::allow_repetition) {
+            // Initialize repetition factor with maximized single character repetition via LCE
+            repetition_factor = {rest_input[0], true, 1, 1 + naive_lce(entire_input, bytes_already_read, bytes_already_read + 1), nullptr};
+            if constexpr (P::track_insertion) {
+                repetition_factor.insertion_node = &previous_factors.root_node;
+            }
+        }
+
+        // Called after a byte got read successfully and the edge now ends at end_node
+        // (edge_finished is true if the end node has been reached)
+        const auto on_edge_byte = [&](const size_t input_i, Node &end_node, const bool edge_finished) {
+            // Update truncation factor / second combination factor
+            // (We do this eagerly instead of waiting for the first mismatch,
+            // as there is no guarantee a mismatch will happen if the input ends early)
+            if constexpr (P::allow_truncation) {
+                if (!finished_first_factor_node) {
+                    if constexpr (P::track_insertion) {
+                        if (edge_finished) {
+                            truncation_factor = TruncationFactor{end_node.next_factor_node_index, input_i, &end_node, input_i};
+                        } else {
+                            truncation_factor = TruncationFactor{end_node.next_factor_node_index, input_i, current_node, truncation_last_node_length};
+                        }
+                    } else {
+                        truncation_factor = TruncationFactor{end_node.next_factor_node_index, input_i, nullptr, 0};
+                    }
+                } else {
+                    // Make sure to not overwrite single byte second factor
+                    // with truncated factor, when truncated length is the same
+                    if (input_i > combination_factor.length) {
+                        combination_factor.second_factor = end_node.next_factor_node_index;
+                        combination_factor.second_is_byte = false;
+                        combination_factor.length = input_i;
+                        combination_factor.used_extra_truncation = true;
+                    }
+                }
+            }
+        };
+
+        // Called when the factor node current_node has been reached. Returns true if the search is finished
+        const auto on_factor_node = [&](const size_t input_i) {
+            if (!finished_first_factor_node) {
+                // Update first combination factor
+                combination_factor.first_factor = current_node->index;
+                combination_factor.first_is_byte = false;
+                combination_factor.length = input_i;
+                if constexpr (P::track_insertion) {
+                    combination_factor.insertion_node = current_node;
+                    combination_factor.first_node_length = input_i;
+                }
+
+                // Update repetition factor
+                if constexpr (P::allow_repetition && P::counted) {
+                    if (!optimal_repetition_factor_found) {
+                        if (const size_t repetition_len = input_i + naive_lce(entire_input, bytes_already_read, bytes_already_read + input_i);
+                            repetition_len > repetition_factor.total_length || ((repetition_len == repetition_factor.total_length || repetition_len >= usable_rest_input_len) && std::min(repetition_factor.total_length, usable_rest_input_len) % repetition_factor.factor_length != 0 && std::min(repetition_len, usable_rest_input_len) % input_i == 0)) {
+                            repetition_factor = RepetitionFactor{current_node->index, false, input_i, repetition_len, nullptr};
+                            if (repetition_len >= usable_rest_input_len && usable_rest_input_len % input_i == 0) {
+                                optimal_repetition_factor_found = true;
+                            }
+                        }
+                    }
+                } else if constexpr (P::allow_repetition) {
+                    if (const size_t repetition_len = input_i + naive_lce(entire_input, bytes_already_read, bytes_already_read + input_i); repetition_len > repetition_factor.total_length) {
+                        repetition_factor = RepetitionFactor{current_node->index, false, input_i, repetition_len, current_node};
+                    }
+                }
+            } else if constexpr (P::allow_truncation) {
+                // The second factor has already been updated by the truncation,
+                // this branch is only used to track extra truncations
+                combination_factor.used_extra_truncation = false;
+
+                if constexpr (P::counted) {
+                    // Avoid truncation with longer second combination factor and use this instead
+                    // Useful for Flexible algorithms
+                    if (input_i == usable_rest_input_len) {
+                        return true;
+                    }
+                }
+            } else {
+                // Update second combination factor
+                combination_factor.second_factor = current_node->index;
+                combination_factor.second_is_byte = false;
+                combination_factor.length = input_i;
+            }
+            return false;
+        };
+
+        // Maximize factors
+        size_t input_i = 0;
+        while (input_i < rest_input.size()) {
+            if constexpr (!P::counted) {
+                if (current_edge != nullptr) {
+                    // Skip the matching bytes of the edge rest text at once, as long as they neither end the edge
+                    // nor the input. The updates of the skipped bytes overwrite each other, so only the last one is needed.
+                    const size_t max_skip = std::min(static_cast<size_t>(current_edge->rest_text.end() - edge_rest_text_iter),
+                                                     rest_input.size() - input_i) - 1;
+                    if (const size_t skip = first_mismatch(edge_rest_text_iter, rest_input.data() + input_i, max_skip); skip > 0) {
+                        input_i += skip;
+                        edge_rest_text_iter += skip;
+                        on_edge_byte(input_i, current_edge->end_node, false);
+                    }
+                }
+            }
+
+            const Symbol current_byte = rest_input[input_i];
+            const bool is_last_byte = input_i == rest_input.size() - 1;
+
+            // Update combination factor if the current factor is uninitialized,
+            // as a combination factor allows one single byte.
+            // (We do this eagerly instead of doing this in the case where the edge from the root node does not exist,
+            // as it is possible that an edge from the root node exists, but a factor node is never reached)
+            if (!finished_first_factor_node) {
+                if (combination_factor.first_factor == 0 && !combination_factor.first_is_byte) {
+                    combination_factor.first_factor = current_byte;
+                    combination_factor.first_is_byte = true;
+                    combination_factor.length = input_i + 1;
+                }
+            } else {
+                if (combination_factor.second_factor == 0 && !combination_factor.second_is_byte) {
+                    combination_factor.second_factor = current_byte;
+                    combination_factor.second_is_byte = true;
+                    combination_factor.length = input_i + 1;
+                }
+            }
+
+            bool byte_read = false;
+            if (current_edge == nullptr) {
+                // Currently, we are exactly at a node
+                Edge* found_edge = nullptr;
+                if constexpr (P::use_root_jump_table) {
+                    if (current_node == &previous_factors.root_node && !is_last_byte && previous_factors.has_root_jump_table()) {
+                        // Look up the edges of the first two bytes at once
+                        const RootJumpEntry jump = previous_factors.root_jump(current_byte, rest_input[input_i + 1]);
+                        found_edge = jump.first_edge;
+                        const bool at_depth_one_node = found_edge != nullptr && found_edge->rest_text.empty();
+                        jump_depth_one_node = at_depth_one_node ? &found_edge->end_node : nullptr;
+                        jump_second_edge = jump.second_edge;
+                    } else if (current_node == jump_depth_one_node) {
+                        found_edge = jump_second_edge;
+                        jump_depth_one_node = nullptr;
+                    } else if (auto it = current_node->edges.find(current_byte); it != current_node->edges.end()) {
+                        found_edge = &it->second;
+                    }
+                } else if (auto it = current_node->edges.find(current_byte); it != current_node->edges.end()) {
+                    found_edge = &it->second;
+                }
+                if (found_edge != nullptr) {
+                    // Edge exists
+                    // The current byte got successfully read, therefore increase input_i
+                    ++input_i;
+                    byte_read = true;
+
+                    Edge& edge = *found_edge;
+                    on_edge_byte(input_i, edge.end_node, edge.rest_text.empty());
+
+                    if (edge.rest_text.empty()) {
+                        // Go directly to next node
+                        current_node = &edge.end_node;
+                        truncation_last_node_length = input_i;
+                        if (current_node->index != 0 && on_factor_node(input_i)) {
+                            break;
+                        }
+                    } else {
+                        // Update edge
+                        current_edge = &edge;
+                        edge_rest_text_iter = edge.rest_text.begin();
+                    }
+                }
+            } else if (*edge_rest_text_iter == current_byte) {
+                // We have to iterate over edge text
+                // The current byte got successfully read, therefore increase input_i
+                ++input_i;
+                byte_read = true;
+
+                // Move to next element of edge rest text
+                ++edge_rest_text_iter;
+                const bool edge_finished = edge_rest_text_iter == current_edge->rest_text.end();
+                on_edge_byte(input_i, current_edge->end_node, edge_finished);
+
+                if (edge_finished) {
+                    // Reached end of edge rest text, go to next node
+                    current_node = &current_edge->end_node;
+                    current_edge = nullptr;
+                    truncation_last_node_length = input_i;
+                    if (current_node->index != 0 && on_factor_node(input_i)) {
+                        break;
+                    }
+                }
+            }
+
+            // Move on to the second factor if we were unable to read the byte (the byte is not increased then),
+            // or if we reached the last byte while searching for the first combination factor
+            if (!byte_read || (!finished_first_factor_node && is_last_byte)) {
+                if (finished_first_factor_node) {
+                    // Second factor finished, break loop
+                    break;
+                }
+                finished_first_factor_node = true;
+                current_node = &previous_factors.root_node;
+                current_edge = nullptr;
+                // Second factor begins after end of first factor
+                input_i = combination_factor.length;
+            }
+        }
+
+        return candidates;
+    }
+}
+
+#endif //FACTOR_SEARCH_H
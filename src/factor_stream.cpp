@@ -0,0 +1,87 @@
+#include "factor_stream.h"
+#include "compressor.h"
+#include "lzdr_linear_time.h"
+#include "small_alphabet.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace {
+    template<typename Symbol>
+    uint8_t record_type(const BasicStreamedFactor<Symbol> &factor) {
+        return factor.record[0] & ~lzdr_compressor::WIDE_FORMAT_FLAG;
+    }
+
+    template<typename Symbol>
+    bool is_wide(const BasicStreamedFactor<Symbol> &factor) {
+        return (factor.record[0] & lzdr_compressor::WIDE_FORMAT_FLAG) != 0;
+    }
+
+    template<typename Symbol>
+    size_t uint_size(const BasicStreamedFactor<Symbol> &factor) {
+        return is_wide(factor) ? 8 : 4;
+    }
+}
+
+template<typename Symbol>
+FactorType BasicStreamedFactor<Symbol>::type() const {
+    switch (record_type(*this)) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            return FactorType::COMBINATION;
+        case 4:
+            return FactorType::TRUNCATION;
+        case 5:
+        case 6:
+            return FactorType::REPETITION;
+        default:
+            throw std::out_of_range("Unknown factor type");
+    }
+}
+
+template<typename Symbol>
+bool BasicStreamedFactor<Symbol>::first_is_byte() const {
+    const uint8_t factor_type = record_type(*this);
+    return factor_type <= 1 || factor_type == 6;
+}
+
+template<typename Symbol>
+uint64_t BasicStreamedFactor<Symbol>::first() const {
+    if (first_is_byte()) {
+        return symbol_from_bytes(&record[1], sizeof(Symbol));
+    }
+    return uint_from_bytes(&record[1], is_wide(*this));
+}
+
+template<typename Symbol>
+bool BasicStreamedFactor<Symbol>::second_is_byte() const {
+    const uint8_t factor_type = record_type(*this);
+    return factor_type == 0 || factor_type == 2;
+}
+
+template<typename Symbol>
+uint64_t BasicStreamedFactor<Symbol>::second() const {
+    switch (record_type(*this)) {
+        case 0:
+            return symbol_from_bytes(&record[1 + sizeof(Symbol)], sizeof(Symbol));
+        case 1:
+            return uint_from_bytes(&record[1 + sizeof(Symbol)], is_wide(*this));
+        case 2:
+            return symbol_from_bytes(&record[1 + uint_size(*this)], sizeof(Symbol));
+        case 3:
+            return uint_from_bytes(&record[1 + uint_size(*this)], is_wide(*this));
+        default:
+            throw std::out_of_range("Only combinations have a second operand");
+    }
+}
+
+template struct BasicStreamedFactor<uint8_t>;
+template struct BasicStreamedFactor<uint16_t>;
+template struct BasicStreamedFactor<uint32_t>;
+template struct BasicStreamedFactor<RankSymbol<2> >;
+template struct BasicStreamedFactor<RankSymbol<3> >;
+template struct BasicStreamedFactor<RankSymbol<4> >;
+template struct BasicStreamedFactor<RankSymbol<5> >;
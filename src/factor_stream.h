@@ -0,0 +1,154 @@
+#ifndef FACTOR_STREAM_H
+#define FACTOR_STREAM_H
+#include "compressor.h"
+#include "lzd_plus_linear_time.h"
+#include "lzdr_linear_time.h"
+#include "radix_trie.h"
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+enum class FactorType {
+    COMBINATION,
+    TRUNCATION,
+    REPETITION,
+};
+
+// A factor as produced by a factor stream. The operands are read from the record (the compressed data of the factor)
+template<typename Symbol>
+struct BasicStreamedFactor {
+    // 1 for the first factor of the stream
+    size_t index;
+    // Source range: the factor is input[position, position + text.size())
+    size_t position;
+    BasicSlice<Symbol> text;
+    std::vector<uint8_t> record;
+    bool used_extra_truncation;
+
+    [[nodiscard]] size_t length() const {
+        return text.size();
+    }
+
+    [[nodiscard]] FactorType type() const;
+
+    // The first operand is a byte (symbol) or the index of a previous factor
+    // (the base of a truncation or repetition)
+    [[nodiscard]] bool first_is_byte() const;
+
+    [[nodiscard]] uint64_t first() const;
+
+    // Only combinations have a second operand, it is 0 (and not a byte) if the combination has only one factor
+    [[nodiscard]] bool second_is_byte() const;
+
+    [[nodiscard]] uint64_t second() const;
+};
+
+using StreamedFactor = BasicStreamedFactor<uint8_t>;
+
+// Pull-based greedy factorization: every call of next() computes one more factor and inserts it into
+// previous_factors, so consumers (encoder, verifier, stats, ...) process the factors as they are produced
+// without buffering them. next_factor(bytes_already_read, rest_input, previous_factors) computes the longest
+// next factor. This is the loop of the algorithms that return only the number of factors, which use it themselves.
+// If read_more is not null, input holds the symbols read so far: read_more(num_symbols) waits until at least
+// num_symbols (or all remaining) symbols are read and returns them. A factor that reaches the end of the symbols read
+// so far could be longer with more symbols, so it is computed again once twice as many symbols after its start are read.
+template<typename NextFactorFn, typename Symbol = uint8_t>
+class FactorStream {
+    BasicSlice<Symbol> input;
+    BasicRadixTrie<Symbol> &previous_factors;
+    NextFactorFn next_factor;
+    std::function<BasicSlice<Symbol>(size_t)> read_more;
+    size_t position = 0;
+    BasicStreamedFactor<Symbol> factor = {0, 0, {nullptr, 0}, {}, false};
+
+public:
+    FactorStream(const BasicSlice<Symbol> input, BasicRadixTrie<Symbol> &previous_factors, NextFactorFn next_factor,
+                 std::function<BasicSlice<Symbol>(size_t)> read_more = nullptr)
+        : input(input), previous_factors(previous_factors), next_factor(std::move(next_factor)), read_more(std::move(read_more)) {
+    }
+
+    // Returns nullptr after the last factor. The factor stays valid until the next call
+    // (its record can be moved out)
+    BasicStreamedFactor<Symbol> *next() {
+        if (position >= input.size() && (!read_more || (input = read_more(position + 1)).size() <= position)) {
+            return nullptr;
+        }
+        BasicNextFactorResult2<Symbol> longest_factor = next_factor(position, input.slice(position), previous_factors);
+        while (read_more && position + longest_factor.factor_slice.size() == input.size()) {
+            // Doubling the symbols after position keeps the work of the repeated searches linear in the factor length
+            const BasicSlice<Symbol> more_input = read_more(input.size() + longest_factor.factor_slice.size());
+            if (more_input.size() == input.size()) {
+                break;
+            }
+            input = more_input;
+            longest_factor = next_factor(position, input.slice(position), previous_factors);
+        }
+        lzdr_linear_time_internal::insert_into_radix_trie(previous_factors, longest_factor.insertion_node, longest_factor.insertion_slice);
+        ++factor.index;
+        factor.position = position;
+        factor.text = longest_factor.factor_slice;
+        factor.record = std::move(longest_factor.compressed_data);
+        factor.used_extra_truncation = longest_factor.used_extra_truncation;
+        position += factor.text.size();
+        return &factor;
+    }
+};
+
+namespace factor_stream_internal {
+    template<typename Symbol>
+    struct LzdrNextFactor {
+        BasicSlice<Symbol> input;
+
+        BasicNextFactorResult2<Symbol> operator()(const size_t bytes_already_read, const BasicSlice<Symbol> &rest_input,
+                                                  BasicRadixTrie<Symbol> &previous_factors) const {
+            return lzdr_linear_time_internal::next_longest_factor(input, bytes_already_read, rest_input, previous_factors);
+        }
+    };
+
+    template<typename Symbol>
+    struct LzdPlusNextFactor {
+        BasicSlice<Symbol> input;
+
+        BasicNextFactorResult2<Symbol> operator()(size_t, const BasicSlice<Symbol> &rest_input, BasicRadixTrie<Symbol> &previous_factors) const {
+            return lzd_plus_linear_time_internal::next_longest_factor(rest_input, previous_factors);
+        }
+    };
+
+    // Factor stream with its own trie of the previous factors
+    template<template<typename> typename NextFactorFn, typename Symbol>
+    class OwningFactorStream {
+        BasicRadixTrie<Symbol> previous_factors;
+        FactorStream<NextFactorFn<Symbol>, Symbol> stream;
+
+    public:
+        explicit OwningFactorStream(const BasicSlice<Symbol> input) : stream(input, previous_factors, NextFactorFn<Symbol>{input}) {
+            if constexpr (std::is_same_v<Symbol, uint8_t>) {
+                previous_factors.enable_root_jump_table();
+            }
+        }
+
+        OwningFactorStream(const OwningFactorStream &) = delete;
+        OwningFactorStream &operator=(const OwningFactorStream &) = delete;
+
+        BasicStreamedFactor<Symbol> *next() {
+            return stream.next();
+        }
+    };
+}
+
+// The factors of lzdr_linear_time
+template<typename Symbol>
+using BasicLzdrFactorStream = factor_stream_internal::OwningFactorStream<factor_stream_internal::LzdrNextFactor, Symbol>;
+using LzdrFactorStream = BasicLzdrFactorStream<uint8_t>;
+
+// The factors of lzd_plus_linear_time
+template<typename Symbol>
+using BasicLzdPlusFactorStream = factor_stream_internal::OwningFactorStream<factor_stream_internal::LzdPlusNextFactor, Symbol>;
+using LzdPlusFactorStream = BasicLzdPlusFactorStream<uint8_t>;
+
+#endif //FACTOR_STREAM_H
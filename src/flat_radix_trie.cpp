@@ -0,0 +1,172 @@
+#include "flat_radix_trie.h"
+#include "radix_trie.h"
+#include "slice.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+    size_t padded_to_8(const size_t size) {
+        return (size + 7) / 8 * 8;
+    }
+
+    // Merges the flat node into node, or the flat edge (byte, rest_text) ending at flat_node into the edges of node
+    struct MergeTask {
+        RadixTrieNode *node;
+        bool is_edge;
+        uint8_t byte;
+        Slice rest_text;
+        uint64_t flat_node;
+    };
+
+    template<typename T>
+    void append_pod(std::vector<uint8_t> &out, const T &value) {
+        const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+}
+
+size_t FlatRadixTrie::serialized_size(const uint8_t *data, const size_t size) {
+    if (size < sizeof(FlatRadixTrieHeader) || reinterpret_cast<uintptr_t>(data) % 8 != 0) {
+        throw std::runtime_error("Flat radix trie truncated or unaligned");
+    }
+    const auto *header = reinterpret_cast<const FlatRadixTrieHeader *>(data);
+    // Check each count separately before multiplying to avoid overflows
+    if (header->num_nodes == 0 || header->num_nodes > size / sizeof(FlatRadixTrieNode) ||
+        header->num_edges > size / sizeof(FlatRadixTrieEdge) || header->text_len > size) {
+        throw std::runtime_error("Flat radix trie truncated");
+    }
+    const size_t total = sizeof(FlatRadixTrieHeader) + header->num_nodes * sizeof(FlatRadixTrieNode)
+                         + header->num_edges * sizeof(FlatRadixTrieEdge) + padded_to_8(header->text_len);
+    if (total > size) {
+        throw std::runtime_error("Flat radix trie truncated");
+    }
+    return total;
+}
+
+FlatRadixTrie::FlatRadixTrie(const uint8_t *data, const size_t size) {
+    serialized_size(data, size);
+    header = reinterpret_cast<const FlatRadixTrieHeader *>(data);
+    nodes = reinterpret_cast<const FlatRadixTrieNode *>(data + sizeof(FlatRadixTrieHeader));
+    edges = reinterpret_cast<const FlatRadixTrieEdge *>(nodes + header->num_nodes);
+    text = reinterpret_cast<const uint8_t *>(edges + header->num_edges);
+
+    // Validate all references once, so walking the trie needs no checks
+    for (size_t i = 0; i < header->num_nodes; ++i) {
+        if (nodes[i].first_edge > header->num_edges || nodes[i].num_edges > header->num_edges - nodes[i].first_edge) {
+            throw std::runtime_error("Flat radix trie node has invalid edges");
+        }
+    }
+    for (size_t i = 0; i < header->num_edges; ++i) {
+        if (edges[i].end_node == 0 || edges[i].end_node >= header->num_nodes ||
+            edges[i].rest_text_offset > header->text_len || edges[i].rest_text_len > header->text_len - edges[i].rest_text_offset) {
+            throw std::runtime_error("Flat radix trie edge is invalid");
+        }
+    }
+}
+
+void FlatRadixTrie::serialize(const RadixTrie &trie, std::vector<uint8_t> &out) {
+    // Number the nodes in breadth-first order, so the edges of a node are stored consecutively
+    std::vector<const RadixTrieNode *> queue = {&trie.root_node};
+    std::vector<FlatRadixTrieNode> flat_nodes;
+    std::vector<FlatRadixTrieEdge> flat_edges;
+    std::vector<uint8_t> flat_text;
+    for (size_t i = 0; i < queue.size(); ++i) {
+        const RadixTrieNode *node = queue[i];
+        std::vector<std::pair<uint8_t, const RadixTrieEdge *> > sorted_edges;
+        sorted_edges.reserve(node->edges.size());
+        for (const auto &[byte, edge]: node->edges) {
+            sorted_edges.emplace_back(byte, &edge);
+        }
+        std::sort(sorted_edges.begin(), sorted_edges.end(),
+                  [](const auto &a, const auto &b) { return a.first < b.first; });
+
+        flat_nodes.push_back({node->index, node->next_factor_node_index, flat_edges.size(), sorted_edges.size()});
+        for (const auto &[byte, edge]: sorted_edges) {
+            FlatRadixTrieEdge flat_edge = {queue.size(), flat_text.size(), edge->rest_text.size(), byte, {}};
+            flat_text.insert(flat_text.end(), edge->rest_text.data(), edge->rest_text.data() + edge->rest_text.size());
+            flat_edges.push_back(flat_edge);
+            queue.push_back(&edge->end_node);
+        }
+    }
+
+    const FlatRadixTrieHeader header = {flat_nodes.size(), flat_edges.size(), flat_text.size(), trie.num_factor_nodes};
+    out.reserve(out.size() + sizeof(header) + flat_nodes.size() * sizeof(FlatRadixTrieNode)
+                + flat_edges.size() * sizeof(FlatRadixTrieEdge) + padded_to_8(flat_text.size()));
+    append_pod(out, header);
+    for (const FlatRadixTrieNode &node: flat_nodes) {
+        append_pod(out, node);
+    }
+    for (const FlatRadixTrieEdge &edge: flat_edges) {
+        append_pod(out, edge);
+    }
+    out.insert(out.end(), flat_text.begin(), flat_text.end());
+    out.resize(out.size() + padded_to_8(flat_text.size()) - flat_text.size(), 0);
+}
+
+const FlatRadixTrieEdge *FlatRadixTrie::find_edge(const FlatRadixTrieNode &node, const uint8_t byte) const {
+    const FlatRadixTrieEdge *begin = edges + node.first_edge;
+    const FlatRadixTrieEdge *end = begin + node.num_edges;
+    const FlatRadixTrieEdge *it = std::lower_bound(begin, end, byte,
+                                                   [](const FlatRadixTrieEdge &edge, const uint8_t b) { return edge.byte < b; });
+    if (it != end && it->byte == byte) {
+        return it;
+    }
+    return nullptr;
+}
+
+void FlatRadixTrie::merge_into(RadixTrie &trie) const {
+    // Explicit stack, as the tries can be very deep.
+    // The node pointers on the stack stay valid: a split only moves the end node of the edge being merged,
+    // and no other task points to it.
+    std::vector<MergeTask> tasks = {{&trie.root_node, false, 0, Slice::create_empty(), 0}};
+    while (!tasks.empty()) {
+        const MergeTask task = tasks.back();
+        tasks.pop_back();
+        RadixTrieNode *node = task.node;
+        const FlatRadixTrieNode &flat_node = nodes[task.flat_node];
+
+        if (!task.is_edge) {
+            if (node->index == 0 && flat_node.index != 0) {
+                node->index = flat_node.index;
+                node->next_factor_node_index = flat_node.index;
+            } else if (node->next_factor_node_index == 0) {
+                node->next_factor_node_index = flat_node.next_factor_node_index;
+            }
+            for (uint64_t i = flat_node.first_edge; i < flat_node.first_edge + flat_node.num_edges; ++i) {
+                tasks.push_back({node, true, edges[i].byte, rest_text(edges[i]), edges[i].end_node});
+            }
+            continue;
+        }
+
+        const auto it = node->edges.find(task.byte);
+        if (it == node->edges.end()) {
+            // New edge, its end node gets the index of the flat node
+            auto [new_it, inserted] = node->edges.emplace(task.byte, RadixTrieEdge(RadixTrieNode::create_root_node(), task.rest_text));
+            tasks.push_back({&new_it->second.end_node, false, 0, Slice::create_empty(), task.flat_node});
+            continue;
+        }
+
+        RadixTrieEdge &edge = it->second;
+        const size_t common = edge.rest_text.common_prefix_length(task.rest_text);
+        if (common < edge.rest_text.size()) {
+            // Split the edge with a new splitting node
+            const Slice old_rest_text = edge.rest_text;
+            RadixTrieNode splitting_node = RadixTrieNode::create_splitting_node(edge.end_node.next_factor_node_index);
+            splitting_node.edges.emplace(old_rest_text[common], RadixTrieEdge(std::move(edge.end_node), old_rest_text.slice(common + 1)));
+            edge.end_node = std::move(splitting_node);
+            edge.rest_text = old_rest_text.slice(0, common);
+        }
+        if (common == task.rest_text.size()) {
+            tasks.push_back({&edge.end_node, false, 0, Slice::create_empty(), task.flat_node});
+        } else {
+            tasks.push_back({&edge.end_node, true, task.rest_text[common], task.rest_text.slice(common + 1), task.flat_node});
+        }
+    }
+    trie.num_factor_nodes = std::max<size_t>(trie.num_factor_nodes, header->num_factor_nodes);
+}
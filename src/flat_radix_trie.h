@@ -0,0 +1,77 @@
+#ifndef FLAT_RADIX_TRIE_H
+#define FLAT_RADIX_TRIE_H
+#include "radix_trie.h"
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pointer-free, read-only version of a RadixTrie, that can be used directly from a (memory-mapped) buffer.
+//
+// Layout (all integers in native byte order, the buffer has to be 8 byte aligned):
+//   FlatRadixTrieHeader
+//   FlatRadixTrieNode[num_nodes] (node 0 is the root node)
+//   FlatRadixTrieEdge[num_edges] (the edges of a node are stored consecutively and sorted by byte)
+//   uint8_t[text_len] (the rest texts of all edges), padded to a multiple of 8 bytes
+struct FlatRadixTrieHeader {
+    uint64_t num_nodes;
+    uint64_t num_edges;
+    uint64_t text_len;
+    // The number of factor nodes, including the root node
+    uint64_t num_factor_nodes;
+};
+
+struct FlatRadixTrieNode {
+    uint64_t index;
+    uint64_t next_factor_node_index;
+    uint64_t first_edge;
+    uint64_t num_edges;
+};
+
+struct FlatRadixTrieEdge {
+    uint64_t end_node;
+    uint64_t rest_text_offset;
+    uint64_t rest_text_len;
+    uint8_t byte;
+    uint8_t padding[7];
+};
+
+class FlatRadixTrie {
+    const FlatRadixTrieHeader *header;
+    const FlatRadixTrieNode *nodes;
+    const FlatRadixTrieEdge *edges;
+    const uint8_t *text;
+
+public:
+    // Validates the buffer, throws std::runtime_error if it is malformed.
+    // The buffer has to outlive the trie.
+    FlatRadixTrie(const uint8_t *data, size_t size);
+
+    // Size of a flat trie in bytes
+    static size_t serialized_size(const uint8_t *data, size_t size);
+
+    // Appends the flat representation of trie to out
+    static void serialize(const RadixTrie &trie, std::vector<uint8_t> &out);
+
+    // Adds all nodes of this trie to trie. If a factor node exists in both, the index in trie is kept.
+    // The rest texts of new edges point into the buffer of this trie, so it has to outlive trie.
+    void merge_into(RadixTrie &trie) const;
+
+    [[nodiscard]] size_t num_factor_nodes() const {
+        return header->num_factor_nodes;
+    }
+
+    [[nodiscard]] const FlatRadixTrieNode &node(const size_t node_id) const {
+        return nodes[node_id];
+    }
+
+    // Returns the edge of node starting with byte or nullptr
+    [[nodiscard]] const FlatRadixTrieEdge *find_edge(const FlatRadixTrieNode &node, uint8_t byte) const;
+
+    [[nodiscard]] Slice rest_text(const FlatRadixTrieEdge &edge) const {
+        return {text + edge.rest_text_offset, edge.rest_text_len};
+    }
+};
+
+#endif //FLAT_RADIX_TRIE_H
@@ -15,6 +15,7 @@
 
 // Returns the number of factors
 size_t flexible_lzdr_max_radix_trie(const Slice input) {
+    std_flexible_lzdr_radix_trie_internal::CandidatePruning pruning(input);
     // LZDR factors: pairs of factor end position and factor slice
     // The end position is inclusive, that means, if input[i] is the last character of the factor,
     // then `i` is the end position.
@@ -59,6 +60,9 @@ size_t flexible_lzdr_max_radix_trie(const Slice input) {
         size_t best_total_length = 0;
         bool used_extra_truncation = false;
         for (size_t l = normal_longest_factor.size(); l >= 1; --l) {
+            if (pruning.prune(i, l, best_total_length)) {
+                continue;
+            }
             Slice truncated_rest_input = rest_input.slice(0, l);
 #ifndef NDEBUG
             std::cout << "  Testing factor: " << truncated_rest_input << std::endl;
@@ -125,7 +129,7 @@ size_t flexible_lzdr_max_radix_trie(const Slice input) {
 #endif
 
         if (used_extra_truncation) {
-            if (const uint8_t factor_type = compressed_best_factor[0]; 0 <= factor_type && factor_type <= 3) {
+            if (const uint8_t factor_type = compressed_best_factor[0] & ~lzdr_compressor::WIDE_FORMAT_FLAG; 0 <= factor_type && factor_type <= 3) {
                 num_extra_truncations_combinations += 1;
             } else if (factor_type == 5 || factor_type == 6) {
                 num_extra_truncations_repetitions += 1;
@@ -139,6 +143,7 @@ size_t flexible_lzdr_max_radix_trie(const Slice input) {
 
     std::cout << "Num extra truncations (combination): " << num_extra_truncations_combinations << std::endl;
     std::cout << "Num extra truncations (repetition): " << num_extra_truncations_repetitions << std::endl;
+    pruning.print_stats(std::cout);
 
     return factor_count;
 }
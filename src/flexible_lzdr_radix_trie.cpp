@@ -1,5 +1,6 @@
 #include "flexible_lzdr_radix_trie.h"
 #include "lzdr_linear_time.h"
+#include "lzdr_verifier.h"
 #include "std_flexible_lzdr_radix_trie.h"
 #include "compressor.h"
 #include "slice.h"
@@ -10,13 +11,22 @@
 #include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <optional>
 #include <stdexcept>
 #include <vector>
 
 // Returns the number of factors
-size_t flexible_lzdr_radix_trie(const Slice input, const bool check_decompressed_equals_input) {
+size_t flexible_lzdr_radix_trie(const Slice input, const bool check_decompressed_equals_input,
+                                std::vector<uint8_t> *compressed_output, const size_t max_candidates,
+                                const double time_budget_seconds, std::ostream &stats) {
+    std_flexible_lzdr_radix_trie_internal::CandidateBudget budget(time_budget_seconds, input.size(), max_candidates);
+    std_flexible_lzdr_radix_trie_internal::CandidatePruning pruning(input);
     CountedRadixTrie previous_factors;
     std::vector<uint8_t> compressed_data;
+    std::optional<ConcurrentLzdrVerifier> verifier;
+    if (check_decompressed_equals_input) {
+        verifier.emplace(input);
+    }
     std::vector<uint8_t> compressed_best_factor;
 
     size_t num_extra_truncations_combinations = 0;
@@ -28,17 +38,24 @@ size_t flexible_lzdr_radix_trie(const Slice input, const bool check_decompressed
         Slice normal_longest_factor = lzdr_linear_time_internal::next_longest_factor_counted_trie(
                 input, i, rest_input, rest_input.size(), previous_factors).factor_slice;
 #ifndef NDEBUG
-        std::cout << "Rest input: " << rest_input << std::endl;
+        stats << "Rest input: " << rest_input << std::endl;
 #endif
 
         // Go through all possible factors between length 1 and |normal_longest_factor|
         size_t best_factor_length = 0;
         size_t best_total_length = 0;
         bool used_extra_truncation = false;
-        for (size_t l = normal_longest_factor.size(); l >= 1; --l) {
+        const size_t num_candidates = budget.candidates_at(i);
+        const size_t min_candidate_length = num_candidates == 0 || num_candidates >= normal_longest_factor.size()
+            ? 1
+            : normal_longest_factor.size() - num_candidates + 1;
+        for (size_t l = normal_longest_factor.size(); l >= min_candidate_length; --l) {
+            if (pruning.prune(i, l, best_total_length)) {
+                continue;
+            }
             Slice truncated_rest_input = rest_input.slice(0, l);
 #ifndef NDEBUG
-            std::cout << "  Testing factor: " << truncated_rest_input << std::endl;
+            stats << "  Testing factor: " << truncated_rest_input << std::endl;
 #endif
             NextFactorResult next_factor = lzdr_linear_time_internal::next_longest_factor_counted_trie(
                 input, i, rest_input, truncated_rest_input.size(), previous_factors);
@@ -54,17 +71,18 @@ size_t flexible_lzdr_radix_trie(const Slice input, const bool check_decompressed
             size_t current_total_length = next_factor.factor_slice.size();
             if (next_rest_input.empty()) {
 #ifndef NDEBUG
-                std::cout << "    -> Next rest: " << std::endl;
-                std::cout << "    -> No next factor" <<
+                stats << "    -> Next rest: " << std::endl;
+                stats << "    -> No next factor" <<
                         " (total length: " << current_total_length << ")" << std::endl;
 #endif
-            } else {
+            } else if (min_candidate_length < normal_longest_factor.size()) {
+                // (The next factor does not matter if there is only one candidate)
                 Slice next_next_factor = lzdr_linear_time_internal::next_longest_factor_counted_trie(
                     input, i + next_factor.factor_slice.size(), next_rest_input, next_rest_input.size(), previous_factors).factor_slice;
                 current_total_length += next_next_factor.size();
 #ifndef NDEBUG
-                std::cout << "    -> Next rest: " << next_rest_input << std::endl;
-                std::cout << "    -> Next factor: " << next_next_factor <<
+                stats << "    -> Next rest: " << next_rest_input << std::endl;
+                stats << "    -> Next factor: " << next_next_factor <<
                         " (total length: " << current_total_length << ")" << std::endl;
 #endif
             }
@@ -84,11 +102,11 @@ size_t flexible_lzdr_radix_trie(const Slice input, const bool check_decompressed
         Slice longest_factor = rest_input.slice(0, best_factor_length);
         ++factor_count;
 #ifndef NDEBUG
-        std::cout << "Factor " << factor_count << ": " << longest_factor << std::endl;
+        stats << "Factor " << factor_count << ": " << longest_factor << std::endl;
 #endif
 
         if (used_extra_truncation) {
-            if (const uint8_t factor_type = compressed_best_factor[0]; 0 <= factor_type && factor_type <= 3) {
+            if (const uint8_t factor_type = compressed_best_factor[0] & ~lzdr_compressor::WIDE_FORMAT_FLAG; 0 <= factor_type && factor_type <= 3) {
                 num_extra_truncations_combinations += 1;
             } else if (factor_type == 5 || factor_type == 6) {
                 num_extra_truncations_repetitions += 1;
@@ -100,22 +118,27 @@ size_t flexible_lzdr_radix_trie(const Slice input, const bool check_decompressed
         i += longest_factor.size();
         std_flexible_lzdr_radix_trie_internal::insert_into_radix_trie(previous_factors, longest_factor);
 
-        if (check_decompressed_equals_input) {
+        if (verifier) {
+            verifier->add(compressed_best_factor);
+        }
+        if (compressed_output != nullptr) {
             compressed_data.insert(compressed_data.end(),
                                    std::make_move_iterator(compressed_best_factor.begin()),
                                    std::make_move_iterator(compressed_best_factor.end()));
         }
     }
 
-    if (check_decompressed_equals_input) {
-        if (const std::vector<uint8_t> decompressed_data = lzdr_decompress(compressed_data);
-            !(input == Slice(decompressed_data))) {
-            throw std::out_of_range("Decompressed not equal to input");
-        }
+    if (verifier) {
+        verifier->finish();
+    }
+    if (compressed_output != nullptr) {
+        compressed_output->insert(compressed_output->end(), compressed_data.begin(), compressed_data.end());
     }
 
-    std::cout << "Num extra truncations (combination): " << num_extra_truncations_combinations << std::endl;
-    std::cout << "Num extra truncations (repetition): " << num_extra_truncations_repetitions << std::endl;
+    stats << "Num extra truncations (combination): " << num_extra_truncations_combinations << std::endl;
+    stats << "Num extra truncations (repetition): " << num_extra_truncations_repetitions << std::endl;
+    pruning.print_stats(stats);
+    budget.print_stats(stats);
 
     return factor_count;
 }
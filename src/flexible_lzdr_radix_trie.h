@@ -3,7 +3,17 @@
 #include "slice.h"
 
 #include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
 
-size_t flexible_lzdr_radix_trie(Slice input, bool check_decompressed_equals_input);
+// If compressed_output is not null, the compressed data is appended to it.
+// If max_candidates is not 0, only the max_candidates longest factor lengths are tested at each position
+// (the longest factor is always tested, so max_candidates = 1 is the greedy LZDR factorization).
+// If time_budget_seconds is not 0, even fewer candidate lengths are tested when the parsing falls behind the budget
+// (see std_flexible_lzdr_radix_trie_internal::CandidateBudget). The stats are printed to stats.
+size_t flexible_lzdr_radix_trie(Slice input, bool check_decompressed_equals_input,
+                                std::vector<uint8_t> *compressed_output = nullptr, size_t max_candidates = 0,
+                                double time_budget_seconds = 0, std::ostream &stats = std::cout);
 
 #endif //FLEXIBLE_LZDR_RADIX_TRIE_H
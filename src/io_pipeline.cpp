@@ -0,0 +1,184 @@
+#include "io_pipeline.h"
+#include "slice.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <unistd.h>
+
+namespace {
+    // Spins shortly, then sleeps with growing pauses, so a waiting thread does not take the core of a busy one
+    template<typename Predicate>
+    void wait_until(const Predicate &predicate) {
+        std::chrono::microseconds pause(10);
+        for (size_t i = 0; !predicate(); ++i) {
+            if (i < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(pause);
+                pause = std::min(pause * 2, std::chrono::microseconds(1000));
+            }
+        }
+    }
+}
+
+PipelinedInput::PipelinedInput(const int fd, const size_t size, const size_t block_size) : buffer(size) {
+    if (block_size == 0) {
+        throw std::out_of_range("Block size must be greater than 0");
+    }
+    reader = std::thread([this, fd, block_size] {
+        size_t offset = 0;
+        while (offset < buffer.size()) {
+            const ssize_t num_read = ::read(fd, buffer.data() + offset, std::min(block_size, buffer.size() - offset));
+            if (num_read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (num_read < 0) {
+                failed.store(true, std::memory_order_release);
+                break;
+            }
+            if (num_read == 0) {
+                break;
+            }
+            offset += static_cast<size_t>(num_read);
+            num_available_bytes.store(offset, std::memory_order_release);
+        }
+        finished.store(true, std::memory_order_release);
+    });
+}
+
+PipelinedInput::~PipelinedInput() {
+    reader.join();
+}
+
+size_t PipelinedInput::wait_for(const size_t num_bytes) const {
+    wait_until([this, num_bytes] {
+        return num_available_bytes.load(std::memory_order_acquire) >= num_bytes || finished.load(std::memory_order_acquire);
+    });
+    if (failed.load(std::memory_order_acquire)) {
+        throw std::runtime_error("I/O error while reading");
+    }
+    return num_available_bytes.load(std::memory_order_acquire);
+}
+
+bool PipelinedInput::may_have_more_than(const size_t num_bytes) const {
+    // The number of bytes is published before finished, so it is final once finished is seen
+    return !finished.load(std::memory_order_acquire) || num_available_bytes.load(std::memory_order_acquire) > num_bytes;
+}
+
+size_t PipelinedInput::size() const {
+    return buffer.size();
+}
+
+Slice PipelinedInput::data(const size_t num_bytes) const {
+    return {buffer.data(), num_bytes};
+}
+
+PipelinedOutput::PipelinedOutput(std::function<void(Slice)> consume, const size_t block_size)
+    : consume(std::move(consume)), block_size(block_size) {
+    if (block_size == 0) {
+        throw std::out_of_range("Block size must be greater than 0");
+    }
+    for (std::vector<uint8_t> &buffer: buffers) {
+        buffer.reserve(block_size);
+    }
+    consumer = std::thread([this] {
+        size_t num_consumed = 0;
+        while (true) {
+            wait_until([this, num_consumed] {
+                return num_filled_buffers.load(std::memory_order_acquire) > num_consumed || closed.load(std::memory_order_acquire);
+            });
+            // The last buffer is handed over before closing, so it is visible once closed is
+            if (num_filled_buffers.load(std::memory_order_acquire) == num_consumed) {
+                break;
+            }
+            std::vector<uint8_t> &buffer = buffers[num_consumed % NUM_BUFFERS];
+            // After a failure, the buffers are only drained, so the producer does not wait forever
+            if (!failed.load(std::memory_order_relaxed)) {
+                try {
+                    this->consume(Slice(buffer));
+                } catch (...) {
+                    error = std::current_exception();
+                    failed.store(true, std::memory_order_release);
+                }
+            }
+            buffer.clear();
+            ++num_consumed;
+            num_consumed_buffers.store(num_consumed, std::memory_order_release);
+        }
+    });
+}
+
+PipelinedOutput::PipelinedOutput(const int fd, const size_t block_size) : PipelinedOutput([fd](const Slice block) {
+    size_t offset = 0;
+    while (offset < block.size()) {
+        const ssize_t num_bytes = ::write(fd, block.data() + offset, block.size() - offset);
+        if (num_bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (num_bytes <= 0) {
+            throw std::runtime_error("I/O error while writing");
+        }
+        offset += static_cast<size_t>(num_bytes);
+    }
+}, block_size) {
+}
+
+PipelinedOutput::~PipelinedOutput() {
+    if (consumer.joinable()) {
+        closed.store(true, std::memory_order_release);
+        consumer.join();
+    }
+}
+
+std::vector<uint8_t> &PipelinedOutput::current_buffer() {
+    // The buffer may still be consumed from the previous round
+    const size_t num_filled = num_filled_buffers.load(std::memory_order_relaxed);
+    wait_until([this, num_filled] {
+        return num_filled - num_consumed_buffers.load(std::memory_order_acquire) < NUM_BUFFERS;
+    });
+    return buffers[num_filled % NUM_BUFFERS];
+}
+
+void PipelinedOutput::hand_over_current_buffer() {
+    num_filled_buffers.store(num_filled_buffers.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void PipelinedOutput::write(const uint8_t *data, size_t size) {
+    while (size > 0) {
+        std::vector<uint8_t> &buffer = current_buffer();
+        const size_t num_bytes = std::min(size, block_size - buffer.size());
+        buffer.insert(buffer.end(), data, data + num_bytes);
+        data += num_bytes;
+        size -= num_bytes;
+        if (buffer.size() == block_size) {
+            hand_over_current_buffer();
+        }
+    }
+}
+
+bool PipelinedOutput::has_failed() const {
+    return failed.load(std::memory_order_acquire);
+}
+
+void PipelinedOutput::finish() {
+    // After the first call (which may have rethrown), only the exception is rethrown again
+    if (consumer.joinable()) {
+        if (!current_buffer().empty()) {
+            hand_over_current_buffer();
+        }
+        closed.store(true, std::memory_order_release);
+        consumer.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef IO_PIPELINE_H
+#define IO_PIPELINE_H
+#include "slice.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Reads a file of known size on a reader thread in blocks of block_size bytes, so the factorization can start on
+// the first block while the rest is read. The buffer is allocated once, so slices of it stay valid.
+// The number of bytes read so far is published with an atomic (one producer, one consumer): the consumer never
+// takes a lock and only waits if it has caught up with the reader.
+class PipelinedInput {
+    std::vector<uint8_t> buffer;
+    std::atomic<size_t> num_available_bytes = 0;
+    std::atomic<bool> finished = false;
+    std::atomic<bool> failed = false;
+    std::thread reader;
+
+public:
+    // Reads size bytes from the file descriptor fd (which is not closed). If the file is shorter, the input ends early
+    PipelinedInput(int fd, size_t size, size_t block_size);
+
+    PipelinedInput(const PipelinedInput &) = delete;
+    PipelinedInput &operator=(const PipelinedInput &) = delete;
+
+    ~PipelinedInput();
+
+    // Waits until at least num_bytes bytes have been read or the reader is finished.
+    // Returns the number of bytes read so far, throws std::runtime_error if reading failed
+    size_t wait_for(size_t num_bytes) const;
+
+    // False if the reader is finished and read at most num_bytes bytes
+    [[nodiscard]] bool may_have_more_than(size_t num_bytes) const;
+
+    // Size of the buffer (the number of bytes expected)
+    [[nodiscard]] size_t size() const;
+
+    // The first num_bytes bytes, which have to be read already
+    [[nodiscard]] Slice data(size_t num_bytes) const;
+};
+
+// Hands blocks of block_size bytes to a consumer on its own thread (e.g. a writer).
+// Full blocks are handed over through a ring of NUM_BUFFERS buffers with atomic counters of the filled and consumed
+// buffers (one producer, one consumer), so the producer only waits if the consumer is NUM_BUFFERS blocks behind.
+class PipelinedOutput {
+    static constexpr size_t NUM_BUFFERS = 3;
+
+    std::function<void(Slice)> consume;
+    size_t block_size;
+    std::array<std::vector<uint8_t>, NUM_BUFFERS> buffers;
+    std::atomic<size_t> num_filled_buffers = 0;
+    std::atomic<size_t> num_consumed_buffers = 0;
+    std::atomic<bool> closed = false;
+    // Set after error, which is only written by the consumer thread
+    std::atomic<bool> failed = false;
+    std::exception_ptr error;
+    std::thread consumer;
+
+    // Waits until the consumer is done with the buffer to fill next
+    std::vector<uint8_t> &current_buffer();
+
+    void hand_over_current_buffer();
+
+public:
+    // Calls consume with every block on the consumer thread. Once consume throws, the remaining blocks are dropped
+    PipelinedOutput(std::function<void(Slice)> consume, size_t block_size);
+
+    // Writes the blocks to the file descriptor fd, which is not closed
+    PipelinedOutput(int fd, size_t block_size);
+
+    PipelinedOutput(const PipelinedOutput &) = delete;
+    PipelinedOutput &operator=(const PipelinedOutput &) = delete;
+
+    ~PipelinedOutput();
+
+    void write(const uint8_t *data, size_t size);
+
+    // True if consume has thrown (finish rethrows it)
+    [[nodiscard]] bool has_failed() const;
+
+    // Hands over the rest and waits for the consumer, rethrows the exception of consume
+    // (std::runtime_error if writing to a file descriptor failed). Calling it again only rethrows the exception
+    void finish();
+};
+
+#endif //IO_PIPELINE_H
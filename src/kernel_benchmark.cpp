@@ -0,0 +1,50 @@
+#include "kernel_benchmark.h"
+#include "mismatch.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+void run_kernel_benchmark() {
+    constexpr size_t BYTES_PER_RUN = size_t{1} << 28;
+    constexpr size_t LENGTHS[] = {4, 8, 16, 32, 64, 256, 4096, 65536};
+
+    mismatch_internal::NamedKernel kernels[4];
+    const size_t num_kernels = mismatch_internal::supported_kernels(kernels);
+    std::cout << "Selected kernel: " << kernels[num_kernels - 1].name << std::endl;
+
+    for (const size_t length: LENGTHS) {
+        // Equal except for the last byte, so every comparison runs over the whole length.
+        // The offset of b makes the loads unaligned like in the trie walks.
+        std::vector<uint8_t> a(length);
+        std::vector<uint8_t> b(length + 1);
+        for (size_t i = 0; i < length; ++i) {
+            a[i] = static_cast<uint8_t>(i * 31);
+            b[i + 1] = a[i];
+        }
+        b[length] = static_cast<uint8_t>(a[length - 1] + 1);
+        const size_t num_calls = BYTES_PER_RUN / length;
+
+        std::cout << "Length " << length << std::endl;
+        for (size_t k = 0; k < num_kernels; ++k) {
+            size_t sink = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t call = 0; call < num_calls; ++call) {
+                sink += kernels[k].kernel(a.data(), b.data() + 1, length);
+                // Keep the compiler from hoisting the call out of the loop
+                asm volatile("" : "+r"(sink) : : "memory");
+            }
+            const auto end = std::chrono::steady_clock::now();
+            if (sink != num_calls * (length - 1)) {
+                std::cerr << "Kernel " << kernels[k].name << " returned a wrong result" << std::endl;
+            }
+            const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            std::cout << "  " << std::left << std::setw(10) << kernels[k].name << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(10) << ns / static_cast<double>(num_calls) << " ns/call"
+                      << std::setw(10) << static_cast<double>(BYTES_PER_RUN) / ns << " GB/s" << std::endl;
+        }
+    }
+}
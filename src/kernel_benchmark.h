@@ -0,0 +1,8 @@
+#ifndef KERNEL_BENCHMARK_H
+#define KERNEL_BENCHMARK_H
+
+// Measures the throughput of all mismatch kernels supported by the CPU
+// for several comparison lengths and prints the results
+void run_kernel_benchmark();
+
+#endif //KERNEL_BENCHMARK_H
@@ -5,11 +5,25 @@
 #include "radix_trie.h"
 
 #include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
 
-size_t lzd_plus_linear_time(Slice input, bool check_decompressed_equals_input);
+// If compressed_output is not null, the compressed data is appended to it. The stats are printed to stats.
+size_t lzd_plus_linear_time(Slice input, bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output = nullptr,
+                            std::ostream &stats = std::cout);
+
+// Factorizes 16-bit or 32-bit symbols instead of bytes (see lzdr_linear_time)
+size_t lzd_plus_linear_time(BasicSlice<uint16_t> input, bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output = nullptr,
+                            std::ostream &stats = std::cout);
+
+size_t lzd_plus_linear_time(BasicSlice<uint32_t> input, bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output = nullptr,
+                            std::ostream &stats = std::cout);
 
 namespace lzd_plus_linear_time_internal {
-    NextFactorResult2 next_longest_factor(const Slice &rest_input, RadixTrie &previous_factors);
+    // Defined for bytes, uint16_t and uint32_t symbols
+    template<typename Symbol>
+    BasicNextFactorResult2<Symbol> next_longest_factor(const BasicSlice<Symbol> &rest_input, BasicRadixTrie<Symbol> &previous_factors);
 }
 
 #endif //LZD_PLUS_LINEAR_TIME_H
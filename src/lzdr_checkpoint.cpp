@@ -0,0 +1,290 @@
+#include "lzdr_checkpoint.h"
+#include "flat_radix_trie.h"
+#include "lzdr_linear_time.h"
+#include "radix_trie.h"
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr char CHECKPOINT_MAGIC[8] = {'L', 'Z', 'D', 'R', 'C', 'K', 'P', 'T'};
+    constexpr uint32_t CHECKPOINT_VERSION = 1;
+    constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    // Read-only memory mapping of a whole file, so only the parts of the tries that are walked get read
+    class MappedFile {
+        void *mapping = nullptr;
+        size_t mapping_size = 0;
+
+    public:
+        explicit MappedFile(const std::string &path) {
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Could not open " + path);
+            }
+            struct stat file_stat = {};
+            if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+                close(fd);
+                throw std::runtime_error("Could not read " + path);
+            }
+            mapping_size = static_cast<size_t>(file_stat.st_size);
+            mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (mapping == MAP_FAILED) {
+                throw std::runtime_error("Could not map " + path);
+            }
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile() {
+            munmap(mapping, mapping_size);
+        }
+
+        [[nodiscard]] const uint8_t *data() const {
+            return static_cast<const uint8_t *>(mapping);
+        }
+
+        [[nodiscard]] size_t size() const {
+            return mapping_size;
+        }
+    };
+
+    struct Layer {
+        size_t offset;
+        size_t size;
+    };
+
+    // Returns 0 if the file does not exist
+    size_t file_size(const std::string &path) {
+        struct stat file_stat = {};
+        if (stat(path.c_str(), &file_stat) != 0) {
+            return 0;
+        }
+        return static_cast<size_t>(file_stat.st_size);
+    }
+
+    void write_all(const int fd, const uint8_t *data, size_t size, const std::string &path) {
+        while (size > 0) {
+            const ssize_t written = write(fd, data, size);
+            if (written <= 0) {
+                throw std::runtime_error("I/O error while writing " + path);
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    void pwrite_all(const int fd, const uint8_t *data, size_t size, size_t offset, const std::string &path) {
+        while (size > 0) {
+            const ssize_t written = pwrite(fd, data, size, static_cast<off_t>(offset));
+            if (written <= 0) {
+                throw std::runtime_error("I/O error while writing " + path);
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<size_t>(written);
+        }
+    }
+
+    // Opens the file at path (created if it does not exist), calls write_contents with it and flushes it to disk
+    void update_file(const std::string &path, const std::function<void(int)> &write_contents) {
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open " + path);
+        }
+        try {
+            write_contents(fd);
+            if (fsync(fd) != 0) {
+                throw std::runtime_error("I/O error while writing " + path);
+            }
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+    }
+
+    void truncate_file(const int fd, const size_t size, const std::string &path) {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            throw std::runtime_error("I/O error while writing " + path);
+        }
+    }
+
+    // Writes the file at path + ".tmp" with write_contents and renames it to path,
+    // so an interrupted write leaves the previous file at path intact
+    void replace_file(const std::string &path, const std::function<void(int)> &write_contents) {
+        const std::string temp_path = path + ".tmp";
+        const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open " + temp_path);
+        }
+        try {
+            write_contents(fd);
+            if (fsync(fd) != 0) {
+                throw std::runtime_error("I/O error while writing " + temp_path);
+            }
+        } catch (...) {
+            close(fd);
+            unlink(temp_path.c_str());
+            throw;
+        }
+        close(fd);
+        if (rename(temp_path.c_str(), path.c_str()) != 0) {
+            unlink(temp_path.c_str());
+            throw std::runtime_error("Could not replace " + path);
+        }
+    }
+
+    // The journal of a checkpoint update: the new header, the offset of the first changed layer in the checkpoint,
+    // then the changed layers up to the end of the checkpoint
+    struct JournalHeader {
+        LzdrCheckpointHeader checkpoint_header;
+        uint64_t layers_offset;
+    };
+
+    // Writes the journal to a temporary file and renames it, so it only exists once it is complete
+    void write_journal(const std::string &journal_path, const JournalHeader &journal_header, const std::vector<uint8_t> &layers) {
+        replace_file(journal_path, [&](const int fd) {
+            write_all(fd, reinterpret_cast<const uint8_t *>(&journal_header), sizeof(journal_header), journal_path);
+            write_all(fd, layers.data(), layers.size(), journal_path);
+        });
+    }
+
+    // Copies the journal (if any) into the checkpoint and removes it. Repeating this after an interruption
+    // gives the same checkpoint
+    void apply_journal(const std::string &journal_path, const std::string &checkpoint_path) {
+        if (file_size(journal_path) == 0) {
+            return;
+        }
+        const MappedFile journal(journal_path);
+        JournalHeader journal_header = {};
+        if (journal.size() < sizeof(journal_header)) {
+            throw std::runtime_error("Checkpoint journal truncated");
+        }
+        std::memcpy(&journal_header, journal.data(), sizeof(journal_header));
+        if (std::memcmp(journal_header.checkpoint_header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+            journal_header.checkpoint_header.version != CHECKPOINT_VERSION ||
+            journal_header.checkpoint_header.byte_order_mark != BYTE_ORDER_MARK ||
+            journal_header.layers_offset < sizeof(LzdrCheckpointHeader)) {
+            throw std::runtime_error("Unsupported checkpoint journal");
+        }
+        const size_t layers_size = journal.size() - sizeof(journal_header);
+        update_file(checkpoint_path, [&](const int fd) {
+            pwrite_all(fd, journal.data() + sizeof(journal_header), layers_size, journal_header.layers_offset, checkpoint_path);
+            truncate_file(fd, journal_header.layers_offset + layers_size, checkpoint_path);
+            pwrite_all(fd, reinterpret_cast<const uint8_t *>(&journal_header.checkpoint_header), sizeof(LzdrCheckpointHeader), 0,
+                       checkpoint_path);
+        });
+        if (unlink(journal_path.c_str()) != 0) {
+            throw std::runtime_error("Could not remove " + journal_path);
+        }
+    }
+}
+
+size_t lzdr_append(const std::string &path, const Slice input) {
+    const std::string checkpoint_path = path + ".ckpt";
+    const std::string journal_path = path + ".ckpt.journal";
+    // Finish the checkpoint update of an append that was interrupted after its journal was written
+    apply_journal(journal_path, checkpoint_path);
+    const size_t compressed_size = file_size(path);
+
+    LzdrCheckpointHeader header = {{}, CHECKPOINT_VERSION, BYTE_ORDER_MARK, 0, 0, 0};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    std::vector<uint8_t> compressed;
+    std::vector<uint8_t> new_layer;
+    size_t num_new_factors;
+    // Offset of the first layer that is replaced (the layers before it are not touched)
+    size_t new_layer_offset = sizeof(LzdrCheckpointHeader);
+    size_t num_kept_layers = 0;
+    {
+        std::vector<FlatRadixTrie> layer_tries;
+        std::vector<Layer> layers;
+        std::unique_ptr<MappedFile> checkpoint;
+        if (file_size(checkpoint_path) > 0) {
+            checkpoint = std::make_unique<MappedFile>(checkpoint_path);
+            if (checkpoint->size() < sizeof(LzdrCheckpointHeader)) {
+                throw std::runtime_error("Checkpoint truncated");
+            }
+            std::memcpy(&header, checkpoint->data(), sizeof(header));
+            if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+                header.version != CHECKPOINT_VERSION || header.byte_order_mark != BYTE_ORDER_MARK) {
+                throw std::runtime_error("Unsupported checkpoint version or byte order");
+            }
+            // A longer compressed file ends with the records of an append that was interrupted before its checkpoint
+            // was written, they are dropped
+            if (header.compressed_size > compressed_size) {
+                throw std::runtime_error("Checkpoint does not match " + path);
+            }
+            size_t offset = sizeof(LzdrCheckpointHeader);
+            for (uint64_t i = 0; i < header.num_layers; ++i) {
+                const size_t size = FlatRadixTrie::serialized_size(checkpoint->data() + offset, checkpoint->size() - offset);
+                layer_tries.emplace_back(checkpoint->data() + offset, size);
+                layers.push_back({offset, size});
+                offset += size;
+            }
+        } else if (compressed_size > 0) {
+            throw std::runtime_error("No checkpoint for " + path);
+        }
+
+        std::vector<const FlatRadixTrie *> layer_trie_pointers;
+        for (const FlatRadixTrie &layer_trie: layer_tries) {
+            layer_trie_pointers.push_back(&layer_trie);
+        }
+        RadixTrie new_factors;
+        num_new_factors = lzdr_linear_time_continued(input, layer_trie_pointers, header.num_factors, new_factors, &compressed);
+        if (num_new_factors == 0 && checkpoint != nullptr && header.compressed_size == compressed_size) {
+            return 0;
+        }
+        if (num_new_factors > 0) {
+            FlatRadixTrie::serialize(new_factors, new_layer);
+        }
+
+        // Merge the newest layers while the older one is at most twice as large
+        while (num_new_factors > 0 && !layers.empty() && layers.back().size <= 2 * new_layer.size()) {
+            RadixTrie merged;
+            layer_tries.back().merge_into(merged);
+            FlatRadixTrie(new_layer.data(), new_layer.size()).merge_into(merged);
+            std::vector<uint8_t> merged_layer;
+            FlatRadixTrie::serialize(merged, merged_layer);
+            new_layer = std::move(merged_layer);
+            layer_tries.pop_back();
+            layers.pop_back();
+        }
+        num_kept_layers = layers.size();
+        if (!layers.empty()) {
+            new_layer_offset = layers.back().offset + layers.back().size;
+        }
+        // The mapping of the checkpoint ends here, before the checkpoint is written
+    }
+
+    // The new records are appended in place, after dropping the records of an interrupted append. If this append is
+    // interrupted before its journal is written, the checkpoint still has the previous compressed size
+    const size_t previous_compressed_size = header.compressed_size;
+    update_file(path, [&](const int fd) {
+        truncate_file(fd, previous_compressed_size, path);
+        pwrite_all(fd, compressed.data(), compressed.size(), previous_compressed_size, path);
+    });
+
+    // Only the header and the replaced layers of the checkpoint are written, first to the journal
+    header.num_factors += num_new_factors;
+    header.compressed_size = previous_compressed_size + compressed.size();
+    header.num_layers = num_kept_layers + (new_layer.empty() ? 0 : 1);
+    write_journal(journal_path, {header, new_layer_offset}, new_layer);
+    apply_journal(journal_path, checkpoint_path);
+    return num_new_factors;
+}
@@ -0,0 +1,41 @@
+#ifndef LZDR_CHECKPOINT_H
+#define LZDR_CHECKPOINT_H
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Appendable LZDR compressed files.
+//
+// The state of the factorization is kept in a checkpoint file next to the compressed file (path + ".ckpt").
+// It consists of layers of flat radix tries, where each append adds the trie of its new factors as a layer.
+// The newest layers are merged as long as a layer is not much larger than the next newer one,
+// so there are only logarithmically many layers and the factorization of n appended bytes costs about as much as
+// compressing n bytes (amortized). Neither file is copied: the new records are appended to the compressed file, and
+// only the header and the merged newest layers of the checkpoint are rewritten. They are written to a journal
+// (path + ".ckpt.journal") first, which the next append copies into the checkpoint if the update was interrupted.
+//
+// File layout (all integers in native byte order):
+//   LzdrCheckpointHeader
+//   FlatRadixTrie[num_layers] (oldest layer first)
+struct LzdrCheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    // Used to detect checkpoints written on a machine with another byte order
+    uint32_t byte_order_mark;
+    // The number of factors of the compressed file
+    uint64_t num_factors;
+    // Used to detect checkpoints that do not belong to the compressed file
+    uint64_t compressed_size;
+    uint64_t num_layers;
+};
+
+// Compresses input and appends it to the LZDR compressed file at path (both files are created if path does not
+// exist, even for an empty input), then updates the checkpoint. Records after the compressed size of the checkpoint
+// belong to an interrupted append and are truncated.
+// Throws std::runtime_error if the checkpoint is missing or does not match.
+// Returns the number of new factors
+size_t lzdr_append(const std::string &path, Slice input);
+
+#endif //LZDR_CHECKPOINT_H
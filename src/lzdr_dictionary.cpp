@@ -0,0 +1,169 @@
+#include "lzdr_dictionary.h"
+#include "flat_radix_trie.h"
+#include "lzdr_linear_time.h"
+#include "radix_trie.h"
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr char DICTIONARY_MAGIC[8] = {'L', 'Z', 'D', 'R', 'D', 'I', 'C', 'T'};
+    constexpr uint32_t DICTIONARY_VERSION = 1;
+    constexpr char DICTIONARY_DATA_MAGIC[8] = {'L', 'Z', 'D', 'R', 'D', 'D', 'A', 'T'};
+    constexpr uint32_t DICTIONARY_DATA_VERSION = 1;
+    constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    uint64_t fnv1a(const uint8_t *data, const size_t size) {
+        uint64_t hash = FNV_OFFSET_BASIS;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ data[i]) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    const LzdrDictionaryHeader *checked_header(const uint8_t *data, const size_t size) {
+        if (size < sizeof(LzdrDictionaryHeader)) {
+            throw std::runtime_error("Dictionary truncated");
+        }
+        const auto *header = reinterpret_cast<const LzdrDictionaryHeader *>(data);
+        if (std::memcmp(header->magic, DICTIONARY_MAGIC, sizeof(DICTIONARY_MAGIC)) != 0) {
+            throw std::runtime_error("Not a dictionary");
+        }
+        if (header->version != DICTIONARY_VERSION || header->byte_order_mark != BYTE_ORDER_MARK) {
+            throw std::runtime_error("Unsupported dictionary version or byte order");
+        }
+        return header;
+    }
+}
+
+LzdrDictionary::LzdrDictionary(const uint8_t *mapped_data, const size_t data_size, const bool is_mapped, std::vector<uint8_t> bytes)
+    // Moving bytes keeps its buffer, so data stays valid
+    : data(is_mapped ? mapped_data : bytes.data()), size(data_size), mapped(is_mapped), owned_data(std::move(bytes)),
+      dictionary_hash(fnv1a(data, size)), header(checked_header(data, size)),
+      flat_trie(data + sizeof(LzdrDictionaryHeader), size - sizeof(LzdrDictionaryHeader)) {
+    const size_t trie_size = FlatRadixTrie::serialized_size(data + sizeof(LzdrDictionaryHeader), size - sizeof(LzdrDictionaryHeader));
+    const size_t rest = size - sizeof(LzdrDictionaryHeader) - trie_size;
+    if (header->num_factors > rest / (2 * sizeof(uint64_t)) || header->corpus_len > rest - header->num_factors * 2 * sizeof(uint64_t)) {
+        throw std::runtime_error("Dictionary truncated");
+    }
+    if (flat_trie.num_factor_nodes() != header->num_factors + 1) {
+        throw std::runtime_error("Dictionary trie does not match factor table");
+    }
+    factor_table = reinterpret_cast<const uint64_t *>(data + sizeof(LzdrDictionaryHeader) + trie_size);
+    corpus = reinterpret_cast<const uint8_t *>(factor_table + 2 * header->num_factors);
+    for (size_t i = 0; i < header->num_factors; ++i) {
+        if (factor_table[2 * i] > header->corpus_len || factor_table[2 * i + 1] > header->corpus_len - factor_table[2 * i]) {
+            throw std::runtime_error("Dictionary factor out of bounds");
+        }
+    }
+}
+
+LzdrDictionary::~LzdrDictionary() {
+    if (mapped) {
+        munmap(const_cast<uint8_t *>(data), size);
+    }
+}
+
+std::vector<uint8_t> LzdrDictionary::train(const Slice corpus) {
+    RadixTrie trie;
+    std::vector<std::pair<uint64_t, uint64_t> > factors;
+    size_t i = 0;
+    while (i < corpus.size()) {
+        const Slice rest_input = corpus.slice(i);
+        NextFactorResult2 longest_factor = lzdr_linear_time_internal::next_longest_factor(corpus, i, rest_input, trie);
+        // Only the last factor can already exist, it does not get a new index then
+        if (lzdr_linear_time_internal::insert_into_radix_trie(trie, longest_factor.insertion_node, longest_factor.insertion_slice)) {
+            factors.emplace_back(i, longest_factor.factor_slice.size());
+        }
+        i += longest_factor.factor_slice.size();
+    }
+
+    LzdrDictionaryHeader header = {{}, DICTIONARY_VERSION, BYTE_ORDER_MARK, factors.size(), corpus.size()};
+    std::memcpy(header.magic, DICTIONARY_MAGIC, sizeof(DICTIONARY_MAGIC));
+    std::vector<uint8_t> out(reinterpret_cast<const uint8_t *>(&header), reinterpret_cast<const uint8_t *>(&header) + sizeof(header));
+    FlatRadixTrie::serialize(trie, out);
+    for (const auto &[offset, length]: factors) {
+        const uint64_t entry[2] = {offset, length};
+        out.insert(out.end(), reinterpret_cast<const uint8_t *>(entry), reinterpret_cast<const uint8_t *>(entry) + sizeof(entry));
+    }
+    out.insert(out.end(), corpus.data(), corpus.data() + corpus.size());
+    return out;
+}
+
+LzdrDictionary LzdrDictionary::open(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open dictionary " + path);
+    }
+    struct stat file_stat = {};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+        close(fd);
+        throw std::runtime_error("Could not read dictionary " + path);
+    }
+    const auto size = static_cast<size_t>(file_stat.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not map dictionary " + path);
+    }
+    try {
+        return LzdrDictionary(static_cast<const uint8_t *>(mapping), size, true, {});
+    } catch (...) {
+        munmap(mapping, size);
+        throw;
+    }
+}
+
+LzdrDictionary LzdrDictionary::from_bytes(std::vector<uint8_t> bytes) {
+    const size_t size = bytes.size();
+    return LzdrDictionary(nullptr, size, false, std::move(bytes));
+}
+
+Slice LzdrDictionary::factor(const size_t index) const {
+    if (index == 0 || index > header->num_factors) {
+        throw std::out_of_range("Invalid dictionary factor");
+    }
+    return {corpus + factor_table[2 * (index - 1)], factor_table[2 * (index - 1) + 1]};
+}
+
+void append_dictionary_data_header(std::vector<uint8_t> &out, const LzdrDictionary &dictionary) {
+    LzdrDictionaryDataHeader header = {{}, DICTIONARY_DATA_VERSION, BYTE_ORDER_MARK, dictionary.num_factors(), dictionary.hash()};
+    std::memcpy(header.magic, DICTIONARY_DATA_MAGIC, sizeof(DICTIONARY_DATA_MAGIC));
+    out.insert(out.end(), reinterpret_cast<const uint8_t *>(&header), reinterpret_cast<const uint8_t *>(&header) + sizeof(header));
+}
+
+bool is_lzdr_dictionary_data(const std::vector<uint8_t> &compressed) {
+    return compressed.size() >= sizeof(DICTIONARY_DATA_MAGIC) &&
+           std::memcmp(compressed.data(), DICTIONARY_DATA_MAGIC, sizeof(DICTIONARY_DATA_MAGIC)) == 0;
+}
+
+void check_dictionary_data_header(const std::vector<uint8_t> &compressed, const LzdrDictionary *dictionary) {
+    LzdrDictionaryDataHeader header = {};
+    if (!is_lzdr_dictionary_data(compressed) || compressed.size() < sizeof(header)) {
+        throw std::runtime_error("Not compressed with a dictionary");
+    }
+    std::memcpy(&header, compressed.data(), sizeof(header));
+    if (header.version != DICTIONARY_DATA_VERSION || header.byte_order_mark != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Unsupported version or byte order of the data compressed with a dictionary");
+    }
+    if (dictionary == nullptr) {
+        throw std::runtime_error("Compressed with a dictionary (of " + std::to_string(header.num_factors) + " factors)");
+    }
+    if (header.num_factors != dictionary->num_factors() || header.dictionary_hash != dictionary->hash()) {
+        throw std::runtime_error("Compressed with another dictionary (of " + std::to_string(header.num_factors) + " factors)");
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef LZDR_DICTIONARY_H
+#define LZDR_DICTIONARY_H
+#include "flat_radix_trie.h"
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Pre-trained LZDR dictionary: the factor trie and the factors of a sample corpus.
+// Compressing with a dictionary starts with factors 1 to num_factors() already known,
+// so new factors are numbered from num_factors() + 1.
+//
+// File layout (all integers in native byte order):
+//   LzdrDictionaryHeader
+//   FlatRadixTrie
+//   {uint64_t offset, uint64_t length}[num_factors] (factor i is corpus[offset, offset + length))
+//   uint8_t[corpus_len]
+struct LzdrDictionaryHeader {
+    char magic[8];
+    uint32_t version;
+    // Used to detect dictionaries written on a machine with another byte order
+    uint32_t byte_order_mark;
+    uint64_t num_factors;
+    uint64_t corpus_len;
+};
+
+// Header of data compressed with a dictionary, so it is only decompressed with the same dictionary
+struct LzdrDictionaryDataHeader {
+    char magic[8];
+    uint32_t version;
+    // Used to detect files written on a machine with another byte order
+    uint32_t byte_order_mark;
+    uint64_t num_factors;
+    // See LzdrDictionary::hash
+    uint64_t dictionary_hash;
+};
+
+class LzdrDictionary {
+    // Either a memory-mapped file or owned_data
+    const uint8_t *data;
+    size_t size;
+    bool mapped;
+    std::vector<uint8_t> owned_data;
+    uint64_t dictionary_hash;
+
+    const LzdrDictionaryHeader *header;
+    FlatRadixTrie flat_trie;
+    const uint64_t *factor_table;
+    const uint8_t *corpus;
+
+    // mapped_data is used if is_mapped, otherwise bytes
+    LzdrDictionary(const uint8_t *mapped_data, size_t data_size, bool is_mapped, std::vector<uint8_t> bytes);
+
+public:
+    LzdrDictionary(const LzdrDictionary &) = delete;
+    LzdrDictionary &operator=(const LzdrDictionary &) = delete;
+    ~LzdrDictionary();
+
+    // Factorizes corpus and returns the serialized dictionary
+    static std::vector<uint8_t> train(Slice corpus);
+
+    // Memory-maps the dictionary file, throws std::runtime_error on failure
+    static LzdrDictionary open(const std::string &path);
+
+    static LzdrDictionary from_bytes(std::vector<uint8_t> bytes);
+
+    [[nodiscard]] const FlatRadixTrie &trie() const {
+        return flat_trie;
+    }
+
+    [[nodiscard]] size_t num_factors() const {
+        return header->num_factors;
+    }
+
+    // Returns factor index (1-based index as in the compressed data)
+    [[nodiscard]] Slice factor(size_t index) const;
+
+    // FNV-1a hash of the serialized dictionary
+    [[nodiscard]] uint64_t hash() const {
+        return dictionary_hash;
+    }
+};
+
+// Appends the LzdrDictionaryDataHeader of dictionary
+void append_dictionary_data_header(std::vector<uint8_t> &out, const LzdrDictionary &dictionary);
+
+// Returns true if compressed starts with the magic of data compressed with a dictionary
+bool is_lzdr_dictionary_data(const std::vector<uint8_t> &compressed);
+
+// Throws std::runtime_error if the header of the data compressed with a dictionary is malformed
+// or dictionary (which may be null) is not the dictionary it was compressed with
+void check_dictionary_data_header(const std::vector<uint8_t> &compressed, const LzdrDictionary *dictionary);
+
+#endif //LZDR_DICTIONARY_H
@@ -1,17 +1,29 @@
 #include "lzdr_linear_time.h"
+#include "factor_search.h"
+#include "factor_stream.h"
+#include "flat_radix_trie.h"
+#include "io_pipeline.h"
+#include "lzdr_dictionary.h"
+#include "lzdr_verifier.h"
 #include "slice.h"
 #include "radix_trie.h"
+#include "small_alphabet.h"
+#include "suffix_array.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <list>
 #include <memory>
 #include <optional>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -25,390 +37,190 @@
 //   4: Truncation: factor x length
 //   5: Repetition: factor x total length
 //   6: Repetition: byte x total length
-//   7-255: undefined
+//   7: undefined
+//   8-14: Same as 0-6, but in the wide format
+//   15-255: undefined
 // byte: uint8_t
-// factor, length, repetition: uint32_t
+// factor, length, repetition: uint32_t (narrow format), uint64_t (wide format)
+//
+// The wide format is only used for records where a factor, length or repetition does not fit into an uint32_t,
+// so inputs smaller than 4 GiB are always encoded in the narrow format.
 namespace lzdr_compressor {
-    Compressor create_compressor_for_combination(const bool first_is_byte, const bool second_is_byte) {
-        size_t count = 1 + 4;
+    Compressor create_compressor_for_combination(const bool first_is_byte, const bool second_is_byte, const bool wide,
+                                                 const size_t symbol_width) {
+        const size_t field_size = wide ? 8 : 4;
+        size_t count = 1 + field_size;
         if (first_is_byte) {
-            count += 1;
+            count += symbol_width;
         } else {
-            count += 4;
+            count += field_size;
         }
         if (second_is_byte) {
-            count += 1;
+            count += symbol_width;
         } else {
-            count += 4;
+            count += field_size;
         }
+        const uint8_t wide_flag = wide ? WIDE_FORMAT_FLAG : 0;
         Compressor compressor(count);
         if (first_is_byte) {
             if (second_is_byte) {
-                compressor.write_byte(0);
+                compressor.write_byte(0 | wide_flag);
             } else {
-                compressor.write_byte(1);
+                compressor.write_byte(1 | wide_flag);
             }
         } else {
             if (second_is_byte) {
-                compressor.write_byte(2);
+                compressor.write_byte(2 | wide_flag);
             } else {
-                compressor.write_byte(3);
+                compressor.write_byte(3 | wide_flag);
             }
         }
         return compressor;
     }
 
-    Compressor create_compressor_for_truncation() {
-        constexpr size_t count = 1 + 4 + 4;
+    Compressor create_compressor_for_truncation(const bool wide) {
+        const size_t field_size = wide ? 8 : 4;
+        const size_t count = 1 + field_size + field_size;
         Compressor compressor(count);
-        compressor.write_byte(4);
+        compressor.write_byte(wide ? 4 | WIDE_FORMAT_FLAG : 4);
         return compressor;
     }
 
-    Compressor create_compressor_for_repetition(const bool is_byte) {
-        size_t count = 1 + 4;
+    Compressor create_compressor_for_repetition(const bool is_byte, const bool wide, const size_t symbol_width) {
+        const size_t field_size = wide ? 8 : 4;
+        size_t count = 1 + field_size;
         if (is_byte) {
-            count += 1;
+            count += symbol_width;
         } else {
-            count += 4;
+            count += field_size;
         }
+        const uint8_t wide_flag = wide ? WIDE_FORMAT_FLAG : 0;
         Compressor compressor(count);
         if (is_byte) {
-            compressor.write_byte(6);
+            compressor.write_byte(6 | wide_flag);
         } else {
-            compressor.write_byte(5);
+            compressor.write_byte(5 | wide_flag);
         }
         return compressor;
     }
 }
 
 namespace {
-    struct CombinationFactor {
-        size_t first_factor;
-        size_t second_factor;
-        bool first_is_byte;
-        bool second_is_byte;
-        size_t length;
-        bool used_extra_truncation;
-        RadixTrieNode* insertion_node;
-        size_t first_node_length;
-    };
-    struct TruncationFactor {
-        size_t factor_index;
-        size_t length;
-        RadixTrieNode* insertion_node;
-        size_t last_node_length;
-    };
-    struct RepetitionFactor {
-        size_t factor;
-        bool factor_is_byte;
-        size_t factor_length;
-        size_t total_length;
-        RadixTrieNode* insertion_node;
-    };
-
-    NextFactorResult2 combination_factor_to_result(const Slice &rest_input, const CombinationFactor &factor) {
-        Compressor compressor = lzdr_compressor::create_compressor_for_combination(factor.first_is_byte, factor.second_is_byte);
-        if (factor.first_is_byte) {
-            compressor.write_byte(static_cast<uint8_t>(factor.first_factor));
-        } else {
-            compressor.write_u32(static_cast<uint32_t>(factor.first_factor));
-        }
-        if (factor.second_is_byte) {
-            compressor.write_byte(static_cast<uint8_t>(factor.second_factor));
-        } else {
-            compressor.write_u32(static_cast<uint32_t>(factor.second_factor));
-        }
-        compressor.write_u32(static_cast<uint32_t>(factor.length));
-        const Slice insertion_slice = rest_input.slice(factor.first_node_length, factor.length - factor.first_node_length);
-        return NextFactorResult2{rest_input.slice(0, factor.length), std::move(compressor.data()), factor.used_extra_truncation, factor.insertion_node, insertion_slice};
-    }
-
-    NextFactorResult2 truncation_factor_to_result(const Slice &rest_input, const TruncationFactor &factor) {
-        Compressor compressor = lzdr_compressor::create_compressor_for_truncation();
-        compressor.write_u32(static_cast<uint32_t>(factor.factor_index));
-        compressor.write_u32(static_cast<uint32_t>(factor.length));
-        const Slice insertion_slice = rest_input.slice(factor.last_node_length, factor.length - factor.last_node_length);
-        return NextFactorResult2{rest_input.slice(0, factor.length), std::move(compressor.data()), false, factor.insertion_node, insertion_slice};
-    }
-
-    NextFactorResult2 repetition_factor_to_result(const Slice &rest_input, const RepetitionFactor &factor) {
-        Compressor compressor = lzdr_compressor::create_compressor_for_repetition(factor.factor_is_byte);
-        if (factor.factor_is_byte) {
-            compressor.write_byte(static_cast<uint8_t>(factor.factor));
-        } else {
-            compressor.write_u32(static_cast<uint32_t>(factor.factor));
-        }
-        compressor.write_u32(static_cast<uint32_t>(factor.total_length));
-        const bool used_extra_truncation = factor.total_length % factor.factor_length != 0;
-        const Slice insertion_slice = factor.factor_is_byte ? rest_input.slice(0, factor.total_length) : rest_input.slice(factor.factor_length, factor.total_length - factor.factor_length);
-        NextFactorResult2 result = {rest_input.slice(0, factor.total_length), std::move(compressor.data()), used_extra_truncation, factor.insertion_node, insertion_slice};
-        return result;
-    }
+    constexpr char SYMBOLS_MAGIC[8] = {'L', 'Z', 'D', 'R', 'S', 'Y', 'M', 'B'};
+    constexpr uint32_t SYMBOLS_VERSION = 1;
+    constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    using factor_search::CombinationFactor;
+    using factor_search::TruncationFactor;
+    using factor_search::RepetitionFactor;
+    using factor_search::combination_factor_to_result;
+    using factor_search::truncation_factor_to_result;
+    using factor_search::repetition_factor_to_result;
+    using factor_search::naive_lce;
 
     NextFactorResult combination_factor_to_result_trunc(const Slice &rest_input, const CombinationFactor &factor, const size_t usable_len) {
         const size_t total_length = std::min(factor.length, usable_len);
-        Compressor compressor = lzdr_compressor::create_compressor_for_combination(factor.first_is_byte, factor.second_is_byte);
+        const bool wide = requires_wide_format(std::max({factor.first_factor, factor.second_factor, total_length}));
+        Compressor compressor = lzdr_compressor::create_compressor_for_combination(factor.first_is_byte, factor.second_is_byte, wide);
         if (factor.first_is_byte) {
             compressor.write_byte(static_cast<uint8_t>(factor.first_factor));
         } else {
-            compressor.write_u32(static_cast<uint32_t>(factor.first_factor));
+            compressor.write_uint(factor.first_factor, wide);
         }
         if (factor.second_is_byte) {
             compressor.write_byte(static_cast<uint8_t>(factor.second_factor));
         } else {
-            compressor.write_u32(static_cast<uint32_t>(factor.second_factor));
+            compressor.write_uint(factor.second_factor, wide);
         }
-        compressor.write_u32(static_cast<uint32_t>(total_length));
+        compressor.write_uint(total_length, wide);
         const bool used_extra_truncation = factor.used_extra_truncation || total_length != factor.length;
         return NextFactorResult{rest_input.slice(0, total_length), std::move(compressor.data()), used_extra_truncation};
     }
 
     NextFactorResult truncation_factor_to_result_trunc(const Slice &rest_input, const TruncationFactor &factor, const size_t usable_len) {
         const size_t total_length = std::min(factor.length, usable_len);
-        Compressor compressor = lzdr_compressor::create_compressor_for_truncation();
-        compressor.write_u32(static_cast<uint32_t>(factor.factor_index));
-        compressor.write_u32(static_cast<uint32_t>(total_length));
+        const bool wide = requires_wide_format(std::max(factor.factor_index, total_length));
+        Compressor compressor = lzdr_compressor::create_compressor_for_truncation(wide);
+        compressor.write_uint(factor.factor_index, wide);
+        compressor.write_uint(total_length, wide);
         return NextFactorResult{rest_input.slice(0, total_length), std::move(compressor.data()), false};
     }
 
     NextFactorResult repetition_factor_to_result_trunc(const Slice &rest_input, const RepetitionFactor &factor, const size_t usable_len) {
         const size_t total_length = std::min(factor.total_length, usable_len);
-        Compressor compressor = lzdr_compressor::create_compressor_for_repetition(factor.factor_is_byte);
+        const bool wide = requires_wide_format(std::max(factor.factor, total_length));
+        Compressor compressor = lzdr_compressor::create_compressor_for_repetition(factor.factor_is_byte, wide);
         if (factor.factor_is_byte) {
             compressor.write_byte(static_cast<uint8_t>(factor.factor));
         } else {
-            compressor.write_u32(static_cast<uint32_t>(factor.factor));
+            compressor.write_uint(factor.factor, wide);
         }
-        compressor.write_u32(static_cast<uint32_t>(total_length));
+        compressor.write_uint(total_length, wide);
         const bool used_extra_truncation = total_length % factor.factor_length != 0;
         NextFactorResult result = {rest_input.slice(0, total_length), std::move(compressor.data()), used_extra_truncation};
         return result;
     }
-
-    size_t naive_lce(const Slice &s, size_t start1, size_t start2) {
-        size_t total = 0;
-        while (start1 < s.size() && start2 < s.size() && s[start1] == s[start2]) {
-            total += 1;
-            ++start1;
-            ++start2;
-        }
-        return total;
-    }
 }
 
 namespace lzdr_linear_time_internal {
     // This method requires rest_input to be not empty!
-    NextFactorResult2 next_longest_factor(
-        const Slice &entire_input, const size_t bytes_already_read,
-        const Slice &rest_input, RadixTrie &previous_factors) {
-        // Current nodes
-        RadixTrieNode* current_node = &previous_factors.root_node;
-        RadixTrieEdge* current_edge = nullptr;
-        bool finished_first_factor_node = false;
-        size_t edge_rest_text_index = 0;
-        // For truncation: combination first node is not always same, as truncation allows splitting nodes
-        size_t truncation_last_node_length = 0;
-
-        // Factors
-        // Note: The combination factor is initialized with second_factor=0 and second_is_byte=false
-        //       so that the second factor is empty by default in case only one factor is needed for the input.
-        //       The same is done for the first factor to check if it has been initialized,
-        //       that fact will later be used in the while loop.
-        CombinationFactor combination_factor = {0, 0, false, false, 0, false, &previous_factors.root_node, 0};
-        std::optional<TruncationFactor> truncation_factor = std::nullopt;
-        // Initialize repetition factor with maximized single character repetition via LCE
-        RepetitionFactor repetition_factor = {rest_input[0], true, 1, 1 + naive_lce(entire_input, bytes_already_read, bytes_already_read + 1), &previous_factors.root_node};
-
-        // Maximize factors
-        size_t input_i = 0;
-        while (input_i < rest_input.size()) {
-            uint8_t current_byte = rest_input[input_i];
-            bool is_last_byte = input_i == rest_input.size() - 1;
+    template<typename Symbol>
+    BasicNextFactorResult2<Symbol> next_longest_factor(
+        const BasicSlice<Symbol> &entire_input, const size_t bytes_already_read,
+        const BasicSlice<Symbol> &rest_input, BasicRadixTrie<Symbol> &previous_factors) {
+        const factor_search::BasicFactorCandidates<Symbol> candidates = factor_search::search_factor_candidates<
+            factor_search::Policy<true, true, BasicRadixTrie<Symbol> > >(
+            entire_input, bytes_already_read, rest_input, rest_input.size(), previous_factors);
 
-            // Update combination factor if the current factor is uninitialized,
-            // as a combination factor allows one single byte.
-            // (We do this eagerly instead of doing this in the case where the edge from the root node does not exist,
-            // as it is possible that an edge from the root node exists, but a factor node is never reached)
-            if (!finished_first_factor_node) {
-                if (combination_factor.first_factor == 0 && !combination_factor.first_is_byte) {
-                    combination_factor.first_factor = current_byte;
-                    combination_factor.first_is_byte = true;
-                    combination_factor.length = input_i + 1;
-                }
-            } else {
-                if (combination_factor.second_factor == 0 && !combination_factor.second_is_byte) {
-                    combination_factor.second_factor = current_byte;
-                    combination_factor.second_is_byte = true;
-                    combination_factor.length = input_i + 1;
-                }
+        // Return the one that yields the maximum length
+        // (where ties are broken such that combination is the preferred method
+        // and repetition is preferred least)
+        BasicNextFactorResult2<Symbol> longest_factor = combination_factor_to_result(rest_input, candidates.combination);
+        if (candidates.truncation) {
+            if (BasicNextFactorResult2<Symbol> truncation_result = truncation_factor_to_result(rest_input, *candidates.truncation);
+                truncation_result.factor_slice.size() > longest_factor.factor_slice.size()) {
+                longest_factor = truncation_result;
             }
+        }
+        if (BasicNextFactorResult2<Symbol> repetition_result = repetition_factor_to_result(rest_input, candidates.repetition);
+            repetition_result.factor_slice.size() > longest_factor.factor_slice.size()) {
+            longest_factor = repetition_result;
+        }
+        return longest_factor;
+    }
 
-            if (current_edge == nullptr) {
-                // Currently, we are exactly at a node
-                if (auto it = current_node->edges.find(current_byte); it != current_node->edges.end()) {
-                    // Edge exists
-                    // The current byte got successfully read, therefore increase input_i
-                    ++input_i;
-
-                    RadixTrieEdge& edge = it->second;
-
-                    // Update truncation factor / second combination factor
-                    // (We do this eagerly instead of waiting for the first mismatch,
-                    // as there is no guarantee a mismatch will happen if the input ends early)
-                    if (!finished_first_factor_node) {
-                        if (edge.rest_text.empty()) {
-                            truncation_factor = std::make_optional(TruncationFactor{edge.end_node.next_factor_node_index, input_i, &edge.end_node, input_i});
-                        } else {
-                            truncation_factor = std::make_optional(TruncationFactor{edge.end_node.next_factor_node_index, input_i, current_node, truncation_last_node_length});
-                        }
-                    } else {
-                        // Make sure to not overwrite single byte second factor
-                        // with truncated factor, when truncated length is the same
-                        if (input_i > combination_factor.length) {
-                            combination_factor.second_factor = edge.end_node.next_factor_node_index;
-                            combination_factor.second_is_byte = false;
-                            combination_factor.length = input_i;
-                            combination_factor.used_extra_truncation = true;
-                        }
-                    }
-
-                    if (edge.rest_text.empty()) {
-                        // Go directly to next node
-                        current_node = &edge.end_node;
-                        truncation_last_node_length = input_i;
-
-                        if (current_node->index != 0) {
-                            // Update first combination factor
-                            if (!finished_first_factor_node) {
-                                combination_factor.first_factor = current_node->index;
-                                combination_factor.first_is_byte = false;
-                                combination_factor.length = input_i;
-                                combination_factor.insertion_node = current_node;
-                                combination_factor.first_node_length = input_i;
-                            } else {
-                                // This branch is only used to track extra truncations
-                                combination_factor.used_extra_truncation = false;
-                            }
-
-                            // Update repetition factor
-                            if (!finished_first_factor_node) {
-                                if (const size_t repetition_len = input_i + naive_lce(entire_input, bytes_already_read, bytes_already_read + input_i); repetition_len > repetition_factor.total_length) {
-                                    repetition_factor = RepetitionFactor{current_node->index, false, input_i, repetition_len, current_node};
-                                }
-                            }
-                        }
-                    } else {
-                        // Update edge
-                        current_edge = &edge;
-                        edge_rest_text_index = 0;
-                    }
-                } else {
-                    // Edge does not exist
-                    // We were unable to read the byte, therefore do not increase input_i
-                    if (!finished_first_factor_node) {
-                        // Move on to second factor
-                        finished_first_factor_node = true;
-                        current_node = &previous_factors.root_node;
-                        // Second factor begins after end of first factor
-                        input_i = combination_factor.length;
-                        continue;
-                    } else {
-                        // Second factor finished, break loop
-                        break;
-                    }
-                }
-            } else {
-                // We have to iterate over edge text
-                if (current_edge->rest_text[edge_rest_text_index] == current_byte) {
-                    // The current byte got successfully read, therefore increase input_i
-                    ++input_i;
-                    // Move to next index of edge rest text
-                    ++edge_rest_text_index;
-
-                    // Update truncation factor / second combination factor
-                    // (We do this eagerly instead of waiting for the first mismatch,
-                    // as there is no guarantee a mismatch will happen if the input ends early)
-                    if (!finished_first_factor_node) {
-                        if (edge_rest_text_index == current_edge->rest_text.size()) {
-                            truncation_factor = std::make_optional(TruncationFactor{current_edge->end_node.next_factor_node_index, input_i, &current_edge->end_node, input_i});
-                        } else {
-                            truncation_factor = std::make_optional(TruncationFactor{current_edge->end_node.next_factor_node_index, input_i, current_node, truncation_last_node_length});
-                        }
-                    } else {
-                        combination_factor.second_factor = current_edge->end_node.next_factor_node_index;
-                        combination_factor.second_is_byte = false;
-                        combination_factor.length = input_i;
-                        combination_factor.used_extra_truncation = true;
-                    }
-
-                    if (edge_rest_text_index == current_edge->rest_text.size()) {
-                        // Reached end of edge rest text, go to next node
-                        current_node = &current_edge->end_node;
-                        current_edge = nullptr;
-                        truncation_last_node_length = input_i;
-
-                        if (current_node->index != 0) {
-                            // Update first combination factor
-                            if (!finished_first_factor_node) {
-                                combination_factor.first_factor = current_node->index;
-                                combination_factor.first_is_byte = false;
-                                combination_factor.length = input_i;
-                                combination_factor.insertion_node = current_node;
-                                combination_factor.first_node_length = input_i;
-                            } else {
-                                // This branch is only used to track extra truncations
-                                combination_factor.used_extra_truncation = false;
-                            }
-
-                            // Update repetition factor
-                            if (!finished_first_factor_node) {
-                                if (const size_t repetition_len = input_i + naive_lce(entire_input, bytes_already_read, bytes_already_read + input_i); repetition_len > repetition_factor.total_length) {
-                                    repetition_factor = RepetitionFactor{current_node->index, false, input_i, repetition_len, current_node};
-                                }
-                            }
-                        }
-                    }
-                } else {
-                    // We were unable to read the byte, therefore do not increase input_i
-                    if (!finished_first_factor_node) {
-                        // Move on to second factor
-                        finished_first_factor_node = true;
-                        current_node = &previous_factors.root_node;
-                        current_edge = nullptr;
-                        // Second factor begins after end of first factor
-                        input_i = combination_factor.length;
-                        continue;
-                    } else {
-                        // Second factor finished, break loop
-                        break;
-                    }
-                }
-            }
+    template NextFactorResult2 next_longest_factor(const Slice &, size_t, const Slice &, RadixTrie &);
+    template BasicNextFactorResult2<uint16_t> next_longest_factor(const BasicSlice<uint16_t> &, size_t, const BasicSlice<uint16_t> &,
+                                                                  BasicRadixTrie<uint16_t> &);
+    template BasicNextFactorResult2<uint32_t> next_longest_factor(const BasicSlice<uint32_t> &, size_t, const BasicSlice<uint32_t> &,
+                                                                  BasicRadixTrie<uint32_t> &);
+    template BasicNextFactorResult2<RankSymbol<2> > next_longest_factor(const BasicSlice<RankSymbol<2> > &, size_t,
+                                                                        const BasicSlice<RankSymbol<2> > &, BasicRadixTrie<RankSymbol<2> > &);
+    template BasicNextFactorResult2<RankSymbol<3> > next_longest_factor(const BasicSlice<RankSymbol<3> > &, size_t,
+                                                                        const BasicSlice<RankSymbol<3> > &, BasicRadixTrie<RankSymbol<3> > &);
+    template BasicNextFactorResult2<RankSymbol<4> > next_longest_factor(const BasicSlice<RankSymbol<4> > &, size_t,
+                                                                        const BasicSlice<RankSymbol<4> > &, BasicRadixTrie<RankSymbol<4> > &);
+    template BasicNextFactorResult2<RankSymbol<5> > next_longest_factor(const BasicSlice<RankSymbol<5> > &, size_t,
+                                                                        const BasicSlice<RankSymbol<5> > &, BasicRadixTrie<RankSymbol<5> > &);
 
-            // Account for the case that we reached the last byte while searching for the
-            // first combination factor
-            if (!finished_first_factor_node && is_last_byte) {
-                // Move on to second factor
-                finished_first_factor_node = true;
-                current_node = &previous_factors.root_node;
-                current_edge = nullptr;
-                // Second factor begins after end of first factor
-                input_i = combination_factor.length;
-            }
-        }
+    NextFactorResult next_longest_factor_counted_trie(
+        const Slice &entire_input, const size_t bytes_already_read,
+        const Slice &rest_input, const size_t usable_rest_input_len,
+        CountedRadixTrie &previous_factors) {
+        const factor_search::FactorCandidates candidates = factor_search::search_factor_candidates<factor_search::CountedLzdrPolicy>(
+            entire_input, bytes_already_read, rest_input, usable_rest_input_len, previous_factors);
 
         // Return the one that yields the maximum length
         // (where ties are broken such that combination is the preferred method
         // and repetition is preferred least)
-        NextFactorResult2 longest_factor = combination_factor_to_result(rest_input, combination_factor);
-        if (truncation_factor) {
-            if (NextFactorResult2 truncation_result = truncation_factor_to_result(rest_input, *truncation_factor);
+        NextFactorResult longest_factor = combination_factor_to_result_trunc(rest_input, candidates.combination, usable_rest_input_len);
+        if (candidates.truncation) {
+            if (NextFactorResult truncation_result = truncation_factor_to_result_trunc(rest_input, *candidates.truncation, usable_rest_input_len);
                 truncation_result.factor_slice.size() > longest_factor.factor_slice.size()) {
                 longest_factor = truncation_result;
             }
         }
-        if (NextFactorResult2 repetition_result = repetition_factor_to_result(rest_input, repetition_factor);
+        if (NextFactorResult repetition_result = repetition_factor_to_result_trunc(rest_input, candidates.repetition, usable_rest_input_len);
             repetition_result.factor_slice.size() > longest_factor.factor_slice.size()) {
             longest_factor = repetition_result;
         }
@@ -416,39 +228,35 @@ namespace lzdr_linear_time_internal {
     }
 
     // This method requires rest_input to be not empty!
-    // Basically a copy of the above method, just with `Counted` added.
-    // This method should be kept in sync with the normal method.
-    NextFactorResult next_longest_factor_counted_trie(
+    // Computes the same factor as next_longest_factor, but uses LCE queries on the entire input
+    // to skip over edge rest texts and to maximize repetitions.
+    // This works since every edge rest text of the trie is a slice of the entire input.
+    // The trie is still walked node by node with one lookup per node, so a factor costs time linear in the number of
+    // trie nodes on its path (which is at most its length), only the bytes of the edge rest texts are not compared.
+    // This method should be kept in sync with next_longest_factor.
+    template<typename Lce>
+    NextFactorResult2 next_longest_factor_lce(
         const Slice &entire_input, const size_t bytes_already_read,
-        const Slice &rest_input, const size_t usable_rest_input_len,
-        CountedRadixTrie &previous_factors) {
+        const Slice &rest_input, RadixTrie &previous_factors, const Lce &lce) {
         // Current nodes
-        CountedRadixTrieNode* current_node = &previous_factors.root_node;
-        CountedRadixTrieEdge* current_edge = nullptr;
+        RadixTrieNode* current_node = &previous_factors.root_node;
         bool finished_first_factor_node = false;
-        std::optional<std::list<uint8_t>::iterator> edge_rest_text_iter = std::nullopt;
-        bool optimalRepetitionFactorFound = false;
-
-        // Factors
-        // Note: The combination factor is initialized with second_factor=0 and second_is_byte=false
-        //       so that the second factor is empty by default in case only one factor is needed for the input.
-        //       The same is done for the first factor to check if it has been initialized,
-        //       that fact will later be used in the while loop.
-        CombinationFactor combination_factor = {0, 0, false, false, 0, false};
+        // For truncation: combination first node is not always same, as truncation allows splitting nodes
+        size_t truncation_last_node_length = 0;
+
+        // Factors (see next_longest_factor)
+        CombinationFactor combination_factor = {0, 0, false, false, 0, false, &previous_factors.root_node, 0};
         std::optional<TruncationFactor> truncation_factor = std::nullopt;
         // Initialize repetition factor with maximized single character repetition via LCE
-        RepetitionFactor repetition_factor = {rest_input[0], true, 1, 1 + naive_lce(entire_input, bytes_already_read, bytes_already_read + 1)};
+        RepetitionFactor repetition_factor = {rest_input[0], true, 1, 1 + lce.lce(bytes_already_read, bytes_already_read + 1), &previous_factors.root_node};
 
         // Maximize factors
         size_t input_i = 0;
         while (input_i < rest_input.size()) {
             uint8_t current_byte = rest_input[input_i];
-            bool is_last_byte = input_i == rest_input.size() - 1;
 
             // Update combination factor if the current factor is uninitialized,
             // as a combination factor allows one single byte.
-            // (We do this eagerly instead of doing this in the case where the edge from the root node does not exist,
-            // as it is possible that an edge from the root node exists, but a factor node is never reached)
             if (!finished_first_factor_node) {
                 if (combination_factor.first_factor == 0 && !combination_factor.first_is_byte) {
                     combination_factor.first_factor = current_byte;
@@ -463,168 +271,97 @@ namespace lzdr_linear_time_internal {
                 }
             }
 
-            if (current_edge == nullptr) {
-                // Currently, we are exactly at a node
-                if (auto it = current_node->edges.find(current_byte); it != current_node->edges.end()) {
-                    // Edge exists
-                    // The current byte got successfully read, therefore increase input_i
-                    ++input_i;
-
-                    CountedRadixTrieEdge& edge = it->second;
-
-                    // Update truncation factor / second combination factor
-                    // (We do this eagerly instead of waiting for the first mismatch,
-                    // as there is no guarantee a mismatch will happen if the input ends early)
-                    if (!finished_first_factor_node) {
-                        truncation_factor = std::make_optional(TruncationFactor{edge.end_node.next_factor_node_index, input_i});
-                    } else {
-                        // Make sure to not overwrite single byte second factor
-                        // with truncated factor, when truncated length is the same
-                        if (input_i > combination_factor.length) {
-                            combination_factor.second_factor = edge.end_node.next_factor_node_index;
-                            combination_factor.second_is_byte = false;
-                            combination_factor.length = input_i;
-                            combination_factor.used_extra_truncation = true;
-                        }
-                    }
-
-                    if (edge.rest_text.empty()) {
-                        // Go directly to next node
-                        current_node = &edge.end_node;
-
-                        if (current_node->index != 0) {
-                            // Update first combination factor
-                            if (!finished_first_factor_node) {
-                                combination_factor.first_factor = current_node->index;
-                                combination_factor.first_is_byte = false;
-                                combination_factor.length = input_i;
-                            } else {
-                                // This branch is only used to track extra truncations
-                                combination_factor.used_extra_truncation = false;
-
-                                // Avoid truncation with longer second combination factor and use this instead
-                                // Useful for Flexible algorithms
-                                if (input_i == usable_rest_input_len) {
-                                    break;
-                                }
-                            }
+            // Currently, we are always exactly at a node
+            auto it = current_node->edges.find(current_byte);
+            if (it == current_node->edges.end()) {
+                // Edge does not exist
+                if (!finished_first_factor_node) {
+                    // Move on to second factor
+                    finished_first_factor_node = true;
+                    current_node = &previous_factors.root_node;
+                    // Second factor begins after end of first factor
+                    input_i = combination_factor.length;
+                    continue;
+                }
+                // Second factor finished, break loop
+                break;
+            }
+            RadixTrieEdge& edge = it->second;
+
+            // Read the first byte and as much of the edge rest text as possible at once
+            ++input_i;
+            const size_t rest_text_len = edge.rest_text.size();
+            size_t matched = 0;
+            if (rest_text_len > 0 && input_i < rest_input.size()) {
+                const size_t rest_text_pos = edge.rest_text.data() - entire_input.data();
+                matched = std::min({rest_text_len, rest_input.size() - input_i, lce.lce(bytes_already_read + input_i, rest_text_pos)});
+            }
+            input_i += matched;
 
-                            // Update repetition factor
-                            if (!finished_first_factor_node) {
-                                if (!optimalRepetitionFactorFound) {
-                                    if (const size_t repetition_len = input_i + naive_lce(entire_input, bytes_already_read, bytes_already_read + input_i);
-                                        repetition_len > repetition_factor.total_length || ((repetition_len == repetition_factor.total_length || repetition_len >= usable_rest_input_len) && std::min(repetition_factor.total_length, usable_rest_input_len) % repetition_factor.factor_length != 0 && std::min(repetition_len, usable_rest_input_len) % input_i == 0)) {
-                                        repetition_factor = RepetitionFactor{current_node->index, false, input_i, repetition_len};
-                                        if (repetition_len >= usable_rest_input_len && usable_rest_input_len % input_i == 0) {
-                                            optimalRepetitionFactorFound = true;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    } else {
-                        // Update edge
-                        current_edge = &edge;
-                        edge_rest_text_iter = std::make_optional(edge.rest_text.begin());
-                    }
+            // Update truncation factor / second combination factor
+            const bool reached_end_node = matched == rest_text_len;
+            if (!finished_first_factor_node) {
+                if (reached_end_node) {
+                    truncation_factor = std::make_optional(TruncationFactor{edge.end_node.next_factor_node_index, input_i, &edge.end_node, input_i});
                 } else {
-                    // Edge does not exist
-                    // We were unable to read the byte, therefore do not increase input_i
-                    if (!finished_first_factor_node) {
-                        // Move on to second factor
-                        finished_first_factor_node = true;
-                        current_node = &previous_factors.root_node;
-                        // Second factor begins after end of first factor
-                        input_i = combination_factor.length;
-                        continue;
-                    } else {
-                        // Second factor finished, break loop
-                        break;
-                    }
+                    truncation_factor = std::make_optional(TruncationFactor{edge.end_node.next_factor_node_index, input_i, current_node, truncation_last_node_length});
                 }
             } else {
-                // We have to iterate over edge text
-                if (**edge_rest_text_iter == current_byte) {
-                    // The current byte got successfully read, therefore increase input_i
-                    ++input_i;
+                // Make sure to not overwrite single byte second factor
+                // with truncated factor, when truncated length is the same
+                if (input_i > combination_factor.length) {
+                    combination_factor.second_factor = edge.end_node.next_factor_node_index;
+                    combination_factor.second_is_byte = false;
+                    combination_factor.length = input_i;
+                    combination_factor.used_extra_truncation = true;
+                }
+            }
 
-                    // Update truncation factor / second combination factor
-                    // (We do this eagerly instead of waiting for the first mismatch,
-                    // as there is no guarantee a mismatch will happen if the input ends early)
+            if (reached_end_node) {
+                // Go to next node
+                current_node = &edge.end_node;
+                truncation_last_node_length = input_i;
+
+                if (current_node->index != 0) {
+                    // Update first combination factor
                     if (!finished_first_factor_node) {
-                        truncation_factor = std::make_optional(TruncationFactor{current_edge->end_node.next_factor_node_index, input_i});
-                    } else {
-                        combination_factor.second_factor = current_edge->end_node.next_factor_node_index;
-                        combination_factor.second_is_byte = false;
+                        combination_factor.first_factor = current_node->index;
+                        combination_factor.first_is_byte = false;
                         combination_factor.length = input_i;
-                        combination_factor.used_extra_truncation = true;
+                        combination_factor.insertion_node = current_node;
+                        combination_factor.first_node_length = input_i;
+                    } else {
+                        // This branch is only used to track extra truncations
+                        combination_factor.used_extra_truncation = false;
                     }
 
-                    // Move to next element in iterator
-                    ++(*edge_rest_text_iter);
-                    if (*edge_rest_text_iter == current_edge->rest_text.end()) {
-                        // Reached end of iterator, go to next node
-                        current_node = &current_edge->end_node;
-                        current_edge = nullptr;
-                        edge_rest_text_iter = std::nullopt;
-
-                        if (current_node->index != 0) {
-                            // Update first combination factor
-                            if (!finished_first_factor_node) {
-                                combination_factor.first_factor = current_node->index;
-                                combination_factor.first_is_byte = false;
-                                combination_factor.length = input_i;
-                            } else {
-                                // This branch is only used to track extra truncations
-                                combination_factor.used_extra_truncation = false;
-
-                                // Avoid truncation with longer second combination factor and use this instead
-                                // Useful for Flexible algorithms
-                                if (input_i == usable_rest_input_len) {
-                                    break;
-                                }
-                            }
-
-                            // Update repetition factor
-                            if (!finished_first_factor_node) {
-                                if (!optimalRepetitionFactorFound) {
-                                    if (const size_t repetition_len = input_i + naive_lce(entire_input, bytes_already_read, bytes_already_read + input_i);
-                                        repetition_len > repetition_factor.total_length || ((repetition_len == repetition_factor.total_length || repetition_len >= usable_rest_input_len) && std::min(repetition_factor.total_length, usable_rest_input_len) % repetition_factor.factor_length != 0 && std::min(repetition_len, usable_rest_input_len) % input_i == 0)) {
-                                        repetition_factor = RepetitionFactor{current_node->index, false, input_i, repetition_len};
-                                        if (repetition_len >= usable_rest_input_len && usable_rest_input_len % input_i == 0) {
-                                            optimalRepetitionFactorFound = true;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                } else {
-                    // We were unable to read the byte, therefore do not increase input_i
+                    // Update repetition factor
                     if (!finished_first_factor_node) {
-                        // Move on to second factor
-                        finished_first_factor_node = true;
-                        current_node = &previous_factors.root_node;
-                        current_edge = nullptr;
-                        edge_rest_text_iter = std::nullopt;
-                        // Second factor begins after end of first factor
-                        input_i = combination_factor.length;
-                        continue;
-                    } else {
-                        // Second factor finished, break loop
-                        break;
+                        if (const size_t repetition_len = input_i + lce.lce(bytes_already_read, bytes_already_read + input_i); repetition_len > repetition_factor.total_length) {
+                            repetition_factor = RepetitionFactor{current_node->index, false, input_i, repetition_len, current_node};
+                        }
                     }
                 }
+            } else if (input_i < rest_input.size()) {
+                // Mismatch on the edge rest text
+                if (!finished_first_factor_node) {
+                    // Move on to second factor
+                    finished_first_factor_node = true;
+                    current_node = &previous_factors.root_node;
+                    // Second factor begins after end of first factor
+                    input_i = combination_factor.length;
+                    continue;
+                }
+                // Second factor finished, break loop
+                break;
             }
 
             // Account for the case that we reached the last byte while searching for the
             // first combination factor
-            if (!finished_first_factor_node && is_last_byte) {
+            if (!finished_first_factor_node && input_i == rest_input.size()) {
                 // Move on to second factor
                 finished_first_factor_node = true;
                 current_node = &previous_factors.root_node;
-                current_edge = nullptr;
-                edge_rest_text_iter = std::nullopt;
                 // Second factor begins after end of first factor
                 input_i = combination_factor.length;
             }
@@ -633,14 +370,14 @@ namespace lzdr_linear_time_internal {
         // Return the one that yields the maximum length
         // (where ties are broken such that combination is the preferred method
         // and repetition is preferred least)
-        NextFactorResult longest_factor = combination_factor_to_result_trunc(rest_input, combination_factor, usable_rest_input_len);
+        NextFactorResult2 longest_factor = combination_factor_to_result(rest_input, combination_factor);
         if (truncation_factor) {
-            if (NextFactorResult truncation_result = truncation_factor_to_result_trunc(rest_input, *truncation_factor, usable_rest_input_len);
+            if (NextFactorResult2 truncation_result = truncation_factor_to_result(rest_input, *truncation_factor);
                 truncation_result.factor_slice.size() > longest_factor.factor_slice.size()) {
                 longest_factor = truncation_result;
             }
         }
-        if (NextFactorResult repetition_result = repetition_factor_to_result_trunc(rest_input, repetition_factor, usable_rest_input_len);
+        if (NextFactorResult2 repetition_result = repetition_factor_to_result(rest_input, repetition_factor);
             repetition_result.factor_slice.size() > longest_factor.factor_slice.size()) {
             longest_factor = repetition_result;
         }
@@ -649,16 +386,29 @@ namespace lzdr_linear_time_internal {
 
     // Returns true if a new factor node got created or a splitting node got turned into a factor node, otherwise false.
     // In other words: true if did not already exist in radix trie, otherwise false.
-    bool insert_into_radix_trie(RadixTrie &trie, RadixTrieNode *from_node, const Slice &insert) {
+    template<typename Symbol>
+    bool insert_into_radix_trie(BasicRadixTrie<Symbol> &trie, BasicRadixTrieNode<Symbol> *from_node, const BasicSlice<Symbol> &insert) {
         // Current nodes
-        RadixTrieNode* current_node = from_node;
-        RadixTrieEdge* current_edge = nullptr;
+        BasicRadixTrieNode<Symbol>* current_node = from_node;
+        BasicRadixTrieEdge<Symbol>* current_edge = nullptr;
         size_t edge_rest_text_index = 0;
 
         // Insert
         size_t input_i = 0;
         while (input_i < insert.size()) {
-            uint8_t current_byte = insert[input_i];
+            if (current_edge != nullptr) {
+                // Skip the matching bytes of the edge rest text at once,
+                // as long as they neither end the edge nor the inserted text
+                const size_t skip = std::min({
+                    current_edge->rest_text.slice(edge_rest_text_index).common_prefix_length(insert.slice(input_i)),
+                    current_edge->rest_text.size() - edge_rest_text_index - 1,
+                    insert.size() - input_i - 1
+                });
+                input_i += skip;
+                edge_rest_text_index += skip;
+            }
+
+            Symbol current_byte = insert[input_i];
             bool is_last_byte = input_i == insert.size() - 1;
 
             if (current_edge == nullptr) {
@@ -668,7 +418,7 @@ namespace lzdr_linear_time_internal {
                     // The current byte got successfully read, therefore increase input_i
                     ++input_i;
 
-                    RadixTrieEdge& edge = it->second;
+                    BasicRadixTrieEdge<Symbol>& edge = it->second;
                     if (edge.rest_text.empty()) {
                         // Go directly to next node
                         current_node = &edge.end_node;
@@ -692,30 +442,35 @@ namespace lzdr_linear_time_internal {
                             // Since this is the last matching byte, the rest text needs to be split off
                             // and a new factor node needs to be inserted before it.
                             // Move the complete edge rest text into a temporary variable.
-                            Slice old_edge_rest_text = current_edge->rest_text;
-                            current_edge->rest_text = Slice::create_empty();
+                            BasicSlice<Symbol> old_edge_rest_text = current_edge->rest_text;
+                            current_edge->rest_text = BasicSlice<Symbol>::create_empty();
 
                             // Get first byte as old rest edge byte and remove from front
                             // This will always work since we know the rest text is not empty
-                            uint8_t old_rest_edge_byte = old_edge_rest_text[0];
+                            Symbol old_rest_edge_byte = old_edge_rest_text[0];
                             old_edge_rest_text = old_edge_rest_text.slice(1);
 
                             // Get edges from edge end node
-                            std::unordered_map<uint8_t, RadixTrieEdge> temp_edges = std::move(current_edge->end_node.edges);
+                            auto temp_edges = std::move(current_edge->end_node.edges);
 
                             // Remove edges from end node (reset edges after move)
                             current_edge->end_node.edges.clear();
 
                             // Add new edge with rest of current edge text
-                            RadixTrieNode copied_factor_node = current_edge->end_node.copy_without_edges();
+                            BasicRadixTrieNode<Symbol> copied_factor_node = current_edge->end_node.copy_without_edges();
                             copied_factor_node.edges = std::move(temp_edges); // reassign edges
-                            RadixTrieEdge old_rest_edge = {std::move(copied_factor_node), old_edge_rest_text};
+                            BasicRadixTrieEdge<Symbol> old_rest_edge = {std::move(copied_factor_node), old_edge_rest_text};
                             current_edge->end_node.edges.emplace(old_rest_edge_byte, std::move(old_rest_edge));
 
                             // Finally turn the edge end node into a new factor node
                             current_edge->end_node.index = trie.num_factor_nodes;
                             current_edge->end_node.next_factor_node_index = current_edge->end_node.index;
                             trie.num_factor_nodes += 1;
+                            if constexpr (std::is_same_v<Symbol, uint8_t>) {
+                                if (current_node == &trie.root_node) {
+                                    trie.update_root_jump_table(*current_node, current_byte);
+                                }
+                            }
                             return true;
                         }
 
@@ -723,10 +478,13 @@ namespace lzdr_linear_time_internal {
                     }
                 } else {
                     // Edge does not exist, create new edge with current_byte
-                    RadixTrieNode new_node = RadixTrieNode::create_factor_node(trie.num_factor_nodes);
-                    RadixTrieEdge new_edge = {std::move(new_node), insert.slice(input_i + 1)};
+                    BasicRadixTrieNode<Symbol> new_node = BasicRadixTrieNode<Symbol>::create_factor_node(trie.num_factor_nodes);
+                    BasicRadixTrieEdge<Symbol> new_edge = {std::move(new_node), insert.slice(input_i + 1)};
                     current_node->edges.emplace(current_byte, std::move(new_edge));
                     trie.num_factor_nodes += 1;
+                    if constexpr (std::is_same_v<Symbol, uint8_t>) {
+                        trie.update_root_jump_table(*current_node, current_byte);
+                    }
                     return true;
                 }
             } else {
@@ -762,24 +520,24 @@ namespace lzdr_linear_time_internal {
                             //
                             // Note, that we have already moved to the next element beforehand,
                             // so the edge_rest_text_index points to one byte after the last matching byte right now.
-                            Slice old_edge_rest_text = current_edge->rest_text.slice(edge_rest_text_index);
+                            BasicSlice<Symbol> old_edge_rest_text = current_edge->rest_text.slice(edge_rest_text_index);
                             current_edge->rest_text = current_edge->rest_text.slice(0, edge_rest_text_index);
 
                             // Get first byte after last matching byte as old rest edge byte and remove from front
                             // This will always work since we know that we had not reached the end of the slice
-                            uint8_t old_rest_edge_byte = old_edge_rest_text[0];
+                            Symbol old_rest_edge_byte = old_edge_rest_text[0];
                             old_edge_rest_text = old_edge_rest_text.slice(1);
 
                             // Get edges from edge end node
-                            std::unordered_map<uint8_t, RadixTrieEdge> temp_edges = std::move(current_edge->end_node.edges);
+                            auto temp_edges = std::move(current_edge->end_node.edges);
 
                             // Remove edges from end node (reset edges after move)
                             current_edge->end_node.edges.clear();
 
                             // Add new edge with rest of current edge text
-                            RadixTrieNode copied_factor_node = current_edge->end_node.copy_without_edges();
+                            BasicRadixTrieNode<Symbol> copied_factor_node = current_edge->end_node.copy_without_edges();
                             copied_factor_node.edges = std::move(temp_edges); // reassign edges
-                            RadixTrieEdge old_rest_edge = {std::move(copied_factor_node), old_edge_rest_text};
+                            BasicRadixTrieEdge<Symbol> old_rest_edge = {std::move(copied_factor_node), old_edge_rest_text};
                             current_edge->end_node.edges.emplace(old_rest_edge_byte, std::move(old_rest_edge));
 
                             // Finally turn the edge end node into a new factor node
@@ -792,23 +550,23 @@ namespace lzdr_linear_time_internal {
                 } else {
                     // We were unable to read the byte, therefore do not increase input_i
                     // Use slice to move everything from the first mismatching byte until the end of the edge text into old_edge_rest_text
-                    Slice old_edge_rest_text = current_edge->rest_text.slice(edge_rest_text_index);
+                    BasicSlice<Symbol> old_edge_rest_text = current_edge->rest_text.slice(edge_rest_text_index);
                     current_edge->rest_text = current_edge->rest_text.slice(0, edge_rest_text_index);
 
                     // Get first mismatch byte as old rest edge byte and remove from front
-                    uint8_t old_rest_edge_byte = old_edge_rest_text[0];
+                    Symbol old_rest_edge_byte = old_edge_rest_text[0];
                     old_edge_rest_text = old_edge_rest_text.slice(1);
 
                     // Get edges from edge end node
-                    std::unordered_map<uint8_t, RadixTrieEdge> temp_edges = std::move(current_edge->end_node.edges);
+                    auto temp_edges = std::move(current_edge->end_node.edges);
 
                     // Remove edges from end node (reset edges after move)
                     current_edge->end_node.edges.clear();
 
                     // Add new edge with rest of current edge text
-                    RadixTrieNode copied_factor_node = current_edge->end_node.copy_without_edges();
+                    BasicRadixTrieNode<Symbol> copied_factor_node = current_edge->end_node.copy_without_edges();
                     copied_factor_node.edges = std::move(temp_edges); // reassign edges
-                    RadixTrieEdge old_rest_edge = {std::move(copied_factor_node), old_edge_rest_text};
+                    BasicRadixTrieEdge<Symbol> old_rest_edge = {std::move(copied_factor_node), old_edge_rest_text};
                     current_edge->end_node.edges.emplace(old_rest_edge_byte, std::move(old_rest_edge));
 
                     // Convert end node to splitting node after creating the copied_factor_node.
@@ -817,11 +575,17 @@ namespace lzdr_linear_time_internal {
                     current_edge->end_node.index = 0;
 
                     // Add edge with rest of input
-                    Slice rest_text = insert.slice(input_i + 1);
-                    RadixTrieNode new_node = RadixTrieNode::create_factor_node(trie.num_factor_nodes);
-                    RadixTrieEdge new_edge = {std::move(new_node), rest_text};
+                    BasicSlice<Symbol> rest_text = insert.slice(input_i + 1);
+                    BasicRadixTrieNode<Symbol> new_node = BasicRadixTrieNode<Symbol>::create_factor_node(trie.num_factor_nodes);
+                    BasicRadixTrieEdge<Symbol> new_edge = {std::move(new_node), rest_text};
                     current_edge->end_node.edges.emplace(current_byte, std::move(new_edge));
                     trie.num_factor_nodes += 1;
+                    if constexpr (std::is_same_v<Symbol, uint8_t>) {
+                        // A root edge split directly after its first byte (the walk started at the root node)
+                        if (current_node == &trie.root_node && current_edge->rest_text.empty()) {
+                            trie.update_root_jump_table(*current_node, insert[0]);
+                        }
+                    }
                     return true;
                 }
             }
@@ -842,224 +606,681 @@ namespace lzdr_linear_time_internal {
             return false;
         }
     }
+
+    template bool insert_into_radix_trie(RadixTrie &, RadixTrieNode *, const Slice &);
+    template bool insert_into_radix_trie(BasicRadixTrie<uint16_t> &, BasicRadixTrieNode<uint16_t> *, const BasicSlice<uint16_t> &);
+    template bool insert_into_radix_trie(BasicRadixTrie<uint32_t> &, BasicRadixTrieNode<uint32_t> *, const BasicSlice<uint32_t> &);
+    template bool insert_into_radix_trie(BasicRadixTrie<RankSymbol<2> > &, BasicRadixTrieNode<RankSymbol<2> > *,
+                                         const BasicSlice<RankSymbol<2> > &);
+    template bool insert_into_radix_trie(BasicRadixTrie<RankSymbol<3> > &, BasicRadixTrieNode<RankSymbol<3> > *,
+                                         const BasicSlice<RankSymbol<3> > &);
+    template bool insert_into_radix_trie(BasicRadixTrie<RankSymbol<4> > &, BasicRadixTrieNode<RankSymbol<4> > *,
+                                         const BasicSlice<RankSymbol<4> > &);
+    template bool insert_into_radix_trie(BasicRadixTrie<RankSymbol<5> > &, BasicRadixTrieNode<RankSymbol<5> > *,
+                                         const BasicSlice<RankSymbol<5> > &);
 }
 
-// Returns the number of factors
-size_t lzdr_linear_time(const Slice input, const bool check_decompressed_equals_input) {
-    RadixTrie previous_factors;
-    std::vector<uint8_t> compressed_data;
-
-    size_t num_factors = 0;
-    size_t num_extra_truncations_combinations = 0;
-    size_t num_extra_truncations_repetitions = 0;
-    size_t i = 0;
-    while (i < input.size()) {
-        Slice rest_input = input.slice(i);
-        NextFactorResult2 longest_factor = lzdr_linear_time_internal::next_longest_factor(
-            input, i, rest_input, previous_factors);
-
-        if (longest_factor.used_extra_truncation) {
-            if (const uint8_t factor_type = longest_factor.compressed_data[0]; 0 <= factor_type && factor_type <= 3) {
-                num_extra_truncations_combinations += 1;
-            } else if (factor_type == 5 || factor_type == 6) {
-                num_extra_truncations_repetitions += 1;
-            } else {
-                throw std::out_of_range("Extra truncation could not be associated with factor type");
+namespace {
+    // Walks a radix trie byte by byte
+    class RadixTrieCursor {
+        RadixTrieNode *current_node;
+        RadixTrieEdge *current_edge = nullptr;
+        size_t edge_rest_text_index = 0;
+        bool alive = true;
+
+    public:
+        explicit RadixTrieCursor(RadixTrieNode *root_node) : current_node(root_node) {
+        }
+
+        [[nodiscard]] bool is_alive() const {
+            return alive;
+        }
+
+        // Returns false (and stays dead) if there is no continuation with byte
+        bool step(const uint8_t byte) {
+            if (!alive) {
+                return false;
             }
+            if (current_edge == nullptr) {
+                const auto it = current_node->edges.find(byte);
+                if (it == current_node->edges.end()) {
+                    alive = false;
+                    return false;
+                }
+                if (it->second.rest_text.empty()) {
+                    current_node = &it->second.end_node;
+                } else {
+                    current_edge = &it->second;
+                    edge_rest_text_index = 0;
+                }
+                return true;
+            }
+            if (current_edge->rest_text[edge_rest_text_index] != byte) {
+                alive = false;
+                return false;
+            }
+            ++edge_rest_text_index;
+            if (edge_rest_text_index == current_edge->rest_text.size()) {
+                current_node = &current_edge->end_node;
+                current_edge = nullptr;
+            }
+            return true;
         }
 
-        ++num_factors;
+        // Index of the factor ending here, 0 if there is none
+        [[nodiscard]] size_t factor_index() const {
+            return current_edge == nullptr ? current_node->index : 0;
+        }
 
-#ifndef NDEBUG
-        std::cout << "Factor " << num_factors << ": " << longest_factor.factor_slice << std::endl;
-#endif
+        // Index of a factor starting with the bytes read so far
+        [[nodiscard]] size_t next_factor_node_index() const {
+            return current_edge == nullptr ? current_node->next_factor_node_index : current_edge->end_node.next_factor_node_index;
+        }
+    };
 
-        i += longest_factor.factor_slice.size();
+    // Walks a flat radix trie byte by byte
+    class FlatRadixTrieCursor {
+        const FlatRadixTrie &trie;
+        const FlatRadixTrieNode *current_node;
+        const FlatRadixTrieEdge *current_edge = nullptr;
+        Slice edge_rest_text = Slice::create_empty();
+        size_t edge_rest_text_index = 0;
+        bool alive = true;
 
-        lzdr_linear_time_internal::insert_into_radix_trie(previous_factors, longest_factor.insertion_node, longest_factor.insertion_slice);
+    public:
+        explicit FlatRadixTrieCursor(const FlatRadixTrie &trie) : trie(trie), current_node(&trie.node(0)) {
+        }
 
-        if (check_decompressed_equals_input) {
-            compressed_data.insert(compressed_data.end(),
-                                   std::make_move_iterator(longest_factor.compressed_data.begin()),
-                                   std::make_move_iterator(longest_factor.compressed_data.end()));
+        [[nodiscard]] bool is_alive() const {
+            return alive;
         }
-    }
 
-    if (check_decompressed_equals_input) {
-        if (const std::vector<uint8_t> decompressed_data = lzdr_decompress(compressed_data);
-            !(input == Slice(decompressed_data))) {
-            throw std::out_of_range("Decompressed not equal to input");
+        bool step(const uint8_t byte) {
+            if (!alive) {
+                return false;
+            }
+            if (current_edge == nullptr) {
+                const FlatRadixTrieEdge *edge = trie.find_edge(*current_node, byte);
+                if (edge == nullptr) {
+                    alive = false;
+                    return false;
+                }
+                if (edge->rest_text_len == 0) {
+                    current_node = &trie.node(edge->end_node);
+                } else {
+                    current_edge = edge;
+                    edge_rest_text = trie.rest_text(*edge);
+                    edge_rest_text_index = 0;
+                }
+                return true;
+            }
+            if (edge_rest_text[edge_rest_text_index] != byte) {
+                alive = false;
+                return false;
+            }
+            ++edge_rest_text_index;
+            if (edge_rest_text_index == edge_rest_text.size()) {
+                current_node = &trie.node(current_edge->end_node);
+                current_edge = nullptr;
+            }
+            return true;
         }
-    }
 
-    std::cout << "Num extra truncations (combination): " << num_extra_truncations_combinations << std::endl;
-    std::cout << "Num extra truncations (repetition): " << num_extra_truncations_repetitions << std::endl;
+        [[nodiscard]] size_t factor_index() const {
+            return current_edge == nullptr ? current_node->index : 0;
+        }
 
-    return num_factors;
-}
+        [[nodiscard]] size_t next_factor_node_index() const {
+            return current_edge == nullptr ? current_node->next_factor_node_index : trie.node(current_edge->end_node).next_factor_node_index;
+        }
+    };
 
-std::vector<uint8_t> lzdr_decompress(const std::vector<uint8_t> &compressed) {
-    std::vector<std::vector<uint8_t> > previous_factors;
-    size_t i = 0;
-    while (i < compressed.size()) {
-        if (const uint8_t type = compressed[i]; type == 0) {
-            if (i + 6 >= compressed.size()) {
-                throw std::out_of_range("Index out of bounds");
+    // Walks the union of the (read-only) flat tries and the trie of the new factors in parallel.
+    // If several tries contain a factor, the index of the first flat trie is used.
+    class LayeredCursor {
+        std::vector<FlatRadixTrieCursor> layers;
+        RadixTrieCursor overlay;
+
+    public:
+        LayeredCursor(const std::vector<const FlatRadixTrie *> &layer_tries, RadixTrieNode *overlay_root_node)
+            : overlay(overlay_root_node) {
+            layers.reserve(layer_tries.size());
+            for (const FlatRadixTrie *layer: layer_tries) {
+                layers.emplace_back(*layer);
             }
-            std::vector factor = {compressed[i + 1], compressed[i + 2]};
-            const uint32_t length = u32_from_bytes(compressed.data() + (i + 3));
-            if (factor.size() > length) {
-                while (factor.size() > length) {
-                    factor.pop_back();
-                }
-            } else if (factor.size() < length) {
-                size_t r = 0;
-                const size_t mod_r = factor.size();
-                while (factor.size() < length) {
-                    factor.push_back(factor[r]);
-                    r = (r + 1) % mod_r;
-                }
+        }
+
+        bool step(const uint8_t byte) {
+            bool any_alive = overlay.step(byte);
+            for (FlatRadixTrieCursor &layer: layers) {
+                any_alive |= layer.step(byte);
             }
-            assert(factor.size() == length);
-            previous_factors.push_back(factor);
-            i += 7;
-        } else if (type == 1) {
-            if (i + 9 >= compressed.size()) {
-                throw std::out_of_range("Index out of bounds");
+            return any_alive;
+        }
+
+        [[nodiscard]] size_t factor_index() const {
+            for (const FlatRadixTrieCursor &layer: layers) {
+                if (layer.is_alive() && layer.factor_index() != 0) {
+                    return layer.factor_index();
+                }
             }
-            std::vector factor = {compressed[i + 1]};
-            if (const uint32_t second_factor = u32_from_bytes(compressed.data() + (i + 2)); second_factor != 0) {
-                for (const uint8_t byte: previous_factors[second_factor - 1]) {
-                    factor.push_back(byte);
+            return overlay.is_alive() ? overlay.factor_index() : 0;
+        }
+
+        [[nodiscard]] size_t next_factor_node_index() const {
+            for (const FlatRadixTrieCursor &layer: layers) {
+                if (layer.is_alive()) {
+                    return layer.next_factor_node_index();
                 }
             }
-            const uint32_t length = u32_from_bytes(compressed.data() + (i + 6));
-            if (factor.size() > length) {
-                while (factor.size() > length) {
-                    factor.pop_back();
+            return overlay.next_factor_node_index();
+        }
+    };
+
+    // This method requires rest_input to be not empty!
+    // Computes the same factor as next_longest_factor on the union of the flat tries (e.g. of a dictionary)
+    // and the trie of the new factors. The walk is done byte by byte, as the tries have different edges.
+    // The returned factor has to be inserted as a whole from the root node of the trie of the new factors.
+    NextFactorResult2 next_longest_factor_with_layers(
+        const Slice &entire_input, const size_t bytes_already_read,
+        const Slice &rest_input, const std::vector<const FlatRadixTrie *> &layers, RadixTrie &previous_factors) {
+        RadixTrieNode *root_node = &previous_factors.root_node;
+
+        // Factors (see next_longest_factor), all insertions start from the root node
+        CombinationFactor combination_factor = {rest_input[0], 0, true, false, 1, false, root_node, 0};
+        std::optional<TruncationFactor> truncation_factor = std::nullopt;
+        RepetitionFactor repetition_factor = {rest_input[0], true, 1, 1 + naive_lce(entire_input, bytes_already_read, bytes_already_read + 1), root_node};
+
+        // Maximize first factor, truncation and repetition
+        LayeredCursor first_cursor(layers, root_node);
+        for (size_t input_i = 0; input_i < rest_input.size() && first_cursor.step(rest_input[input_i]);) {
+            ++input_i;
+            truncation_factor = std::make_optional(TruncationFactor{first_cursor.next_factor_node_index(), input_i, root_node, 0});
+            if (const size_t index = first_cursor.factor_index(); index != 0) {
+                combination_factor.first_factor = index;
+                combination_factor.first_is_byte = false;
+                combination_factor.length = input_i;
+                if (const size_t repetition_len = input_i + naive_lce(entire_input, bytes_already_read, bytes_already_read + input_i); repetition_len > repetition_factor.total_length) {
+                    repetition_factor = RepetitionFactor{index, false, input_i, repetition_len, root_node};
                 }
-            } else if (factor.size() < length) {
-                size_t r = 0;
-                const size_t mod_r = factor.size();
-                while (factor.size() < length) {
-                    factor.push_back(factor[r]);
-                    r = (r + 1) % mod_r;
+            }
+        }
+
+        // Maximize second factor
+        if (const size_t second_start = combination_factor.length; second_start < rest_input.size()) {
+            combination_factor.second_factor = rest_input[second_start];
+            combination_factor.second_is_byte = true;
+            combination_factor.length = second_start + 1;
+            LayeredCursor second_cursor(layers, root_node);
+            for (size_t input_i = second_start; input_i < rest_input.size() && second_cursor.step(rest_input[input_i]);) {
+                ++input_i;
+                const size_t index = second_cursor.factor_index();
+                // Make sure to not overwrite single byte second factor
+                // with truncated factor, when truncated length is the same
+                if (input_i > combination_factor.length) {
+                    combination_factor.second_factor = index != 0 ? index : second_cursor.next_factor_node_index();
+                    combination_factor.second_is_byte = false;
+                    combination_factor.length = input_i;
+                    combination_factor.used_extra_truncation = index == 0;
+                } else if (index != 0) {
+                    combination_factor.used_extra_truncation = false;
                 }
             }
-            assert(factor.size() == length);
-            previous_factors.push_back(factor);
-            i += 10;
-        } else if (type == 2) {
-            if (i + 9 >= compressed.size()) {
-                throw std::out_of_range("Index out of bounds");
+        }
+
+        // Return the one that yields the maximum length
+        // (where ties are broken such that combination is the preferred method
+        // and repetition is preferred least)
+        NextFactorResult2 longest_factor = combination_factor_to_result(rest_input, combination_factor);
+        if (truncation_factor) {
+            if (NextFactorResult2 truncation_result = truncation_factor_to_result(rest_input, *truncation_factor);
+                truncation_result.factor_slice.size() > longest_factor.factor_slice.size()) {
+                longest_factor = truncation_result;
             }
-            std::vector<uint8_t> factor;
-            const uint32_t first_factor = u32_from_bytes(compressed.data() + (i + 1));
-            for (const uint8_t byte: previous_factors[first_factor - 1]) {
-                factor.push_back(byte);
+        }
+        if (NextFactorResult2 repetition_result = repetition_factor_to_result(rest_input, repetition_factor);
+            repetition_result.factor_slice.size() > longest_factor.factor_slice.size()) {
+            longest_factor = repetition_result;
+        }
+        longest_factor.insertion_node = root_node;
+        longest_factor.insertion_slice = longest_factor.factor_slice;
+        return longest_factor;
+    }
+
+    // Optional steps of lzdr_parse for parses that are not over the bytes of the whole input
+    template<typename Symbol>
+    struct LzdrParseOptions {
+        // The bytes the records decompress to if the symbols are not the bytes (e.g. the ranks of a small alphabet)
+        // or not all read yet (a pipelined input). They are verified and printed instead of the symbols
+        std::optional<Slice> byte_input;
+        // Called on every record before it is verified or output (e.g. to restore the bytes of the ranks)
+        std::function<void(std::vector<uint8_t> &)> restore_record;
+        // Called on every record as soon as it is computed (e.g. to write it while the input is still read)
+        std::function<void(const std::vector<uint8_t> &)> write_record;
+        // Reads more of the input (see FactorStream)
+        std::function<BasicSlice<Symbol>(size_t)> read_more;
+    };
+
+    // Runs the greedy LZDR parse, where next_factor(bytes_already_read, rest_input, previous_factors)
+    // computes the longest next factor. The stats are printed to stats.
+    // The concurrent verifier only supports bytes, wider symbols are checked by decompressing everything at the end.
+    // Returns the number of factors
+    template<typename Symbol, typename NextFactorFn>
+    size_t lzdr_parse(const BasicSlice<Symbol> input, const bool check_decompressed_equals_input,
+                      std::vector<uint8_t> *compressed_output, BasicRadixTrie<Symbol> &previous_factors,
+                      const LzdrDictionary *dictionary, std::ostream &stats, NextFactorFn next_factor,
+                      const LzdrParseOptions<Symbol> &options = {}) {
+        std::vector<uint8_t> compressed_data;
+        std::optional<ConcurrentLzdrVerifier> verifier;
+        if (check_decompressed_equals_input) {
+            if (options.byte_input) {
+                verifier.emplace(*options.byte_input, dictionary);
+            } else if constexpr (std::is_same_v<Symbol, uint8_t>) {
+                verifier.emplace(input, dictionary);
             }
-            factor.push_back(compressed[i + 5]);
-            const uint32_t length = u32_from_bytes(compressed.data() + (i + 6));
-            if (factor.size() > length) {
-                while (factor.size() > length) {
-                    factor.pop_back();
-                }
-            } else if (factor.size() < length) {
-                size_t r = 0;
-                const size_t mod_r = factor.size();
-                while (factor.size() < length) {
-                    factor.push_back(factor[r]);
-                    r = (r + 1) % mod_r;
+        }
+        const bool keep_compressed_data = compressed_output != nullptr || (check_decompressed_equals_input && !verifier);
+        if constexpr (sizeof(Symbol) > 1) {
+            lzdr_compressor::append_symbols_header(compressed_data, sizeof(Symbol));
+        }
+
+        size_t num_factors = 0;
+        size_t num_extra_truncations_combinations = 0;
+        size_t num_extra_truncations_repetitions = 0;
+        FactorStream<NextFactorFn, Symbol> factors(input, previous_factors, std::move(next_factor), options.read_more);
+        while (BasicStreamedFactor<Symbol> *factor = factors.next()) {
+            if (factor->used_extra_truncation) {
+                if (const FactorType factor_type = factor->type(); factor_type == FactorType::COMBINATION) {
+                    num_extra_truncations_combinations += 1;
+                } else if (factor_type == FactorType::REPETITION) {
+                    num_extra_truncations_repetitions += 1;
+                } else {
+                    throw std::out_of_range("Extra truncation could not be associated with factor type");
                 }
             }
-            assert(factor.size() == length);
-            previous_factors.push_back(factor);
-            i += 10;
-        } else if (type == 3) {
-            if (i + 12 >= compressed.size()) {
-                throw std::out_of_range("Index out of bounds");
+
+            num_factors = factor->index;
+
+#ifndef NDEBUG
+            if (options.byte_input) {
+                stats << "Factor " << num_factors << ": " << options.byte_input->slice(factor->position, factor->length()) << std::endl;
+            } else {
+                stats << "Factor " << num_factors << ": " << factor->text << std::endl;
+            }
+#endif
+
+            if (options.restore_record) {
+                options.restore_record(factor->record);
             }
-            std::vector<uint8_t> factor;
-            const uint32_t first_factor = u32_from_bytes(compressed.data() + (i + 1));
-            for (const uint8_t byte: previous_factors[first_factor - 1]) {
-                factor.push_back(byte);
+            if (verifier) {
+                verifier->add(factor->record);
             }
-            if (const uint32_t second_factor = u32_from_bytes(compressed.data() + (i + 5)); second_factor != 0) {
-                for (const uint8_t byte: previous_factors[second_factor - 1]) {
-                    factor.push_back(byte);
-                }
+            if (options.write_record) {
+                options.write_record(factor->record);
+            }
+            if (keep_compressed_data) {
+                compressed_data.insert(compressed_data.end(),
+                                       std::make_move_iterator(factor->record.begin()),
+                                       std::make_move_iterator(factor->record.end()));
+            }
+        }
+
+        if (verifier) {
+            verifier->finish();
+        }
+        if constexpr (sizeof(Symbol) > 1) {
+            if (check_decompressed_equals_input && lzdr_decompress_symbols<Symbol>(compressed_data) != std::vector<Symbol>(input.begin(), input.end())) {
+                throw std::out_of_range("Decompressed not equal to input");
+            }
+        }
+        if (compressed_output != nullptr) {
+            compressed_output->insert(compressed_output->end(), compressed_data.begin(), compressed_data.end());
+        }
+
+        stats << "Num extra truncations (combination): " << num_extra_truncations_combinations << std::endl;
+        stats << "Num extra truncations (repetition): " << num_extra_truncations_repetitions << std::endl;
+
+        return num_factors;
+    }
+
+    // Runs the greedy LZDR parse on the ranks of the small alphabet of the input and restores the bytes of the records,
+    // so the compressed data and the verification are the same as for the byte input
+    template<unsigned Bits>
+    size_t lzdr_parse_ranks(const Slice input, const SmallAlphabet &alphabet, const bool check_decompressed_equals_input,
+                            std::vector<uint8_t> *compressed_output, std::ostream &stats) {
+        const std::vector<RankSymbol<Bits> > ranks = alphabet.ranks<Bits>(input);
+        const BasicSlice<RankSymbol<Bits> > rank_input(ranks);
+        BasicRadixTrie<RankSymbol<Bits> > previous_factors;
+        LzdrParseOptions<RankSymbol<Bits> > options;
+        options.byte_input = input;
+        options.restore_record = [&](std::vector<uint8_t> &record) {
+            alphabet.restore_record_bytes(record);
+        };
+        return lzdr_parse(rank_input, check_decompressed_equals_input, compressed_output, previous_factors, nullptr, stats,
+                          factor_stream_internal::LzdrNextFactor<RankSymbol<Bits> >{rank_input}, options);
+    }
+
+    template<typename IndexT>
+    size_t lzdr_suffix_array_with_index(const Slice input, const bool check_decompressed_equals_input,
+                                        std::vector<uint8_t> *compressed_output, std::ostream &stats) {
+        const SuffixArrayLce<IndexT> lce(input);
+        RadixTrie previous_factors;
+        return lzdr_parse(input, check_decompressed_equals_input, compressed_output, previous_factors, nullptr, stats,
+                          [&](const size_t bytes_already_read, const Slice &rest_input, RadixTrie &previous_factors) {
+                              return lzdr_linear_time_internal::next_longest_factor_lce(
+                                  input, bytes_already_read, rest_input, previous_factors, lce);
+                          });
+    }
+}
+
+// Returns the number of factors
+size_t lzdr_linear_time(const Slice input, const bool check_decompressed_equals_input,
+                        std::vector<uint8_t> *compressed_output, std::ostream &stats) {
+    RadixTrie previous_factors;
+    previous_factors.enable_root_jump_table();
+    return lzdr_parse(input, check_decompressed_equals_input, compressed_output, previous_factors, nullptr, stats,
+                      [&](const size_t bytes_already_read, const Slice &rest_input, RadixTrie &previous_factors) {
+                          return lzdr_linear_time_internal::next_longest_factor(
+                              input, bytes_already_read, rest_input, previous_factors);
+                      });
+}
+
+// Returns the number of factors
+size_t lzdr_linear_time(const BasicSlice<uint16_t> input, const bool check_decompressed_equals_input,
+                        std::vector<uint8_t> *compressed_output, std::ostream &stats) {
+    BasicRadixTrie<uint16_t> previous_factors;
+    return lzdr_parse(input, check_decompressed_equals_input, compressed_output, previous_factors, nullptr, stats,
+                      factor_stream_internal::LzdrNextFactor<uint16_t>{input});
+}
+
+// Returns the number of factors
+size_t lzdr_linear_time(const BasicSlice<uint32_t> input, const bool check_decompressed_equals_input,
+                        std::vector<uint8_t> *compressed_output, std::ostream &stats) {
+    BasicRadixTrie<uint32_t> previous_factors;
+    return lzdr_parse(input, check_decompressed_equals_input, compressed_output, previous_factors, nullptr, stats,
+                      factor_stream_internal::LzdrNextFactor<uint32_t>{input});
+}
+
+// Returns the number of factors
+size_t lzdr_linear_time_small_alphabet(const Slice input, const bool check_decompressed_equals_input,
+                                       std::vector<uint8_t> *compressed_output, std::ostream &stats) {
+    const std::optional<SmallAlphabet> alphabet = SmallAlphabet::detect(input);
+    if (!alphabet) {
+        stats << "Alphabet: more than " << SmallAlphabet::MAX_SIZE << " bytes, factorizing bytes" << std::endl;
+        return lzdr_linear_time(input, check_decompressed_equals_input, compressed_output, stats);
+    }
+    const unsigned bits = alphabet->bits_per_symbol();
+    stats << "Alphabet: " << alphabet->size() << " bytes (" << bits << " bits per rank)" << std::endl;
+    switch (bits) {
+        case 2:
+            return lzdr_parse_ranks<2>(input, *alphabet, check_decompressed_equals_input, compressed_output, stats);
+        case 3:
+            return lzdr_parse_ranks<3>(input, *alphabet, check_decompressed_equals_input, compressed_output, stats);
+        case 4:
+            return lzdr_parse_ranks<4>(input, *alphabet, check_decompressed_equals_input, compressed_output, stats);
+        case 5:
+            return lzdr_parse_ranks<5>(input, *alphabet, check_decompressed_equals_input, compressed_output, stats);
+        default:
+            throw std::out_of_range("Unsupported bits per rank");
+    }
+}
+
+// Returns the number of factors
+size_t lzdr_linear_time_with_dictionary(const Slice input, const LzdrDictionary &dictionary,
+                                        const bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output,
+                                        std::ostream &stats) {
+    // The new factors are numbered after the factors of the dictionary
+    RadixTrie previous_factors;
+    previous_factors.num_factor_nodes = dictionary.num_factors() + 1;
+    const std::vector<const FlatRadixTrie *> layers = {&dictionary.trie()};
+    return lzdr_parse(input, check_decompressed_equals_input, compressed_output, previous_factors, &dictionary, stats,
+                      [&](const size_t bytes_already_read, const Slice &rest_input, RadixTrie &previous_factors) {
+                          return next_longest_factor_with_layers(
+                              input, bytes_already_read, rest_input, layers, previous_factors);
+                      });
+}
+
+// Returns the number of factors
+size_t lzdr_linear_time_continued(const Slice input, const std::vector<const FlatRadixTrie *> &layers,
+                                  const size_t num_previous_factors, RadixTrie &new_factors,
+                                  std::vector<uint8_t> *compressed_output, std::ostream &stats) {
+    new_factors.num_factor_nodes = num_previous_factors + 1;
+    return lzdr_parse(input, false, compressed_output, new_factors, nullptr, stats,
+                      [&](const size_t bytes_already_read, const Slice &rest_input, RadixTrie &previous_factors) {
+                          return next_longest_factor_with_layers(
+                              input, bytes_already_read, rest_input, layers, previous_factors);
+                      });
+}
+
+// Returns the number of factors
+size_t lzdr_linear_time_pipelined(PipelinedInput &input, const bool check_decompressed_equals_input, PipelinedOutput *output,
+                                  std::ostream &stats) {
+    RadixTrie previous_factors;
+    previous_factors.enable_root_jump_table();
+    Slice available_input = input.data(input.wait_for(1));
+    LzdrParseOptions<uint8_t> options;
+    options.byte_input = input.data(input.size());
+    options.read_more = [&](const size_t num_bytes) {
+        available_input = input.data(input.wait_for(num_bytes));
+        return available_input;
+    };
+    if (output != nullptr) {
+        options.write_record = [output](const std::vector<uint8_t> &record) {
+            output->write(record.data(), record.size());
+        };
+    }
+    return lzdr_parse(available_input, check_decompressed_equals_input, nullptr, previous_factors, nullptr, stats,
+                      [&](const size_t bytes_already_read, const Slice &rest_input, RadixTrie &previous_factors) {
+                          return lzdr_linear_time_internal::next_longest_factor(
+                              available_input, bytes_already_read, rest_input, previous_factors);
+                      }, options);
+}
+
+// Returns the number of factors
+size_t lzdr_suffix_array(const Slice input, const bool check_decompressed_equals_input,
+                         std::vector<uint8_t> *compressed_output, std::ostream &stats) {
+    if (input.size() <= static_cast<size_t>(INT32_MAX)) {
+        return lzdr_suffix_array_with_index<int32_t>(input, check_decompressed_equals_input, compressed_output, stats);
+    }
+    return lzdr_suffix_array_with_index<int64_t>(input, check_decompressed_equals_input, compressed_output, stats);
+}
+
+namespace {
+    // Truncates factor to length or repeats it until it has length symbols
+    template<typename Symbol>
+    void fit_to_length(std::vector<Symbol> &factor, const uint64_t length) {
+        if (factor.size() > length) {
+            while (factor.size() > length) {
+                factor.pop_back();
             }
-            const uint32_t length = u32_from_bytes(compressed.data() + (i + 9));
-            if (factor.size() > length) {
-                while (factor.size() > length) {
-                    factor.pop_back();
+        } else if (factor.size() < length) {
+            size_t r = 0;
+            const size_t mod_r = factor.size();
+            while (factor.size() < length) {
+                factor.push_back(factor[r]);
+                r = (r + 1) % mod_r;
+            }
+        }
+        assert(factor.size() == length);
+    }
+}
+
+namespace lzdr_compressor {
+    size_t record_size(const uint8_t first_byte, const size_t symbol_width) {
+        // Size of a factor, length or repetition field
+        const size_t w = (first_byte & WIDE_FORMAT_FLAG) != 0 ? 8 : 4;
+        switch (first_byte & ~WIDE_FORMAT_FLAG) {
+            case 0:
+                return 1 + 2 * symbol_width + w;
+            case 1:
+            case 2:
+                return 1 + symbol_width + 2 * w;
+            case 3:
+                return 1 + 3 * w;
+            case 4:
+            case 5:
+                return 1 + 2 * w;
+            case 6:
+                return 1 + symbol_width + w;
+            default:
+                throw std::out_of_range("Unknown type");
+        }
+    }
+
+    template<typename Symbol>
+    std::vector<Symbol> decode_symbol_record(const uint8_t *record, const std::function<BasicSlice<Symbol>(uint64_t)> &factor_at) {
+        const bool wide = (record[0] & WIDE_FORMAT_FLAG) != 0;
+        const size_t w = wide ? 8 : 4;
+        constexpr size_t s = sizeof(Symbol);
+        std::vector<Symbol> factor;
+        switch (record[0] & ~WIDE_FORMAT_FLAG) {
+            case 0:
+                factor = {static_cast<Symbol>(symbol_from_bytes(record + 1, s)), static_cast<Symbol>(symbol_from_bytes(record + 1 + s, s))};
+                fit_to_length(factor, uint_from_bytes(record + 1 + 2 * s, wide));
+                break;
+            case 1:
+                factor = {static_cast<Symbol>(symbol_from_bytes(record + 1, s))};
+                if (const uint64_t second_factor = uint_from_bytes(record + 1 + s, wide); second_factor != 0) {
+                    const BasicSlice<Symbol> second = factor_at(second_factor);
+                    factor.insert(factor.end(), second.begin(), second.end());
                 }
-            } else if (factor.size() < length) {
-                size_t r = 0;
-                const size_t mod_r = factor.size();
-                while (factor.size() < length) {
-                    factor.push_back(factor[r]);
-                    r = (r + 1) % mod_r;
+                fit_to_length(factor, uint_from_bytes(record + 1 + s + w, wide));
+                break;
+            case 2: {
+                const BasicSlice<Symbol> first = factor_at(uint_from_bytes(record + 1, wide));
+                factor.assign(first.begin(), first.end());
+                factor.push_back(static_cast<Symbol>(symbol_from_bytes(record + 1 + w, s)));
+                fit_to_length(factor, uint_from_bytes(record + 1 + s + w, wide));
+                break;
+            }
+            case 3: {
+                const BasicSlice<Symbol> first = factor_at(uint_from_bytes(record + 1, wide));
+                factor.assign(first.begin(), first.end());
+                if (const uint64_t second_factor = uint_from_bytes(record + 1 + w, wide); second_factor != 0) {
+                    const BasicSlice<Symbol> second = factor_at(second_factor);
+                    factor.insert(factor.end(), second.begin(), second.end());
                 }
+                fit_to_length(factor, uint_from_bytes(record + 1 + 2 * w, wide));
+                break;
             }
-            assert(factor.size() == length);
-            previous_factors.push_back(factor);
-            i += 13;
-        } else if (type == 4) {
-            if (i + 8 >= compressed.size()) {
-                throw std::out_of_range("Index out of bounds");
+            case 4: {
+                const BasicSlice<Symbol> first = factor_at(uint_from_bytes(record + 1, wide));
+                const uint64_t length = uint_from_bytes(record + 1 + w, wide);
+                for (size_t j = 0; j < length; ++j) {
+                    factor.push_back(first[j]);
+                }
+                break;
             }
-            std::vector<uint8_t> factor;
-            const std::vector<uint8_t> &first_factor = previous_factors[
-                u32_from_bytes(compressed.data() + (i + 1)) - 1];
-            const uint32_t length = u32_from_bytes(compressed.data() + (i + 5));
-            for (size_t j = 0; j < length; ++j) {
-                factor.push_back(first_factor[j]);
+            case 5: {
+                const BasicSlice<Symbol> first = factor_at(uint_from_bytes(record + 1, wide));
+                const uint64_t total_length = uint_from_bytes(record + 1 + w, wide);
+                const size_t repetitions = total_length / first.size();
+                const size_t extra_chars = total_length % first.size();
+                for (size_t j = 0; j < repetitions; ++j) {
+                    factor.insert(factor.end(), first.begin(), first.end());
+                }
+                assert(first.size() >= extra_chars);
+                for (size_t j = 0; j < extra_chars; ++j) {
+                    factor.push_back(first[j]);
+                }
+                assert(factor.size() == total_length);
+                break;
             }
-            previous_factors.push_back(factor);
-            i += 9;
-        } else if (type == 5) {
-            if (i + 8 >= compressed.size()) {
-                throw std::out_of_range("Index out of bounds");
+            case 6:
+                factor.assign(uint_from_bytes(record + 1 + s, wide), static_cast<Symbol>(symbol_from_bytes(record + 1, s)));
+                break;
+            default:
+                throw std::out_of_range("Unknown type");
+        }
+        return factor;
+    }
+
+    std::vector<uint8_t> decode_record(const uint8_t *record, const std::function<Slice(uint64_t)> &factor_at) {
+        return decode_symbol_record<uint8_t>(record, factor_at);
+    }
+
+    template std::vector<uint16_t> decode_symbol_record(const uint8_t *, const std::function<BasicSlice<uint16_t>(uint64_t)> &);
+    template std::vector<uint32_t> decode_symbol_record(const uint8_t *, const std::function<BasicSlice<uint32_t>(uint64_t)> &);
+
+    void append_symbols_header(std::vector<uint8_t> &out, const size_t symbol_width) {
+        LzdrSymbolsHeader header = {{}, SYMBOLS_VERSION, BYTE_ORDER_MARK, static_cast<uint32_t>(symbol_width)};
+        std::memcpy(header.magic, SYMBOLS_MAGIC, sizeof(SYMBOLS_MAGIC));
+        out.insert(out.end(), reinterpret_cast<const uint8_t *>(&header), reinterpret_cast<const uint8_t *>(&header) + sizeof(header));
+    }
+}
+
+bool is_lzdr_symbols(const std::vector<uint8_t> &compressed) {
+    return compressed.size() >= sizeof(SYMBOLS_MAGIC) && std::memcmp(compressed.data(), SYMBOLS_MAGIC, sizeof(SYMBOLS_MAGIC)) == 0;
+}
+
+size_t lzdr_symbol_width(const std::vector<uint8_t> &compressed) {
+    if (compressed.size() < sizeof(LzdrSymbolsHeader) || !is_lzdr_symbols(compressed)) {
+        throw std::runtime_error("Not compressed with 16-bit or 32-bit symbols");
+    }
+    LzdrSymbolsHeader header = {};
+    std::memcpy(&header, compressed.data(), sizeof(header));
+    if (header.version != SYMBOLS_VERSION || header.byte_order_mark != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Unsupported symbols version or byte order");
+    }
+    if (header.symbol_width != 2 && header.symbol_width != 4) {
+        throw std::runtime_error("Invalid symbol width");
+    }
+    return header.symbol_width;
+}
+
+namespace {
+    // The dictionary is only used for bytes. The records start at offset start of compressed
+    template<typename Symbol>
+    std::vector<Symbol> decompress_symbols(const std::vector<uint8_t> &compressed, const LzdrDictionary *dictionary,
+                                           const size_t start) {
+        std::vector<std::vector<Symbol> > previous_factors;
+        // Factors 1 to num_dictionary_factors are taken from the dictionary
+        const size_t num_dictionary_factors = dictionary != nullptr ? dictionary->num_factors() : 0;
+        const auto factor_at = [&](const uint64_t index) {
+            if (index == 0 || index > num_dictionary_factors + previous_factors.size()) {
+                throw std::out_of_range("Invalid factor reference");
             }
-            std::vector<uint8_t> factor;
-            const std::vector<uint8_t> &first_factor = previous_factors[
-                u32_from_bytes(compressed.data() + (i + 1)) - 1];
-            const uint32_t total_length = u32_from_bytes(compressed.data() + (i + 5));
-            const size_t repetitions = total_length / first_factor.size();
-            const size_t extra_chars = total_length % first_factor.size();
-            for (size_t j = 0; j < repetitions; ++j) {
-                for (const uint8_t byte: first_factor) {
-                    factor.push_back(byte);
+            if constexpr (sizeof(Symbol) == 1) {
+                if (index <= num_dictionary_factors) {
+                    return dictionary->factor(index);
                 }
             }
-            assert(first_factor.size() >= extra_chars);
-            for (size_t j = 0; j < extra_chars; ++j) {
-                factor.push_back(first_factor[j]);
-            }
-            assert(factor.size() == total_length);
-            previous_factors.push_back(factor);
-            i += 9;
-        } else if (type == 6) {
-            if (i + 5 >= compressed.size()) {
+            return BasicSlice<Symbol>(previous_factors[index - num_dictionary_factors - 1]);
+        };
+        size_t i = start;
+        while (i < compressed.size()) {
+            const size_t record_size = lzdr_compressor::record_size(compressed[i], sizeof(Symbol));
+            if (record_size > compressed.size() - i) {
                 throw std::out_of_range("Index out of bounds");
             }
-            std::vector<uint8_t> factor;
-            const uint32_t total_length = u32_from_bytes(compressed.data() + (i + 2));
-            for (size_t j = 0; j < total_length; ++j) {
-                factor.push_back(compressed[i + 1]);
-            }
-            assert(factor.size() == total_length);
-            previous_factors.push_back(factor);
-            i += 6;
-        } else {
-            throw std::out_of_range("Unknown type");
+            previous_factors.push_back(lzdr_compressor::decode_symbol_record<Symbol>(compressed.data() + i, factor_at));
+            i += record_size;
         }
+
+        std::vector<Symbol> decompressed;
+        for (const std::vector<Symbol> &factor: previous_factors) {
+            decompressed.insert(decompressed.end(), factor.begin(), factor.end());
+        }
+        return decompressed;
+    }
+}
+
+std::vector<uint8_t> lzdr_decompress(const std::vector<uint8_t> &compressed, const LzdrDictionary *dictionary) {
+    if (is_lzdr_dictionary_data(compressed)) {
+        check_dictionary_data_header(compressed, dictionary);
+        return decompress_symbols<uint8_t>(compressed, dictionary, sizeof(LzdrDictionaryDataHeader));
     }
+    return decompress_symbols<uint8_t>(compressed, dictionary, 0);
+}
 
-    std::vector<uint8_t> decompressed;
-    for (const std::vector<uint8_t> &factor: previous_factors) {
-        decompressed.insert(decompressed.end(), factor.begin(), factor.end());
+template<typename Symbol>
+std::vector<Symbol> lzdr_decompress_symbols(const std::vector<uint8_t> &compressed) {
+    if (const size_t symbol_width = lzdr_symbol_width(compressed); symbol_width != sizeof(Symbol)) {
+        throw std::runtime_error("Compressed with " + std::to_string(8 * symbol_width) + "-bit symbols, not " +
+                                 std::to_string(8 * sizeof(Symbol)) + "-bit symbols");
     }
-    return decompressed;
+    return decompress_symbols<Symbol>(compressed, nullptr, sizeof(LzdrSymbolsHeader));
 }
+
+template std::vector<uint16_t> lzdr_decompress_symbols(const std::vector<uint8_t> &);
+template std::vector<uint32_t> lzdr_decompress_symbols(const std::vector<uint8_t> &);
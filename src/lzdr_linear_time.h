@@ -6,33 +6,132 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <iostream>
 #include <string>
 #include <vector>
 
-size_t lzdr_linear_time(Slice input, bool check_decompressed_equals_input);
+class FlatRadixTrie;
+class LzdrDictionary;
+class PipelinedInput;
+class PipelinedOutput;
+
+// If compressed_output is not null, the compressed data is appended to it.
+// Runs on one thread, each factor depends on all previous factors (see lzdr_parallel_blocks for parallel blocks).
+// The stats are printed to stats (std::ostream(nullptr) prints nothing, e.g. on worker threads).
+size_t lzdr_linear_time(Slice input, bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output = nullptr,
+                        std::ostream &stats = std::cout);
+
+// Factorizes 16-bit or 32-bit symbols (e.g. tokens or integer IDs) instead of bytes, so factors start and end on
+// symbol boundaries and the trie is not deeper than the number of symbols of the longest factor.
+// The records are the same as for bytes, except that a byte operand is a symbol of 2 or 4 bytes
+// and lengths count symbols. They follow an LzdrSymbolsHeader (see lzdr_decompress_symbols).
+size_t lzdr_linear_time(BasicSlice<uint16_t> input, bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output = nullptr,
+                        std::ostream &stats = std::cout);
+
+size_t lzdr_linear_time(BasicSlice<uint32_t> input, bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output = nullptr,
+                        std::ostream &stats = std::cout);
+
+// Computes the same factorization and compressed data as lzdr_linear_time. If the input has at most
+// SmallAlphabet::MAX_SIZE distinct bytes (e.g. DNA or proteins), the ranks of the bytes are factorized instead,
+// so the trie nodes index their children with an array of 2^bits edges instead of a hash map.
+// Otherwise it is lzdr_linear_time.
+size_t lzdr_linear_time_small_alphabet(Slice input, bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output = nullptr,
+                                       std::ostream &stats = std::cout);
+
+// Computes the same factorization as lzdr_linear_time,
+// but answers LCE queries with a suffix array over the input instead of comparing byte by byte.
+// This skips the rest texts of the trie edges, not the trie nodes: the walk still takes one lookup per node,
+// so it is not faster in the worst case.
+size_t lzdr_suffix_array(Slice input, bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output = nullptr,
+                         std::ostream &stats = std::cout);
+
+// Same as lzdr_linear_time, but starts with the factors of the dictionary.
+size_t lzdr_linear_time_with_dictionary(Slice input, const LzdrDictionary &dictionary, bool check_decompressed_equals_input,
+                                        std::vector<uint8_t> *compressed_output = nullptr, std::ostream &stats = std::cout);
+
+// Continues a factorization of previous inputs, whose factors 1 to num_previous_factors are given by the union of
+// the flat tries in layers. The new factors are inserted into new_factors.
+// The compressed output can be appended to the compressed output of the previous inputs.
+size_t lzdr_linear_time_continued(Slice input, const std::vector<const FlatRadixTrie *> &layers, size_t num_previous_factors,
+                                  RadixTrie &new_factors, std::vector<uint8_t> *compressed_output,
+                                  std::ostream &stats = std::cout);
+
+// Same as lzdr_linear_time, but starts while the input is still read and hands the compressed data to output
+// (if not null) factor by factor, so reading, factorizing and writing overlap.
+// A factor that reaches the end of the bytes read so far could be longer with more bytes, so it is computed again
+// once twice as many bytes after its start are read. Any other factor is the same as with the whole input.
+size_t lzdr_linear_time_pipelined(PipelinedInput &input, bool check_decompressed_equals_input, PipelinedOutput *output,
+                                  std::ostream &stats = std::cout);
 
 namespace lzdr_linear_time_internal {
-    NextFactorResult2 next_longest_factor(
-        const Slice &entire_input, size_t bytes_already_read,
-        const Slice &rest_input, RadixTrie &previous_factors);
+    // Defined for bytes, uint16_t and uint32_t symbols and RankSymbol<2> to RankSymbol<5>
+    template<typename Symbol>
+    BasicNextFactorResult2<Symbol> next_longest_factor(
+        const BasicSlice<Symbol> &entire_input, size_t bytes_already_read,
+        const BasicSlice<Symbol> &rest_input, BasicRadixTrie<Symbol> &previous_factors);
 
     NextFactorResult next_longest_factor_counted_trie(
         const Slice &entire_input, size_t bytes_already_read,
         const Slice &rest_input, size_t usable_rest_input_len,
         CountedRadixTrie &previous_factors);
 
-    bool insert_into_radix_trie(RadixTrie &trie, RadixTrieNode *from_node, const Slice &insert);
+    template<typename Symbol>
+    bool insert_into_radix_trie(BasicRadixTrie<Symbol> &trie, BasicRadixTrieNode<Symbol> *from_node, const BasicSlice<Symbol> &insert);
 }
 
 namespace lzdr_compressor {
-    Compressor create_compressor_for_combination(bool first_is_byte, bool second_is_byte);
+    // Added to the factor type of records using the wide (uint64_t) format
+    constexpr uint8_t WIDE_FORMAT_FLAG = 8;
 
-    Compressor create_compressor_for_truncation();
+    // A byte operand takes symbol_width bytes for wide-symbol alphabets (see --symbol-width)
+    Compressor create_compressor_for_combination(bool first_is_byte, bool second_is_byte, bool wide, size_t symbol_width = 1);
 
-    Compressor create_compressor_for_repetition(bool is_byte);
+    Compressor create_compressor_for_truncation(bool wide);
+
+    Compressor create_compressor_for_repetition(bool is_byte, bool wide, size_t symbol_width = 1);
+
+    // Number of bytes of the record that starts with first_byte, throws std::out_of_range for unknown factor types
+    size_t record_size(uint8_t first_byte, size_t symbol_width = 1);
+
+    // Decodes the factor of a complete record, where factor_at(index) returns the previous factor with the index
+    // (and throws std::out_of_range if there is none)
+    std::vector<uint8_t> decode_record(const uint8_t *record, const std::function<Slice(uint64_t)> &factor_at);
+
+    // Same for records of 16-bit or 32-bit symbols
+    template<typename Symbol>
+    std::vector<Symbol> decode_symbol_record(const uint8_t *record, const std::function<BasicSlice<Symbol>(uint64_t)> &factor_at);
+
+    // Appends the LzdrSymbolsHeader of symbols of symbol_width (2 or 4) bytes
+    void append_symbols_header(std::vector<uint8_t> &out, size_t symbol_width);
 }
 
-std::vector<uint8_t> lzdr_decompress(const std::vector<uint8_t> &compressed);
+// If dictionary is not null, the compressed data has to be created with the same dictionary.
+// If the compressed data starts with an LzdrDictionaryDataHeader, it is checked against dictionary
+// (std::runtime_error if it is null or another dictionary).
+std::vector<uint8_t> lzdr_decompress(const std::vector<uint8_t> &compressed, const LzdrDictionary *dictionary = nullptr);
+
+// Header of the compressed data of 16-bit or 32-bit symbols (in native byte order), so it is not decompressed
+// with another symbol width
+struct LzdrSymbolsHeader {
+    char magic[8];
+    uint32_t version;
+    // Used to detect files written on a machine with another byte order
+    uint32_t byte_order_mark;
+    uint32_t symbol_width;
+};
+
+// Returns true if compressed starts with the magic of the compressed data of 16-bit or 32-bit symbols
+bool is_lzdr_symbols(const std::vector<uint8_t> &compressed);
+
+// Returns the symbol width (2 or 4 bytes) of the compressed data of 16-bit or 32-bit symbols.
+// Throws std::runtime_error if the header is malformed
+size_t lzdr_symbol_width(const std::vector<uint8_t> &compressed);
+
+// Decompresses the factorization of 16-bit or 32-bit symbols (Symbol is uint16_t or uint32_t).
+// Throws std::runtime_error if the header is malformed or the symbols are not sizeof(Symbol) bytes wide
+template<typename Symbol>
+std::vector<Symbol> lzdr_decompress_symbols(const std::vector<uint8_t> &compressed);
 
 std::string debug_lzdr_data(const std::vector<uint8_t> &compressed, const std::vector<uint8_t> &current_data);
 
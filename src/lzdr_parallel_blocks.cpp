@@ -0,0 +1,136 @@
+#include "lzdr_parallel_blocks.h"
+#include "lzdr_dictionary.h"
+#include "lzdr_linear_time.h"
+#include "slice.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    constexpr char BLOCKS_MAGIC[8] = {'L', 'Z', 'D', 'R', 'B', 'L', 'K', 'S'};
+    constexpr uint32_t BLOCKS_VERSION = 1;
+    constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    template<typename T>
+    void append_bytes(std::vector<uint8_t> &out, const T &value) {
+        out.insert(out.end(), reinterpret_cast<const uint8_t *>(&value), reinterpret_cast<const uint8_t *>(&value) + sizeof(value));
+    }
+}
+
+// Returns the number of factors
+size_t lzdr_parallel_blocks(const Slice input, const size_t block_size, const size_t num_workers,
+                            const bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output) {
+    if (block_size == 0) {
+        throw std::out_of_range("Block size must be greater than 0");
+    }
+    const size_t num_blocks = (input.size() + block_size - 1) / block_size;
+    std::vector<std::vector<uint8_t> > compressed_blocks(num_blocks);
+    std::vector<size_t> num_block_factors(num_blocks, 0);
+    if (num_blocks > 0) {
+        // The base has to be complete before any other block starts, the first block itself
+        // is compressed again as a task, which costs no time as long as there are as many workers as blocks
+        const LzdrDictionary base = LzdrDictionary::from_bytes(LzdrDictionary::train(input.slice(0, std::min(block_size, input.size()))));
+        run_work_stealing(num_workers, num_blocks, [&](const size_t block, size_t) {
+            const Slice block_input = input.slice(block * block_size, std::min(block_size, input.size() - block * block_size));
+            // The stats of the workers are dropped, they must not write to std::cout at the same time
+            std::ostream no_stats(nullptr);
+            if (block == 0) {
+                num_block_factors[block] = lzdr_linear_time(block_input, false, &compressed_blocks[block], no_stats);
+            } else {
+                num_block_factors[block] = lzdr_linear_time_with_dictionary(block_input, base, false, &compressed_blocks[block], no_stats);
+            }
+        });
+    }
+
+    std::vector<uint8_t> compressed_data;
+    LzdrBlocksHeader header = {{}, BLOCKS_VERSION, BYTE_ORDER_MARK, num_blocks, block_size};
+    std::memcpy(header.magic, BLOCKS_MAGIC, sizeof(BLOCKS_MAGIC));
+    append_bytes(compressed_data, header);
+    for (const std::vector<uint8_t> &compressed_block: compressed_blocks) {
+        append_bytes(compressed_data, static_cast<uint64_t>(compressed_block.size()));
+    }
+    for (const std::vector<uint8_t> &compressed_block: compressed_blocks) {
+        compressed_data.insert(compressed_data.end(), compressed_block.begin(), compressed_block.end());
+    }
+
+    if (check_decompressed_equals_input) {
+        if (const std::vector<uint8_t> decompressed_data = lzdr_blocks_decompress(compressed_data, num_workers);
+            !(input == Slice(decompressed_data))) {
+            throw std::out_of_range("Decompressed not equal to input");
+        }
+    }
+    if (compressed_output != nullptr) {
+        compressed_output->insert(compressed_output->end(), compressed_data.begin(), compressed_data.end());
+    }
+
+    size_t num_factors = 0;
+    for (const size_t num: num_block_factors) {
+        num_factors += num;
+    }
+    return num_factors;
+}
+
+bool is_lzdr_blocks(const std::vector<uint8_t> &compressed) {
+    return compressed.size() >= sizeof(BLOCKS_MAGIC) && std::memcmp(compressed.data(), BLOCKS_MAGIC, sizeof(BLOCKS_MAGIC)) == 0;
+}
+
+std::vector<uint8_t> lzdr_blocks_decompress(const std::vector<uint8_t> &compressed, const size_t num_workers) {
+    if (compressed.size() < sizeof(LzdrBlocksHeader)) {
+        throw std::runtime_error("Blocks truncated");
+    }
+    LzdrBlocksHeader header = {};
+    std::memcpy(&header, compressed.data(), sizeof(header));
+    if (!is_lzdr_blocks(compressed) || header.version != BLOCKS_VERSION || header.byte_order_mark != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Unsupported blocks version or byte order");
+    }
+    const size_t rest = compressed.size() - sizeof(LzdrBlocksHeader);
+    if (header.num_blocks > rest / sizeof(uint64_t) || (header.num_blocks > 0 && header.block_size == 0)) {
+        throw std::runtime_error("Blocks truncated");
+    }
+
+    // Offsets of the compressed blocks
+    std::vector<size_t> block_offsets = {sizeof(LzdrBlocksHeader) + header.num_blocks * sizeof(uint64_t)};
+    for (size_t block = 0; block < header.num_blocks; ++block) {
+        uint64_t compressed_block_size;
+        std::memcpy(&compressed_block_size, compressed.data() + sizeof(LzdrBlocksHeader) + block * sizeof(uint64_t), sizeof(uint64_t));
+        if (compressed_block_size > compressed.size() - block_offsets.back()) {
+            throw std::runtime_error("Blocks truncated");
+        }
+        block_offsets.push_back(block_offsets.back() + compressed_block_size);
+    }
+    const auto compressed_block = [&](const size_t block) {
+        return std::vector<uint8_t>(compressed.begin() + static_cast<std::ptrdiff_t>(block_offsets[block]),
+                                    compressed.begin() + static_cast<std::ptrdiff_t>(block_offsets[block + 1]));
+    };
+    if (header.num_blocks == 0) {
+        return {};
+    }
+
+    // Every block but the last one is full
+    std::vector<std::vector<uint8_t> > blocks(header.num_blocks);
+    blocks[0] = lzdr_decompress(compressed_block(0));
+    if (blocks[0].size() != header.block_size && header.num_blocks > 1) {
+        throw std::runtime_error("Block has wrong size");
+    }
+    const LzdrDictionary base = LzdrDictionary::from_bytes(LzdrDictionary::train(Slice(blocks[0])));
+    run_work_stealing(num_workers, header.num_blocks - 1, [&](const size_t task, size_t) {
+        const size_t block = task + 1;
+        blocks[block] = lzdr_decompress(compressed_block(block), &base);
+        if (blocks[block].empty() || blocks[block].size() > header.block_size ||
+            (block + 1 < header.num_blocks && blocks[block].size() != header.block_size)) {
+            throw std::runtime_error("Block has wrong size");
+        }
+    });
+
+    std::vector<uint8_t> decompressed;
+    for (const std::vector<uint8_t> &block: blocks) {
+        decompressed.insert(decompressed.end(), block.begin(), block.end());
+    }
+    return decompressed;
+}
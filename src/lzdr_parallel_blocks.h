@@ -0,0 +1,41 @@
+#ifndef LZDR_PARALLEL_BLOCKS_H
+#define LZDR_PARALLEL_BLOCKS_H
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Block-parallel LZDR with a shared base dictionary.
+//
+// The first block is factorized once, its factors form a read-only dictionary (LzdrDictionary) shared by all workers.
+// Every other block is compressed on its own worker with lzdr_linear_time_with_dictionary, so lookups walk the
+// shared flat trie without locks and the private trie of the block's new factors (the overlay) at the same time.
+// Blocks get most of the benefit of the factors of the first block, and the base is stored only once.
+// The first block is compressed like lzdr_linear_time, so the base can be rebuilt from it when decompressing.
+//
+// File layout (all integers in native byte order):
+//   LzdrBlocksHeader
+//   uint64_t[num_blocks] (compressed size of each block)
+//   compressed blocks
+struct LzdrBlocksHeader {
+    char magic[8];
+    uint32_t version;
+    // Used to detect files written on a machine with another byte order
+    uint32_t byte_order_mark;
+    uint64_t num_blocks;
+    uint64_t block_size;
+};
+
+// Compresses input in blocks of block_size bytes on num_workers threads and appends the file to compressed_output
+// (if not null). Returns the number of factors of all blocks
+size_t lzdr_parallel_blocks(Slice input, size_t block_size, size_t num_workers, bool check_decompressed_equals_input,
+                            std::vector<uint8_t> *compressed_output = nullptr);
+
+// Returns true if compressed starts with the magic of lzdr_parallel_blocks
+bool is_lzdr_blocks(const std::vector<uint8_t> &compressed);
+
+// Decompresses the blocks on num_workers threads, throws std::runtime_error if the file is malformed
+std::vector<uint8_t> lzdr_blocks_decompress(const std::vector<uint8_t> &compressed, size_t num_workers);
+
+#endif //LZDR_PARALLEL_BLOCKS_H
@@ -0,0 +1,323 @@
+#include "lzdr_pattern_search.h"
+#include "lzdr_random_access.h"
+#include "slice.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    struct SearchTask {
+        size_t factor;
+        // Length of the prefix of the factor (or its base) to search in
+        uint64_t prefix_len;
+        // Position of the factor (or its base) in the decompressed data
+        uint64_t shift;
+        // If true, only the base of the factor is searched (prefix_len <= base length)
+        bool in_base;
+    };
+}
+
+LzdrPatternSearch::LzdrPatternSearch(const LzdrRandomAccess &random_access, const Slice pattern)
+    : random_access(random_access), pattern(pattern.data(), pattern.data() + pattern.size()) {
+    if (pattern.empty()) {
+        throw std::invalid_argument("Empty pattern");
+    }
+
+    failure.assign(pattern.size(), 0);
+    for (size_t i = 1, k = 0; i < pattern.size(); ++i) {
+        while (k > 0 && pattern[i] != pattern[k]) {
+            k = failure[k - 1];
+        }
+        if (pattern[i] == pattern[k]) {
+            ++k;
+        }
+        failure[i] = k;
+    }
+
+    const auto count_in_part = [this](const LzdrRandomAccess::BasePart &part) -> uint64_t {
+        if (part.is_byte) {
+            return this->pattern.size() == 1 && this->pattern[0] == part.value ? 1 : 0;
+        }
+        return occurrences[part.value - 1];
+    };
+
+    occurrences.reserve(random_access.num_factors());
+    base_occurrences.reserve(random_access.num_factors());
+    for (size_t factor = 1; factor <= random_access.num_factors(); ++factor) {
+        const LzdrRandomAccess::FactorInfo &info = random_access.factor_info(factor);
+        uint64_t in_base = count_in_part(info.first);
+        if (info.has_second) {
+            in_base += count_in_part(info.second);
+            in_base += base_boundary_occurrences(factor, random_access.base_part_length(info.first), info.base_length).size();
+        }
+        base_occurrences.push_back(in_base);
+        occurrences.push_back(count_in_prefix(factor, info.length));
+    }
+}
+
+template<typename Found>
+void LzdrPatternSearch::find_in_window(const std::vector<uint8_t> &window, const size_t start_limit, Found found) const {
+    const size_t m = pattern.size();
+    size_t k = 0;
+    for (size_t j = 0; j < window.size(); ++j) {
+        while (k > 0 && window[j] != pattern[k]) {
+            k = failure[k - 1];
+        }
+        if (window[j] == pattern[k]) {
+            ++k;
+        }
+        if (k == m) {
+            if (const size_t start = j + 1 - m; start < start_limit) {
+                found(start);
+            }
+            k = failure[k - 1];
+        }
+    }
+}
+
+std::vector<uint8_t> LzdrPatternSearch::extract_base(const size_t factor, const uint64_t from, const uint64_t to) const {
+    const LzdrRandomAccess::FactorInfo &info = random_access.factor_info(factor);
+    const auto extract_part = [this](const LzdrRandomAccess::BasePart &part, const uint64_t part_from, const uint64_t part_to) {
+        if (part.is_byte) {
+            return std::vector<uint8_t>(part_to - part_from, static_cast<uint8_t>(part.value));
+        }
+        return random_access.extract_factor(part.value, part_from, part_to);
+    };
+
+    const uint64_t first_len = random_access.base_part_length(info.first);
+    std::vector<uint8_t> out;
+    if (from < first_len) {
+        out = extract_part(info.first, from, std::min(to, first_len));
+    }
+    if (info.has_second && to > first_len) {
+        const std::vector<uint8_t> second = extract_part(info.second, std::max(from, first_len) - first_len, to - first_len);
+        out.insert(out.end(), second.begin(), second.end());
+    }
+    return out;
+}
+
+std::vector<uint64_t> LzdrPatternSearch::base_boundary_occurrences(const size_t factor, const uint64_t boundary, const uint64_t to) const {
+    const uint64_t h = pattern.size() - 1;
+    const uint64_t window_start = boundary - std::min(boundary, h);
+    const uint64_t window_end = std::min(to, boundary + h);
+    std::vector<uint64_t> result;
+    if (window_end - window_start < pattern.size()) {
+        return result;
+    }
+    const std::vector<uint8_t> window = extract_base(factor, window_start, window_end);
+    find_in_window(window, boundary - window_start, [&](const size_t start) {
+        result.push_back(window_start + start);
+    });
+    return result;
+}
+
+std::vector<uint64_t> LzdrPatternSearch::copy_boundary_occurrences(const size_t factor, const uint64_t after_len) const {
+    const uint64_t h = pattern.size() - 1;
+    const uint64_t base_length = random_access.factor_info(factor).base_length;
+    std::vector<uint64_t> result;
+    if (h + after_len < pattern.size()) {
+        return result;
+    }
+    std::vector<uint8_t> window = extract_base(factor, base_length - h, base_length);
+    const std::vector<uint8_t> after = extract_base(factor, 0, after_len);
+    window.insert(window.end(), after.begin(), after.end());
+    find_in_window(window, h, [&](const size_t start) {
+        result.push_back(start);
+    });
+    return result;
+}
+
+std::vector<uint64_t> LzdrPatternSearch::matching_residues(const size_t factor) const {
+    const uint64_t base_length = random_access.factor_info(factor).base_length;
+    const std::vector<uint8_t> base = extract_base(factor, 0, base_length);
+    std::vector<uint64_t> result;
+    for (uint64_t residue = 0; residue < base_length; ++residue) {
+        bool matches = true;
+        for (size_t i = 0; i < pattern.size() && matches; ++i) {
+            matches = pattern[i] == base[(residue + i) % base_length];
+        }
+        if (matches) {
+            result.push_back(residue);
+        }
+    }
+    return result;
+}
+
+uint64_t LzdrPatternSearch::count_in_prefix(size_t factor, uint64_t prefix_len) const {
+    const uint64_t m = pattern.size();
+    const uint64_t h = m - 1;
+    uint64_t total = 0;
+    // Only one part of the base has to be descended into, so this is a loop instead of a recursion
+    while (prefix_len >= m) {
+        const LzdrRandomAccess::FactorInfo &info = random_access.factor_info(factor);
+        if (prefix_len == info.length && factor <= occurrences.size()) {
+            return total + occurrences[factor - 1];
+        }
+
+        const uint64_t period = info.base_length;
+        if (period < m) {
+            // Whether an occurrence starts at a position only depends on the position modulo the period
+            for (const uint64_t residue: matching_residues(factor)) {
+                if (residue + m <= prefix_len) {
+                    total += (prefix_len - m - residue) / period + 1;
+                }
+            }
+            return total;
+        }
+
+        // Full copies of the base and the boundaries between them
+        const uint64_t copies = prefix_len / period;
+        const uint64_t rest = prefix_len % period;
+        total += copies * base_occurrences[factor - 1];
+        if (copies > 0 && h > 0) {
+            const uint64_t full_boundaries = (prefix_len - h) / period;
+            if (full_boundaries > 0) {
+                total += full_boundaries * copy_boundary_occurrences(factor, h).size();
+            }
+            if (const uint64_t boundary = (full_boundaries + 1) * period; boundary < prefix_len) {
+                total += copy_boundary_occurrences(factor, prefix_len - boundary).size();
+            }
+        }
+        if (rest == 0) {
+            return total;
+        }
+
+        // Prefix of the last copy of the base
+        const uint64_t first_len = random_access.base_part_length(info.first);
+        LzdrRandomAccess::BasePart part = info.first;
+        if (rest <= first_len) {
+            prefix_len = rest;
+        } else {
+            total += info.first.is_byte ? (m == 1 && pattern[0] == info.first.value ? 1 : 0) : occurrences[info.first.value - 1];
+            total += base_boundary_occurrences(factor, first_len, rest).size();
+            part = info.second;
+            prefix_len = rest - first_len;
+        }
+        if (part.is_byte) {
+            return total + (m == 1 && prefix_len >= 1 && pattern[0] == part.value ? 1 : 0);
+        }
+        factor = part.value;
+    }
+    return total;
+}
+
+uint64_t LzdrPatternSearch::count() const {
+    uint64_t total = 0;
+    for (size_t factor = 1; factor <= random_access.num_factors(); ++factor) {
+        total += occurrences[factor - 1];
+    }
+
+    // Occurrences crossing factor boundaries are counted at the first boundary they cross
+    const uint64_t h = pattern.size() - 1;
+    for (size_t factor = 2; factor <= random_access.num_factors() && h > 0; ++factor) {
+        const uint64_t boundary = random_access.factor_start(factor);
+        const uint64_t window_start = std::max(boundary - std::min(boundary, h), random_access.factor_start(factor - 1));
+        const uint64_t window_end = std::min(random_access.size(), boundary + h);
+        if (window_end - window_start < pattern.size()) {
+            continue;
+        }
+        find_in_window(random_access.extract(window_start, window_end), boundary - window_start, [&](size_t) {
+            total += 1;
+        });
+    }
+    return total;
+}
+
+std::vector<uint64_t> LzdrPatternSearch::find_all() const {
+    const uint64_t m = pattern.size();
+    const uint64_t h = m - 1;
+    std::vector<uint64_t> result;
+
+    std::vector<SearchTask> tasks;
+    for (size_t factor = 1; factor <= random_access.num_factors(); ++factor) {
+        tasks.push_back({factor, random_access.factor_length(factor), random_access.factor_start(factor), false});
+
+        // Occurrences crossing factor boundaries are reported at the first boundary they cross
+        if (factor > 1 && h > 0) {
+            const uint64_t boundary = random_access.factor_start(factor);
+            const uint64_t window_start = std::max(boundary - std::min(boundary, h), random_access.factor_start(factor - 1));
+            const uint64_t window_end = std::min(random_access.size(), boundary + h);
+            if (window_end - window_start >= m) {
+                find_in_window(random_access.extract(window_start, window_end), boundary - window_start, [&](const size_t start) {
+                    result.push_back(window_start + start);
+                });
+            }
+        }
+    }
+
+    const auto push_part = [&](const LzdrRandomAccess::BasePart &part, const uint64_t prefix_len, const uint64_t shift) {
+        if (part.is_byte) {
+            if (m == 1 && prefix_len >= 1 && pattern[0] == part.value) {
+                result.push_back(shift);
+            }
+        } else {
+            tasks.push_back({static_cast<size_t>(part.value), prefix_len, shift, false});
+        }
+    };
+
+    while (!tasks.empty()) {
+        const SearchTask task = tasks.back();
+        tasks.pop_back();
+        if (task.prefix_len < m || occurrences[task.factor - 1] == 0) {
+            continue;
+        }
+        const LzdrRandomAccess::FactorInfo &info = random_access.factor_info(task.factor);
+        const uint64_t period = info.base_length;
+
+        if (task.in_base) {
+            const uint64_t first_len = random_access.base_part_length(info.first);
+            if (task.prefix_len <= first_len) {
+                push_part(info.first, task.prefix_len, task.shift);
+            } else {
+                push_part(info.first, first_len, task.shift);
+                for (const uint64_t start: base_boundary_occurrences(task.factor, first_len, task.prefix_len)) {
+                    result.push_back(task.shift + start);
+                }
+                push_part(info.second, task.prefix_len - first_len, task.shift + first_len);
+            }
+            continue;
+        }
+
+        if (period < m) {
+            for (const uint64_t residue: matching_residues(task.factor)) {
+                for (uint64_t start = residue; start + m <= task.prefix_len; start += period) {
+                    result.push_back(task.shift + start);
+                }
+            }
+            continue;
+        }
+
+        const uint64_t copies = task.prefix_len / period;
+        const uint64_t rest = task.prefix_len % period;
+        if (base_occurrences[task.factor - 1] > 0) {
+            for (uint64_t copy = 0; copy < copies; ++copy) {
+                tasks.push_back({task.factor, period, task.shift + copy * period, true});
+            }
+        }
+        if (rest > 0) {
+            tasks.push_back({task.factor, rest, task.shift + copies * period, true});
+        }
+        if (copies > 0 && h > 0) {
+            const uint64_t full_boundaries = (task.prefix_len - h) / period;
+            if (full_boundaries > 0) {
+                const std::vector<uint64_t> starts = copy_boundary_occurrences(task.factor, h);
+                for (uint64_t k = 1; k <= full_boundaries && !starts.empty(); ++k) {
+                    for (const uint64_t start: starts) {
+                        result.push_back(task.shift + k * period - h + start);
+                    }
+                }
+            }
+            if (const uint64_t boundary = (full_boundaries + 1) * period; boundary < task.prefix_len) {
+                for (const uint64_t start: copy_boundary_occurrences(task.factor, task.prefix_len - boundary)) {
+                    result.push_back(task.shift + boundary - h + start);
+                }
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
@@ -0,0 +1,56 @@
+#ifndef LZDR_PATTERN_SEARCH_H
+#define LZDR_PATTERN_SEARCH_H
+#include "lzdr_random_access.h"
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Finds all occurrences of a pattern in LZDR (and LZD+) compressed data without decompressing everything.
+//
+// The number of occurrences inside every factor is computed in factor order from the occurrences inside
+// the parts of its base and the occurrences crossing the boundaries between the parts and between the
+// periodic copies of the base. Only windows of 2 * (pattern length - 1) bytes around these boundaries
+// are extracted via random access. Reporting descends into the factors containing occurrences.
+class LzdrPatternSearch {
+    const LzdrRandomAccess &random_access;
+    std::vector<uint8_t> pattern;
+    // KMP failure function of the pattern
+    std::vector<size_t> failure;
+    // occurrences[i] is the number of occurrences inside factor i + 1
+    std::vector<uint64_t> occurrences;
+    // base_occurrences[i] is the number of occurrences inside the base of factor i + 1
+    std::vector<uint64_t> base_occurrences;
+
+    // Calls found(start) for every occurrence in window starting before start_limit
+    template<typename Found>
+    void find_in_window(const std::vector<uint8_t> &window, size_t start_limit, Found found) const;
+
+    [[nodiscard]] std::vector<uint8_t> extract_base(size_t factor, uint64_t from, uint64_t to) const;
+
+    // Occurrences in the window around the boundary at position boundary of the base
+    // that cross the boundary and end before or at to
+    [[nodiscard]] std::vector<uint64_t> base_boundary_occurrences(size_t factor, uint64_t boundary, uint64_t to) const;
+
+    // Occurrences in the window around the boundary between two periodic copies of the base
+    // that end before or at boundary + after_len
+    [[nodiscard]] std::vector<uint64_t> copy_boundary_occurrences(size_t factor, uint64_t after_len) const;
+
+    // Starts of occurrences inside a factor with a period smaller than the pattern
+    [[nodiscard]] std::vector<uint64_t> matching_residues(size_t factor) const;
+
+    // Number of occurrences inside the prefix of length prefix_len of factor
+    [[nodiscard]] uint64_t count_in_prefix(size_t factor, uint64_t prefix_len) const;
+
+public:
+    // The pattern must not be empty
+    LzdrPatternSearch(const LzdrRandomAccess &random_access, Slice pattern);
+
+    [[nodiscard]] uint64_t count() const;
+
+    // Returns the sorted starting positions of all occurrences in the decompressed data
+    [[nodiscard]] std::vector<uint64_t> find_all() const;
+};
+
+#endif //LZDR_PATTERN_SEARCH_H
@@ -0,0 +1,231 @@
+#include "lzdr_random_access.h"
+#include "compressor.h"
+#include "lzdr_linear_time.h"
+#include "slice.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+    struct ExtractTask {
+        enum class Kind { Factor, Byte, Copy };
+        Kind kind;
+        // Factor index (Factor), byte (Byte) or period (Copy)
+        uint64_t value;
+        // Range inside the factor (Factor) or number of bytes to copy (Copy, stored in to)
+        uint64_t from;
+        uint64_t to;
+    };
+}
+
+LzdrRandomAccess::LzdrRandomAccess(const Slice compressed) {
+    factor_starts.push_back(0);
+    const uint8_t *data = compressed.data();
+    size_t i = 0;
+    while (i < compressed.size()) {
+        const bool wide = (compressed[i] & lzdr_compressor::WIDE_FORMAT_FLAG) != 0;
+        // Size of a factor, length or repetition field
+        const size_t w = wide ? 8 : 4;
+        const uint8_t type = compressed[i] & ~lzdr_compressor::WIDE_FORMAT_FLAG;
+        size_t record_size;
+        switch (type) {
+            case 0: record_size = 3 + w; break;
+            case 1: case 2: record_size = 2 + 2 * w; break;
+            case 3: record_size = 1 + 3 * w; break;
+            case 4: case 5: record_size = 1 + 2 * w; break;
+            case 6: record_size = 2 + w; break;
+            default: throw std::out_of_range("Unknown type");
+        }
+        if (i + record_size > compressed.size()) {
+            throw std::out_of_range("Index out of bounds");
+        }
+
+        FactorInfo factor = {{0, false}, {0, false}, false, 0, 0};
+        const uint8_t *record = data + i + 1;
+        if (type <= 3) {
+            size_t offset = 0;
+            if (type == 0 || type == 1) {
+                factor.first = BasePart{record[offset], true};
+                offset += 1;
+            } else {
+                factor.first = BasePart{uint_from_bytes(record + offset, wide), false};
+                offset += w;
+            }
+            if (type == 0 || type == 2) {
+                factor.second = BasePart{record[offset], true};
+                factor.has_second = true;
+                offset += 1;
+            } else {
+                // An empty second factor is encoded as factor 0
+                factor.second = BasePart{uint_from_bytes(record + offset, wide), false};
+                factor.has_second = factor.second.value != 0;
+                offset += w;
+            }
+            factor.length = uint_from_bytes(record + offset, wide);
+        } else if (type == 6) {
+            factor.first = BasePart{record[0], true};
+            factor.length = uint_from_bytes(record + 1, wide);
+        } else {
+            factor.first = BasePart{uint_from_bytes(record, wide), false};
+            factor.length = uint_from_bytes(record + w, wide);
+        }
+
+        // Only previous factors may be referenced
+        for (const BasePart *part: {&factor.first, &factor.second}) {
+            if (!part->is_byte && (part != &factor.second || factor.has_second) &&
+                (part->value == 0 || part->value > factors.size())) {
+                throw std::out_of_range("Invalid factor reference");
+            }
+        }
+        factor.base_length = base_part_length(factor.first);
+        if (factor.has_second) {
+            factor.base_length += base_part_length(factor.second);
+        }
+        if (factor.base_length == 0 && factor.length > 0) {
+            throw std::out_of_range("Empty factor cannot be extended");
+        }
+        if (type == 4 && factor.length > factor.base_length) {
+            throw std::out_of_range("Truncation longer than factor");
+        }
+
+        factors.push_back(factor);
+        factor_starts.push_back(factor_starts.back() + factor.length);
+        i += record_size;
+    }
+}
+
+uint64_t LzdrRandomAccess::base_part_length(const BasePart &part) const {
+    if (part.is_byte) {
+        return 1;
+    }
+    return factors[part.value - 1].length;
+}
+
+uint64_t LzdrRandomAccess::size() const {
+    return factor_starts.back();
+}
+
+size_t LzdrRandomAccess::num_factors() const {
+    return factors.size();
+}
+
+uint64_t LzdrRandomAccess::factor_length(const size_t factor) const {
+    if (factor == 0 || factor > factors.size()) {
+        throw std::out_of_range("Invalid factor");
+    }
+    return factors[factor - 1].length;
+}
+
+const LzdrRandomAccess::FactorInfo &LzdrRandomAccess::factor_info(const size_t factor) const {
+    if (factor == 0 || factor > factors.size()) {
+        throw std::out_of_range("Invalid factor");
+    }
+    return factors[factor - 1];
+}
+
+uint64_t LzdrRandomAccess::factor_start(const size_t factor) const {
+    if (factor == 0 || factor > factors.size()) {
+        throw std::out_of_range("Invalid factor");
+    }
+    return factor_starts[factor - 1];
+}
+
+std::vector<uint8_t> LzdrRandomAccess::extract_factor(const size_t factor, const uint64_t from, const uint64_t to) const {
+    if (from > to || to > factor_length(factor)) {
+        throw std::out_of_range("Extraction range out of bounds");
+    }
+    std::vector<uint8_t> out;
+    out.reserve(to - from);
+    extract_from_factor(factor, from, to, out);
+    return out;
+}
+
+void LzdrRandomAccess::extract_from_factor(const size_t factor, const uint64_t from, const uint64_t to, std::vector<uint8_t> &out) const {
+    // Tasks are processed in output order, so they are pushed in reverse order
+    std::vector<ExtractTask> tasks = {{ExtractTask::Kind::Factor, factor, from, to}};
+    while (!tasks.empty()) {
+        const ExtractTask task = tasks.back();
+        tasks.pop_back();
+
+        if (task.kind == ExtractTask::Kind::Byte) {
+            out.push_back(static_cast<uint8_t>(task.value));
+            continue;
+        }
+        if (task.kind == ExtractTask::Kind::Copy) {
+            // The factor is periodic, so the rest is a copy of the period extracted right before
+            for (uint64_t j = 0; j < task.to; ++j) {
+                out.push_back(out[out.size() - task.value]);
+            }
+            continue;
+        }
+
+        if (task.from == task.to) {
+            continue;
+        }
+        const FactorInfo &info = factors[task.value - 1];
+        const uint64_t period = info.base_length;
+        const uint64_t direct_len = std::min(task.to - task.from, period);
+        if (task.to - task.from > direct_len) {
+            tasks.push_back({ExtractTask::Kind::Copy, period, 0, task.to - task.from - direct_len});
+        }
+
+        // The directly extracted part covers at most two ranges of the base
+        const uint64_t offset = task.from % period;
+        std::pair<uint64_t, uint64_t> base_ranges[2];
+        size_t num_base_ranges = 0;
+        if (offset + direct_len <= period) {
+            base_ranges[num_base_ranges++] = {offset, offset + direct_len};
+        } else {
+            base_ranges[num_base_ranges++] = {offset, period};
+            base_ranges[num_base_ranges++] = {0, offset + direct_len - period};
+        }
+
+        const uint64_t first_len = base_part_length(info.first);
+        for (size_t r = num_base_ranges; r-- > 0;) {
+            const auto [range_from, range_to] = base_ranges[r];
+            // Push second part before first part, as tasks are processed in reverse order
+            if (info.has_second && range_to > first_len) {
+                const uint64_t part_from = std::max(range_from, first_len) - first_len;
+                const uint64_t part_to = range_to - first_len;
+                if (info.second.is_byte) {
+                    tasks.push_back({ExtractTask::Kind::Byte, info.second.value, 0, 0});
+                } else {
+                    tasks.push_back({ExtractTask::Kind::Factor, info.second.value, part_from, part_to});
+                }
+            }
+            if (range_from < first_len) {
+                const uint64_t part_to = std::min(range_to, first_len);
+                if (info.first.is_byte) {
+                    tasks.push_back({ExtractTask::Kind::Byte, info.first.value, 0, 0});
+                } else {
+                    tasks.push_back({ExtractTask::Kind::Factor, info.first.value, range_from, part_to});
+                }
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> LzdrRandomAccess::extract(const uint64_t from, const uint64_t to) const {
+    if (from > to || to > size()) {
+        throw std::out_of_range("Extraction range out of bounds");
+    }
+    std::vector<uint8_t> out;
+    out.reserve(to - from);
+
+    // Binary search the factor containing from
+    size_t factor = std::upper_bound(factor_starts.begin(), factor_starts.end(), from) - factor_starts.begin();
+    uint64_t position = from;
+    while (position < to) {
+        const uint64_t factor_start = factor_starts[factor - 1];
+        const uint64_t factor_end = factor_starts[factor];
+        const uint64_t end = std::min(to, factor_end);
+        extract_from_factor(factor, position - factor_start, end - factor_start, out);
+        position = end;
+        ++factor;
+    }
+    return out;
+}
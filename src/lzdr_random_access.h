@@ -0,0 +1,68 @@
+#ifndef LZDR_RANDOM_ACCESS_H
+#define LZDR_RANDOM_ACCESS_H
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Random access to LZDR (and LZD+) compressed data without decompressing everything.
+//
+// Every factor is the periodic extension (or prefix) of its base, where the base is the concatenation
+// of up to two bytes or previous factors (combination), a previous factor (truncation, repetition)
+// or a single byte (repetition). Extracting a range descends into the bases and copies periodic parts
+// from the already extracted output.
+class LzdrRandomAccess {
+public:
+    // A part of the base of a factor, either a byte or a previous factor
+    struct BasePart {
+        uint64_t value;
+        bool is_byte;
+    };
+
+    struct FactorInfo {
+        BasePart first;
+        // Only used if has_second is true
+        BasePart second;
+        bool has_second;
+        uint64_t base_length;
+        uint64_t length;
+    };
+
+private:
+    std::vector<FactorInfo> factors;
+    // factor_starts[i] is the position of factor i + 1 in the decompressed data,
+    // the last entry is the size of the decompressed data
+    std::vector<uint64_t> factor_starts;
+
+    void extract_from_factor(size_t factor, uint64_t from, uint64_t to, std::vector<uint8_t> &out) const;
+
+public:
+    explicit LzdrRandomAccess(Slice compressed);
+
+    // Size of the decompressed data
+    [[nodiscard]] uint64_t size() const;
+
+    [[nodiscard]] size_t num_factors() const;
+
+    // Length of factor (1-based index as in the compressed data)
+    [[nodiscard]] uint64_t factor_length(size_t factor) const;
+
+    [[nodiscard]] const FactorInfo &factor_info(size_t factor) const;
+
+    [[nodiscard]] uint64_t base_part_length(const BasePart &part) const;
+
+    // Position of factor in the decompressed data
+    [[nodiscard]] uint64_t factor_start(size_t factor) const;
+
+    // Returns the bytes in [from, to) of factor
+    [[nodiscard]] std::vector<uint8_t> extract_factor(size_t factor, uint64_t from, uint64_t to) const;
+
+    // Returns the decompressed bytes in [from, to).
+    // Takes O(h + to - from) time, where h is the height of the grammar (the longest chain of bases),
+    // not O(log n + to - from): the descent into the bases is not balanced.
+    // Throws std::out_of_range if the range is not within the decompressed data
+    [[nodiscard]] std::vector<uint8_t> extract(uint64_t from, uint64_t to) const;
+};
+
+#endif //LZDR_RANDOM_ACCESS_H
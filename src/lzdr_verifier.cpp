@@ -0,0 +1,75 @@
+#include "lzdr_verifier.h"
+#include "io_pipeline.h"
+#include "lzdr_dictionary.h"
+#include "lzdr_linear_time.h"
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    // Small blocks, so a mismatch is found soon after the factor has been added
+    constexpr size_t VERIFIER_BLOCK_SIZE = 64 * 1024;
+}
+
+ConcurrentLzdrVerifier::ConcurrentLzdrVerifier(const Slice input, const LzdrDictionary *dictionary)
+    : input(input), dictionary(dictionary), blocks([this](const Slice block) { verify(block); }, VERIFIER_BLOCK_SIZE) {
+}
+
+void ConcurrentLzdrVerifier::verify(const Slice block) {
+    const size_t num_dictionary_factors = dictionary != nullptr ? dictionary->num_factors() : 0;
+    const auto factor_at = [&](const uint64_t index) {
+        if (index == 0 || index > num_dictionary_factors + factor_ends.size()) {
+            throw std::out_of_range("Invalid factor reference");
+        }
+        if (index <= num_dictionary_factors) {
+            return dictionary->factor(index);
+        }
+        const size_t k = index - num_dictionary_factors - 1;
+        const uint64_t start = k == 0 ? 0 : factor_ends[k - 1];
+        return input.slice(start, factor_ends[k] - start);
+    };
+
+    pending_record.insert(pending_record.end(), block.begin(), block.end());
+    size_t i = 0;
+    while (i < pending_record.size()) {
+        const size_t num_factor = factor_ends.size() + 1;
+        const uint64_t start = factor_ends.empty() ? 0 : factor_ends.back();
+        try {
+            const size_t record_size = lzdr_compressor::record_size(pending_record[i]);
+            if (record_size > pending_record.size() - i) {
+                break;
+            }
+            const std::vector<uint8_t> factor = lzdr_compressor::decode_record(pending_record.data() + i, factor_at);
+            if (factor.size() > input.size() - start || !(input.slice(start, factor.size()) == Slice(factor))) {
+                throw std::out_of_range("Decompressed not equal to input");
+            }
+            factor_ends.push_back(start + factor.size());
+            i += record_size;
+        } catch (const std::out_of_range &error) {
+            throw std::out_of_range("Factor " + std::to_string(num_factor) + " (at position " + std::to_string(start) + "): " + error.what());
+        }
+    }
+    pending_record.erase(pending_record.begin(), pending_record.begin() + static_cast<std::ptrdiff_t>(i));
+}
+
+void ConcurrentLzdrVerifier::add(const std::vector<uint8_t> &compressed_factor) {
+    if (blocks.has_failed()) {
+        // Rethrows the mismatch
+        blocks.finish();
+    }
+    blocks.write(compressed_factor.data(), compressed_factor.size());
+}
+
+void ConcurrentLzdrVerifier::finish() {
+    blocks.finish();
+    if (!pending_record.empty()) {
+        throw std::out_of_range("Compressed data ends within a record");
+    }
+    if ((factor_ends.empty() ? 0 : factor_ends.back()) != input.size()) {
+        throw std::out_of_range("Decompressed shorter than input");
+    }
+}
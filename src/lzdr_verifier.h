@@ -0,0 +1,45 @@
+#ifndef LZDR_VERIFIER_H
+#define LZDR_VERIFIER_H
+#include "io_pipeline.h"
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class LzdrDictionary;
+
+// Checks the compressed data of an LZDR (or LZD+) factorization against its input while the factorization runs (-c).
+//
+// The records of the factors are handed in blocks to a verifier thread, which decodes them one by one and compares
+// every factor with the input at its position. A factor that equals the input is a slice of the input, so only the
+// end positions of the factors are kept, neither the compressed data nor the decompressed data.
+// The first mismatching factor stops the verification, the next add (or finish) throws std::out_of_range with its index.
+class ConcurrentLzdrVerifier {
+    Slice input;
+    const LzdrDictionary *dictionary;
+    // End position in the input of every verified factor
+    std::vector<uint64_t> factor_ends;
+    // Bytes of an incomplete record at the end of the last block
+    std::vector<uint8_t> pending_record;
+    PipelinedOutput blocks;
+
+    void verify(Slice block);
+
+public:
+    // The input and the dictionary (if not null) have to stay valid until finish returns.
+    // Bytes of input are only read after a factor covering them has been added
+    explicit ConcurrentLzdrVerifier(Slice input, const LzdrDictionary *dictionary = nullptr);
+
+    ConcurrentLzdrVerifier(const ConcurrentLzdrVerifier &) = delete;
+    ConcurrentLzdrVerifier &operator=(const ConcurrentLzdrVerifier &) = delete;
+
+    // Hands the record of the next factor to the verifier thread
+    void add(const std::vector<uint8_t> &compressed_factor);
+
+    // Waits for the verifier thread, throws std::out_of_range if the decompressed data is not equal to the input.
+    // Can be called again after add or finish has thrown, e.g. while cleaning up, and throws the same mismatch
+    void finish();
+};
+
+#endif //LZDR_VERIFIER_H
@@ -0,0 +1,308 @@
+#include "lzw.h"
+#include "slice.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    constexpr char LZW_MAGIC[8] = {'L', 'Z', 'D', 'R', 'L', 'Z', 'W', 'C'};
+    constexpr uint32_t LZW_VERSION = 1;
+    constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    constexpr uint32_t FIRST_ENTRY_CODE = 258;
+
+    // The bits of a code if the dictionary has num_codes codes
+    unsigned code_bits(const uint32_t num_codes) {
+        unsigned bits = LZW_MIN_CODE_BITS;
+        while ((uint32_t{1} << bits) < num_codes) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    class BitWriter {
+        std::vector<uint8_t> &out;
+        uint64_t buffer = 0;
+        unsigned num_bits = 0;
+
+    public:
+        explicit BitWriter(std::vector<uint8_t> &out) : out(out) {
+        }
+
+        void write(const uint32_t code, const unsigned bits) {
+            buffer |= static_cast<uint64_t>(code) << num_bits;
+            num_bits += bits;
+            while (num_bits >= 8) {
+                out.push_back(static_cast<uint8_t>(buffer));
+                buffer >>= 8;
+                num_bits -= 8;
+            }
+        }
+
+        // Pads the last byte with 0 bits
+        void flush() {
+            if (num_bits > 0) {
+                out.push_back(static_cast<uint8_t>(buffer));
+                buffer = 0;
+                num_bits = 0;
+            }
+        }
+    };
+
+    // Trie of the encoder dictionary: the edge from the entry parent_code with the byte leads to the entry child_code.
+    // All edges are in one hash table with linear probing, which is at most half full.
+    class LzwTrie {
+        struct Edge {
+            // parent_code << 8 | byte
+            uint32_t key;
+            // 0 if the slot is empty (entries have codes of at least FIRST_ENTRY_CODE)
+            uint32_t child_code;
+        };
+
+        std::vector<Edge> edges;
+        size_t mask;
+
+        [[nodiscard]] size_t slot(const uint32_t key) const {
+            return ((key * size_t{0x9E3779B97F4A7C15}) >> 32) & mask;
+        }
+
+    public:
+        explicit LzwTrie(const size_t max_num_edges) {
+            size_t size = 16;
+            while (size < 2 * max_num_edges) {
+                size *= 2;
+            }
+            edges.resize(size);
+            mask = size - 1;
+        }
+
+        // Returns 0 if there is no edge
+        [[nodiscard]] uint32_t find(const uint32_t parent_code, const uint8_t byte) const {
+            const uint32_t key = parent_code << 8 | byte;
+            for (size_t i = slot(key); ; i = (i + 1) & mask) {
+                if (edges[i].child_code == 0 || edges[i].key == key) {
+                    return edges[i].child_code;
+                }
+            }
+        }
+
+        // Requires that there is no edge yet
+        void insert(const uint32_t parent_code, const uint8_t byte, const uint32_t child_code) {
+            const uint32_t key = parent_code << 8 | byte;
+            size_t i = slot(key);
+            while (edges[i].child_code != 0) {
+                i = (i + 1) & mask;
+            }
+            edges[i] = {key, child_code};
+        }
+
+        void clear() {
+            std::fill(edges.begin(), edges.end(), Edge{0, 0});
+        }
+    };
+
+    template<typename T>
+    void append_bytes(std::vector<uint8_t> &out, const T &value) {
+        out.insert(out.end(), reinterpret_cast<const uint8_t *>(&value), reinterpret_cast<const uint8_t *>(&value) + sizeof(value));
+    }
+}
+
+// Returns the number of factors
+size_t lzw_compress(const Slice input, const bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output,
+                    const unsigned max_code_bits) {
+    if (max_code_bits < LZW_MIN_CODE_BITS || max_code_bits > LZW_MAX_CODE_BITS) {
+        throw std::out_of_range("Maximum code width must be between 9 and 24 bits");
+    }
+    std::vector<uint8_t> compressed_data;
+    LzwHeader header = {{}, LZW_VERSION, BYTE_ORDER_MARK, max_code_bits};
+    std::memcpy(header.magic, LZW_MAGIC, sizeof(LZW_MAGIC));
+    append_bytes(compressed_data, header);
+    BitWriter writer(compressed_data);
+
+    // The dictionary is reset before it has max_codes codes, so every code fits into max_code_bits bits
+    const uint32_t max_codes = uint32_t{1} << max_code_bits;
+    LzwTrie trie(std::min<size_t>(max_codes, input.size() + FIRST_ENTRY_CODE) - FIRST_ENTRY_CODE);
+    uint32_t num_codes = FIRST_ENTRY_CODE;
+    unsigned bits = LZW_MIN_CODE_BITS;
+    size_t num_factors = 0;
+    size_t num_resets = 0;
+    if (input.size() > 0) {
+        // The longest entry that is a prefix of the rest of the input
+        uint32_t current_code = input[0];
+        [[maybe_unused]] size_t factor_start = 0;
+        for (size_t i = 1; i < input.size(); ++i) {
+            const uint8_t byte = input[i];
+            if (const uint32_t child_code = trie.find(current_code, byte); child_code != 0) {
+                current_code = child_code;
+                continue;
+            }
+
+            ++num_factors;
+
+#ifndef NDEBUG
+            std::cout << "Factor " << num_factors << ": " << input.slice(factor_start, i - factor_start) << std::endl;
+#endif
+
+            writer.write(current_code, bits);
+            trie.insert(current_code, byte, num_codes);
+            ++num_codes;
+            if (num_codes == max_codes) {
+                writer.write(LZW_CLEAR_CODE, bits);
+                trie.clear();
+                num_codes = FIRST_ENTRY_CODE;
+                bits = LZW_MIN_CODE_BITS;
+                ++num_resets;
+            } else if (num_codes > uint32_t{1} << bits) {
+                ++bits;
+            }
+            current_code = byte;
+            factor_start = i;
+        }
+
+        ++num_factors;
+
+#ifndef NDEBUG
+        std::cout << "Factor " << num_factors << ": " << input.slice(factor_start) << std::endl;
+#endif
+
+        writer.write(current_code, bits);
+    }
+    // The decoder adds the entry of the last code only with the next code, but already reads the next code as if it
+    // was added. There is no next entry, so the end code takes the bits of one more code
+    writer.write(LZW_END_CODE, code_bits(num_codes + (input.size() > 0 ? 1 : 0)));
+    writer.flush();
+
+    if (check_decompressed_equals_input) {
+        if (const std::vector<uint8_t> decompressed_data = lzw_decompress(compressed_data); !(input == Slice(decompressed_data))) {
+            throw std::out_of_range("Decompressed not equal to input");
+        }
+    }
+    if (compressed_output != nullptr) {
+        compressed_output->insert(compressed_output->end(), compressed_data.begin(), compressed_data.end());
+    }
+
+    std::cout << "Num dictionary resets: " << num_resets << std::endl;
+
+    return num_factors;
+}
+
+bool is_lzw(const std::vector<uint8_t> &compressed) {
+    return compressed.size() >= sizeof(LZW_MAGIC) && std::memcmp(compressed.data(), LZW_MAGIC, sizeof(LZW_MAGIC)) == 0;
+}
+
+void LzwDecoder::read_header() {
+    LzwHeader header = {};
+    std::memcpy(&header, header_bytes.data(), sizeof(header));
+    if (!is_lzw(header_bytes) || header.version != LZW_VERSION || header.byte_order_mark != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Unsupported LZW version or byte order");
+    }
+    if (header.max_code_bits < LZW_MIN_CODE_BITS || header.max_code_bits > LZW_MAX_CODE_BITS) {
+        throw std::runtime_error("Invalid maximum code width");
+    }
+    max_code_bits = header.max_code_bits;
+    const size_t max_codes = size_t{1} << max_code_bits;
+    prefixes.resize(max_codes);
+    last_bytes.resize(max_codes);
+    lengths.resize(max_codes);
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        last_bytes[byte] = static_cast<uint8_t>(byte);
+        lengths[byte] = 1;
+    }
+    reset_dictionary();
+}
+
+void LzwDecoder::reset_dictionary() {
+    num_codes = FIRST_ENTRY_CODE;
+    previous_code = LZW_CLEAR_CODE;
+}
+
+void LzwDecoder::decode_code(const uint32_t code, std::vector<uint8_t> &output) {
+    if (code == LZW_CLEAR_CODE) {
+        reset_dictionary();
+        return;
+    }
+    if (code == LZW_END_CODE) {
+        ended = true;
+        return;
+    }
+    const bool has_previous_code = previous_code != LZW_CLEAR_CODE;
+    const bool is_new_entry = code == num_codes;
+    if (code > num_codes || (is_new_entry && !has_previous_code)) {
+        throw std::runtime_error("Invalid LZW code");
+    }
+    if (has_previous_code && num_codes == prefixes.size()) {
+        throw std::runtime_error("LZW dictionary overflow");
+    }
+    if (is_new_entry) {
+        // The entry is the previous entry followed by its own first byte (the input repeats the previous entry)
+        prefixes[code] = previous_code;
+        last_bytes[code] = previous_first_byte;
+        lengths[code] = lengths[previous_code] + 1;
+        ++num_codes;
+    }
+
+    // The entry is written from its last byte backwards
+    const size_t start = output.size();
+    output.resize(start + lengths[code]);
+    uint32_t entry = code;
+    for (size_t i = output.size(); i > start + 1; --i) {
+        output[i - 1] = last_bytes[entry];
+        entry = prefixes[entry];
+    }
+    output[start] = static_cast<uint8_t>(entry);
+
+    if (has_previous_code && !is_new_entry) {
+        prefixes[num_codes] = previous_code;
+        last_bytes[num_codes] = output[start];
+        lengths[num_codes] = lengths[previous_code] + 1;
+        ++num_codes;
+    }
+    previous_code = code;
+    previous_first_byte = output[start];
+}
+
+void LzwDecoder::decode(const Slice compressed_block, std::vector<uint8_t> &output) {
+    for (const uint8_t byte: compressed_block) {
+        if (header_bytes.size() < sizeof(LzwHeader)) {
+            header_bytes.push_back(byte);
+            if (header_bytes.size() == sizeof(LzwHeader)) {
+                read_header();
+            }
+            continue;
+        }
+        if (ended) {
+            throw std::runtime_error("Data after the end of the LZW stream");
+        }
+        bit_buffer |= static_cast<uint64_t>(byte) << num_buffered_bits;
+        num_buffered_bits += 8;
+        // The code after the previous one is read as if the entry of the previous code was added already
+        for (unsigned bits = code_bits(num_codes + (previous_code != LZW_CLEAR_CODE ? 1 : 0));
+             !ended && num_buffered_bits >= bits; bits = code_bits(num_codes + (previous_code != LZW_CLEAR_CODE ? 1 : 0))) {
+            const uint32_t code = static_cast<uint32_t>(bit_buffer & ((uint64_t{1} << bits) - 1));
+            bit_buffer >>= bits;
+            num_buffered_bits -= bits;
+            decode_code(code, output);
+        }
+        if (ended && num_buffered_bits >= 8) {
+            throw std::runtime_error("Data after the end of the LZW stream");
+        }
+    }
+}
+
+void LzwDecoder::finish() const {
+    if (!ended) {
+        throw std::runtime_error("LZW stream truncated");
+    }
+}
+
+std::vector<uint8_t> lzw_decompress(const std::vector<uint8_t> &compressed) {
+    std::vector<uint8_t> decompressed;
+    LzwDecoder decoder;
+    decoder.decode(Slice(compressed), decompressed);
+    decoder.finish();
+    return decompressed;
+}
@@ -0,0 +1,78 @@
+#ifndef LZW_H
+#define LZW_H
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LZW with a dictionary of at most 2^max_code_bits codes, for comparisons with LZD+ and LZDR on the same input.
+//
+// Codes 0 to 255 are the bytes, LZW_CLEAR_CODE resets the dictionary and LZW_END_CODE ends the stream.
+// Every other code is the entry of a previous code followed by one byte. Codes start with 9 bits and take one more bit
+// as soon as the dictionary outgrows them. Once the dictionary is full (the memory budget), it is reset.
+// The encoder dictionary is a trie whose edges (code, byte) are kept in one open addressing hash table, so every
+// input byte takes one lookup.
+//
+// File layout (the header in native byte order):
+//   LzwHeader
+//   codes (bit stream, least significant bit first, the last byte padded with 0 bits)
+struct LzwHeader {
+    char magic[8];
+    uint32_t version;
+    // Used to detect files written on a machine with another byte order
+    uint32_t byte_order_mark;
+    uint32_t max_code_bits;
+};
+
+constexpr uint32_t LZW_CLEAR_CODE = 256;
+constexpr uint32_t LZW_END_CODE = 257;
+constexpr unsigned LZW_MIN_CODE_BITS = 9;
+constexpr unsigned LZW_MAX_CODE_BITS = 24;
+// 2^16 codes take about 1 MiB in the encoder and the decoder
+constexpr unsigned LZW_DEFAULT_MAX_CODE_BITS = 16;
+
+// Appends the file to compressed_output (if not null). Returns the number of factors (codes of dictionary entries).
+// Throws std::out_of_range if max_code_bits is not between LZW_MIN_CODE_BITS and LZW_MAX_CODE_BITS
+size_t lzw_compress(Slice input, bool check_decompressed_equals_input, std::vector<uint8_t> *compressed_output = nullptr,
+                    unsigned max_code_bits = LZW_DEFAULT_MAX_CODE_BITS);
+
+// Returns true if compressed starts with the magic of lzw_compress
+bool is_lzw(const std::vector<uint8_t> &compressed);
+
+// Decodes the file of lzw_compress block by block, so it can be decompressed while it is read and the decompressed
+// data can be written while decoding. Only the dictionary is kept, not the decompressed data.
+class LzwDecoder {
+    // Dictionary: the code of the entry without its last byte, the last byte and the length of each entry
+    std::vector<uint32_t> prefixes;
+    std::vector<uint8_t> last_bytes;
+    std::vector<uint32_t> lengths;
+    std::vector<uint8_t> header_bytes;
+    unsigned max_code_bits = 0;
+    uint64_t bit_buffer = 0;
+    unsigned num_buffered_bits = 0;
+    uint32_t num_codes = 0;
+    // The previous code since the last reset, none if equal to LZW_CLEAR_CODE
+    uint32_t previous_code = LZW_CLEAR_CODE;
+    uint8_t previous_first_byte = 0;
+    bool ended = false;
+
+    void read_header();
+
+    void reset_dictionary();
+
+    void decode_code(uint32_t code, std::vector<uint8_t> &output);
+
+public:
+    // Appends the bytes decoded from the next block of the file to output.
+    // Throws std::runtime_error if the file is malformed
+    void decode(Slice compressed_block, std::vector<uint8_t> &output);
+
+    // Throws std::runtime_error if the file has ended before the end code
+    void finish() const;
+};
+
+// Throws std::runtime_error if the file is malformed
+std::vector<uint8_t> lzw_decompress(const std::vector<uint8_t> &compressed);
+
+#endif //LZW_H
@@ -0,0 +1,106 @@
+#include "mismatch.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MISMATCH_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define MISMATCH_X86_KERNELS 0
+#endif
+
+namespace {
+    // Index of the first differing byte of two unequal words loaded in native byte order
+    size_t first_differing_byte(const uint64_t x) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        return static_cast<size_t>(__builtin_clzll(x)) / 8;
+#else
+        return static_cast<size_t>(__builtin_ctzll(x)) / 8;
+#endif
+    }
+
+#if MISMATCH_X86_KERNELS
+    // SSE2 is part of x86-64, so this kernel is always available there
+    size_t first_mismatch_sse2(const uint8_t *a, const uint8_t *b, const size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            if (const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))); mask != 0xFFFF) {
+                return i + static_cast<size_t>(__builtin_ctz(~mask));
+            }
+        }
+        return i + mismatch_internal::first_mismatch_word(a + i, b + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    size_t first_mismatch_avx2(const uint8_t *a, const uint8_t *b, const size_t n) {
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            if (const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y))); mask != 0xFFFFFFFF) {
+                return i + static_cast<size_t>(__builtin_ctz(~mask));
+            }
+        }
+        return i + first_mismatch_sse2(a + i, b + i, n - i);
+    }
+#endif
+
+    mismatch_internal::MismatchKernel select_kernel() {
+        mismatch_internal::NamedKernel kernels[4];
+        const size_t num_kernels = mismatch_internal::supported_kernels(kernels);
+        return kernels[num_kernels - 1].kernel;
+    }
+}
+
+size_t first_mismatch(const uint8_t *a, const uint8_t *b, const size_t n) {
+    // Most comparisons in the trie walks are short, so avoid the indirect call for them
+    if (n < 8) {
+        return mismatch_internal::first_mismatch_bytewise(a, b, n);
+    }
+    if (n < 16) {
+        return mismatch_internal::first_mismatch_word(a, b, n);
+    }
+    static const mismatch_internal::MismatchKernel kernel = select_kernel();
+    return kernel(a, b, n);
+}
+
+namespace mismatch_internal {
+    size_t first_mismatch_bytewise(const uint8_t *a, const uint8_t *b, const size_t n) {
+        size_t i = 0;
+        while (i < n && a[i] == b[i]) {
+            ++i;
+        }
+        return i;
+    }
+
+    size_t first_mismatch_word(const uint8_t *a, const uint8_t *b, const size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            uint64_t x;
+            uint64_t y;
+            std::memcpy(&x, a + i, 8);
+            std::memcpy(&y, b + i, 8);
+            if (x != y) {
+                return i + first_differing_byte(x ^ y);
+            }
+        }
+        return i + first_mismatch_bytewise(a + i, b + i, n - i);
+    }
+
+    size_t supported_kernels(NamedKernel (&kernels)[4]) {
+        size_t num_kernels = 0;
+        kernels[num_kernels++] = {"bytewise", first_mismatch_bytewise};
+        kernels[num_kernels++] = {"word", first_mismatch_word};
+#if MISMATCH_X86_KERNELS
+        kernels[num_kernels++] = {"sse2", first_mismatch_sse2};
+        if (__builtin_cpu_supports("avx2")) {
+            kernels[num_kernels++] = {"avx2", first_mismatch_avx2};
+        }
+#endif
+        return num_kernels;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef MISMATCH_H
+#define MISMATCH_H
+#include <cstddef>
+#include <cstdint>
+
+// Returns the first index i < n with a[i] != b[i], or n if the first n bytes are equal.
+// Uses the fastest kernel supported by the CPU (selected once at runtime).
+size_t first_mismatch(const uint8_t *a, const uint8_t *b, size_t n);
+
+// Same for wider symbols: the first mismatching byte lies in the first mismatching symbol
+template<typename Symbol>
+size_t first_mismatch(const Symbol *a, const Symbol *b, const size_t n) {
+    return first_mismatch(reinterpret_cast<const uint8_t *>(a), reinterpret_cast<const uint8_t *>(b), n * sizeof(Symbol)) / sizeof(Symbol);
+}
+
+namespace mismatch_internal {
+    using MismatchKernel = size_t (*)(const uint8_t *a, const uint8_t *b, size_t n);
+
+    struct NamedKernel {
+        const char *name;
+        MismatchKernel kernel;
+    };
+
+    size_t first_mismatch_bytewise(const uint8_t *a, const uint8_t *b, size_t n);
+
+    // Compares 8 bytes at once via XOR and counting trailing zeros (portable)
+    size_t first_mismatch_word(const uint8_t *a, const uint8_t *b, size_t n);
+
+    // All kernels supported by the CPU, the last one is used by first_mismatch
+    size_t supported_kernels(NamedKernel (&kernels)[4]);
+}
+
+#endif //MISMATCH_H
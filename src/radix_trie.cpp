@@ -1,11 +1,69 @@
 #include "radix_trie.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
 
-std::string RadixTrieNode::debug_representation_json() const {
+template<>
+void RadixTrie::fill_root_jump_row(const uint8_t first_byte) {
+    RootJumpEntry *row = &root_jump_table->entries[first_byte << 8];
+    const auto it = root_node.edges.find(first_byte);
+    if (it == root_node.edges.end()) {
+        std::fill(row, row + 256, RootJumpEntry{nullptr, nullptr});
+        return;
+    }
+    RadixTrieEdge &first_edge = it->second;
+    std::fill(row, row + 256, RootJumpEntry{&first_edge, nullptr});
+    if (!first_edge.rest_text.empty()) {
+        row[first_edge.rest_text[0]].second_edge = &first_edge;
+        return;
+    }
+    root_jump_table->depth_one_bytes[&first_edge.end_node] = first_byte;
+    for (auto &[second_byte, second_edge]: first_edge.end_node.edges) {
+        row[second_byte].second_edge = &second_edge;
+    }
+}
+
+template<>
+bool RadixTrie::has_root_jump_table() {
+    if (!root_jump_table && root_jump_table_min_factor_nodes > 0 && num_factor_nodes >= root_jump_table_min_factor_nodes) {
+        root_jump_table = std::make_unique<RootJumpTable>();
+        for (size_t first_byte = 0; first_byte < 256; ++first_byte) {
+            fill_root_jump_row(static_cast<uint8_t>(first_byte));
+        }
+    }
+    return root_jump_table != nullptr;
+}
+
+template<>
+void RadixTrie::update_root_jump_table(RadixTrieNode &node, const uint8_t byte) {
+    if (!root_jump_table) {
+        return;
+    }
+    if (&node == &root_node) {
+        fill_root_jump_row(byte);
+    } else if (const auto it = root_jump_table->depth_one_bytes.find(&node); it != root_jump_table->depth_one_bytes.end()) {
+        RootJumpEntry &entry = root_jump_table->entries[it->second << 8 | byte];
+        entry.second_edge = &node.edges.at(byte);
+    }
+}
+
+namespace {
+    // Bytes are appended as characters, wider symbols as their numbers in angle brackets
+    template<typename Symbol>
+    void append_symbol(std::string &text, const Symbol symbol) {
+        if constexpr (sizeof(Symbol) == 1) {
+            text.push_back(static_cast<char>(symbol));
+        } else {
+            text.append("<" + std::to_string(symbol) + ">");
+        }
+    }
+}
+
+template<typename Symbol>
+std::string BasicRadixTrieNode<Symbol>::debug_representation_json() const {
     std::string result;
     result.append("{");
     result.append("\"");
@@ -18,17 +76,17 @@ std::string RadixTrieNode::debug_representation_json() const {
     result.append("{");
 
     // Sort edges by edge text to make result consistent
-    std::vector<std::pair<std::string, const RadixTrieNode*>> edges_list;
+    std::vector<std::pair<std::string, const BasicRadixTrieNode*>> edges_list;
     for (auto &pair : edges) {
         std::string edge_text;
-        edge_text.push_back(static_cast<char>(pair.first));
+        append_symbol(edge_text, pair.first);
         for (size_t i = 0; i < pair.second.rest_text.size(); ++i) {
-            edge_text.push_back(static_cast<char>(pair.second.rest_text[i]));
+            append_symbol(edge_text, pair.second.rest_text[i]);
         }
         edges_list.emplace_back(edge_text, &pair.second.end_node);
     }
     std::sort(edges_list.begin(), edges_list.end(),
-        [](const std::pair<std::string, const RadixTrieNode*>& a, const std::pair<std::string, const RadixTrieNode*>& b) {
+        [](const std::pair<std::string, const BasicRadixTrieNode*>& a, const std::pair<std::string, const BasicRadixTrieNode*>& b) {
             return a.first < b.first;
         });
 
@@ -52,6 +110,10 @@ std::string RadixTrieNode::debug_representation_json() const {
     return result;
 }
 
+template std::string BasicRadixTrieNode<uint8_t>::debug_representation_json() const;
+template std::string BasicRadixTrieNode<uint16_t>::debug_representation_json() const;
+template std::string BasicRadixTrieNode<uint32_t>::debug_representation_json() const;
+
 std::string CountedRadixTrieNode::debug_representation_json() const {
     std::string result;
     result.append("{");
@@ -2,17 +2,91 @@
 #define RADIX_TRIE_H
 #include "slice.h"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 
-class RadixTrieEdge;
+template<typename Symbol>
+class BasicRadixTrieEdge;
 
-class RadixTrieNode {
-    explicit RadixTrieNode(const size_t index, const size_t next_factor_node_index) : index(index), next_factor_node_index(next_factor_node_index) {
+// Defined in small_alphabet.h, which only the factorization of small alphabets includes
+template<unsigned Bits>
+struct RankSymbol;
+
+// Children of a node over the ranks of a small alphabet, with the same interface as the std::unordered_map used for
+// bytes and wider symbols. A bitmap marks the ranks that have an edge, and an array with one entry per edge holds them
+// in rank order, so the edge of a rank is at the number of set bits below it. The array is only allocated with the
+// first child (most nodes are leaves) and grows by one entry per child, and every edge is allocated on its own,
+// so edges never move once inserted. A node takes 16 bytes plus 8 per child instead of a 2^Bits entry array.
+template<unsigned Bits, typename Edge>
+class RankEdgeArray {
+public:
+    using key_type = RankSymbol<Bits>;
+    using mapped_type = Edge;
+    using value_type = std::pair<const key_type, Edge>;
+    using iterator = value_type *;
+
+private:
+    static_assert(key_type::ALPHABET_CAPACITY <= 32, "The bitmap has 32 bits");
+
+    uint32_t ranks = 0;
+    std::unique_ptr<std::unique_ptr<value_type>[]> children;
+
+    [[nodiscard]] size_t position(const key_type symbol) const {
+        return static_cast<size_t>(__builtin_popcount(ranks & ((uint32_t{1} << symbol.rank) - 1)));
+    }
+
+public:
+    [[nodiscard]] iterator find(const key_type symbol) const {
+        return (ranks >> symbol.rank & 1) != 0 ? children[position(symbol)].get() : nullptr;
+    }
+
+    [[nodiscard]] iterator end() const {
+        return nullptr;
+    }
+
+    std::pair<iterator, bool> emplace(const key_type symbol, Edge edge) {
+        const size_t i = position(symbol);
+        if ((ranks >> symbol.rank & 1) != 0) {
+            return {children[i].get(), false};
+        }
+        const size_t num_children = static_cast<size_t>(__builtin_popcount(ranks));
+        std::unique_ptr<std::unique_ptr<value_type>[]> grown_children(new std::unique_ptr<value_type>[num_children + 1]);
+        std::move(children.get(), children.get() + i, grown_children.get());
+        std::move(children.get() + i, children.get() + num_children, grown_children.get() + i + 1);
+        grown_children[i] = std::make_unique<value_type>(symbol, std::move(edge));
+        children = std::move(grown_children);
+        ranks |= uint32_t{1} << symbol.rank;
+        return {children[i].get(), true};
+    }
+
+    void clear() {
+        ranks = 0;
+        children.reset();
+    }
+};
+
+template<typename Symbol, typename Edge>
+struct RadixTrieEdgeMap {
+    using type = std::unordered_map<Symbol, Edge>;
+};
+
+template<unsigned Bits, typename Edge>
+struct RadixTrieEdgeMap<RankSymbol<Bits>, Edge> {
+    using type = RankEdgeArray<Bits, Edge>;
+};
+
+// Node of a radix trie over bytes (RadixTrieNode), wider symbols or the ranks of a small alphabet
+template<typename Symbol>
+class BasicRadixTrieNode {
+    explicit BasicRadixTrieNode(const size_t index, const size_t next_factor_node_index) : index(index), next_factor_node_index(next_factor_node_index) {
     }
 
 public:
@@ -23,46 +97,112 @@ public:
     // * If this is a factor node, this is equal to the index of this node
     // * If this is a splitting node, this is equal to the index of one of this node's (maybe indirect) factor node children
     size_t next_factor_node_index;
-    std::unordered_map<uint8_t, RadixTrieEdge> edges;
+    typename RadixTrieEdgeMap<Symbol, BasicRadixTrieEdge<Symbol> >::type edges;
 
-    static RadixTrieNode create_root_node() {
-        return RadixTrieNode(0, 0);
+    static BasicRadixTrieNode create_root_node() {
+        return BasicRadixTrieNode(0, 0);
     }
 
-    static RadixTrieNode create_factor_node(const size_t index) {
-        return RadixTrieNode(index, index);
+    static BasicRadixTrieNode create_factor_node(const size_t index) {
+        return BasicRadixTrieNode(index, index);
     }
 
-    static RadixTrieNode create_splitting_node(const size_t next_factor_node_index) {
-        return RadixTrieNode(0, next_factor_node_index);
+    static BasicRadixTrieNode create_splitting_node(const size_t next_factor_node_index) {
+        return BasicRadixTrieNode(0, next_factor_node_index);
     }
 
-    RadixTrieNode copy_without_edges() const {
-        return RadixTrieNode(index, next_factor_node_index);
+    BasicRadixTrieNode copy_without_edges() const {
+        return BasicRadixTrieNode(index, next_factor_node_index);
     }
 
     std::string debug_representation_json() const;
 };
 
-class RadixTrieEdge {
+template<typename Symbol>
+class BasicRadixTrieEdge {
 public:
-    RadixTrieNode end_node;
-    Slice rest_text;
+    BasicRadixTrieNode<Symbol> end_node;
+    BasicSlice<Symbol> rest_text;
 
-    RadixTrieEdge(RadixTrieNode end_node, const Slice rest_text) : end_node(std::move(end_node)), rest_text(rest_text) {
+    BasicRadixTrieEdge(BasicRadixTrieNode<Symbol> end_node, const BasicSlice<Symbol> rest_text) : end_node(std::move(end_node)), rest_text(rest_text) {
     }
 };
 
-class RadixTrie {
+using RadixTrieNode = BasicRadixTrieNode<uint8_t>;
+using RadixTrieEdge = BasicRadixTrieEdge<uint8_t>;
+
+// Cached edges of a two-byte path from the root node
+struct RootJumpEntry {
+    // The root edge of the first byte (nullptr if there is none)
+    RadixTrieEdge* first_edge;
+    // The edge containing the second byte (equal to first_edge if the second byte is on its rest text,
+    // nullptr if there is none)
+    RadixTrieEdge* second_edge;
+};
+
+struct RootJumpTable {
+    // Indexed by (first byte << 8) | second byte
+    std::array<RootJumpEntry, 65536> entries;
+    // The first byte of every node at depth one (the end node of a root edge with an empty rest text)
+    std::unordered_map<const RadixTrieNode *, uint8_t> depth_one_bytes;
+};
+
+// A byte trie only allocates its root jump table once it has this many factor nodes: for smaller inputs,
+// clearing and filling the 1 MiB table takes longer than the lookups it saves
+constexpr size_t ROOT_JUMP_TABLE_MIN_FACTOR_NODES = 8192;
+
+template<typename Symbol>
+class BasicRadixTrie {
 public:
-    RadixTrieNode root_node;
+    BasicRadixTrieNode<Symbol> root_node;
     // The number of factor nodes, including the root node
     size_t num_factor_nodes;
+    // Optional table of the edges of all two-byte paths from the root node, including the paths that do not exist.
+    // insert_into_radix_trie keeps it up to date, so a lookup is a single read.
+    // Only available for byte tries: a table of all two-symbol paths would be too large for wider symbols.
+    std::unique_ptr<RootJumpTable> root_jump_table;
+
+private:
+    // The table is allocated once the trie has this many factor nodes (0: not enabled)
+    size_t root_jump_table_min_factor_nodes = 0;
+
+    void fill_root_jump_row(uint8_t first_byte);
+
+public:
+    BasicRadixTrie() : root_node(BasicRadixTrieNode<Symbol>::create_root_node()), num_factor_nodes(1) {
+    }
+
+    void enable_root_jump_table(const size_t min_factor_nodes = ROOT_JUMP_TABLE_MIN_FACTOR_NODES) {
+        static_assert(std::is_same_v<Symbol, uint8_t>, "The root jump table is only available for byte tries");
+        root_jump_table_min_factor_nodes = std::max<size_t>(min_factor_nodes, 1);
+    }
+
+    // Returns true if the root jump table is enabled and the trie is large enough, then allocates the table
+    bool has_root_jump_table();
 
-    RadixTrie() : root_node(RadixTrieNode::create_root_node()), num_factor_nodes(1) {
+    // Requires has_root_jump_table().
+    // Returns the edges of the path first_byte second_byte (second_edge is nullptr if only the first byte exists,
+    // both are nullptr if none exists)
+    [[nodiscard]] RootJumpEntry root_jump(const uint8_t first_byte, const uint8_t second_byte) const {
+        return root_jump_table->entries[first_byte << 8 | second_byte];
     }
+
+    // Updates the root jump table (if allocated) after the edge of byte got inserted below node, or got split
+    // so that its rest text is empty
+    void update_root_jump_table(BasicRadixTrieNode<Symbol> &node, uint8_t byte);
 };
 
+using RadixTrie = BasicRadixTrie<uint8_t>;
+
+template<>
+void RadixTrie::fill_root_jump_row(uint8_t first_byte);
+
+template<>
+bool RadixTrie::has_root_jump_table();
+
+template<>
+void RadixTrie::update_root_jump_table(RadixTrieNode &node, uint8_t byte);
+
 // Alternative version of radix trie where nodes are counted:
 
 class CountedRadixTrieEdge;
@@ -1,6 +1,7 @@
 #include "slice.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <limits>
 
@@ -43,8 +44,8 @@ namespace {
 
 std::size_t SliceHash::operator()(const Slice &slice) const {
     std::size_t seed = 0;
-    for (size_t i = 0; i < slice.size(); ++i) {
-        hash_combine(seed, slice[i]);
+    for (const uint8_t byte: slice) {
+        hash_combine(seed, byte);
     }
     return seed;
 }
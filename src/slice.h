@@ -1,5 +1,7 @@
 #ifndef SLICE_H
 #define SLICE_H
+#include "mismatch.h"
+
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
@@ -10,34 +12,48 @@
 #include <string>
 #include <vector>
 
-// Represents a slice of bytes
-class Slice {
-    const uint8_t *internal_data;
+// Byte access with operator[] is bounds checked in debug builds (and therefore in --test),
+// but not in release builds, as it is used in the innermost loops of the factorizations.
+// Define SLICE_CHECKED_ACCESS to 1 to keep the checks in a release build.
+#ifndef SLICE_CHECKED_ACCESS
+#ifndef NDEBUG
+#define SLICE_CHECKED_ACCESS 1
+#else
+#define SLICE_CHECKED_ACCESS 0
+#endif
+#endif
+
+// Represents a slice of symbols (bytes, or 16/32-bit tokens for wide-symbol alphabets)
+template<typename Symbol>
+class BasicSlice {
+    const Symbol *internal_data;
     size_t internal_length;
 
 public:
-    Slice(const uint8_t *data, const size_t length) : internal_data(data), internal_length(length) {
+    BasicSlice(const Symbol *data, const size_t length) : internal_data(data), internal_length(length) {
     }
 
-    explicit Slice(const uint8_t *data) : internal_data(data), internal_length(sizeof(data)) {
+    explicit BasicSlice(const Symbol *data) : internal_data(data), internal_length(sizeof(data)) {
     }
 
-    explicit Slice(const std::vector<uint8_t> &vec) : internal_data(vec.data()), internal_length(vec.size()) {
+    explicit BasicSlice(const std::vector<Symbol> &vec) : internal_data(vec.data()), internal_length(vec.size()) {
     }
 
-    explicit Slice(const std::string &str) : internal_data(reinterpret_cast<const uint8_t *>(str.data())),
-                                             internal_length(str.size()) {
+    explicit BasicSlice(const std::string &str) : internal_data(reinterpret_cast<const Symbol *>(str.data())),
+                                                  internal_length(str.size()) {
+        static_assert(sizeof(Symbol) == 1, "Only byte slices can view strings");
     }
 
-    explicit Slice(const char *str) : internal_data(reinterpret_cast<const uint8_t *>(str)),
-                                      internal_length(strlen(str)) {
+    explicit BasicSlice(const char *str) : internal_data(reinterpret_cast<const Symbol *>(str)),
+                                           internal_length(strlen(str)) {
+        static_assert(sizeof(Symbol) == 1, "Only byte slices can view strings");
     }
 
-    static Slice create_empty() {
-        return Slice{nullptr, 0};
+    static BasicSlice create_empty() {
+        return BasicSlice{nullptr, 0};
     }
 
-    [[nodiscard]] const uint8_t *data() const {
+    [[nodiscard]] const Symbol *data() const {
         return internal_data;
     }
 
@@ -49,40 +65,66 @@ public:
         return internal_length == 0;
     }
 
-    const uint8_t &operator[](const size_t index) const {
+    [[nodiscard]] const Symbol *begin() const {
+        return internal_data;
+    }
+
+    [[nodiscard]] const Symbol *end() const {
+        return internal_data + internal_length;
+    }
+
+    // Always bounds checked
+    [[nodiscard]] const Symbol &at(const size_t index) const {
         if (index >= internal_length) {
             throw std::out_of_range("Index out of bounds");
         }
         return internal_data[index];
     }
 
-    bool operator==(const Slice &other) const {
+    // Only bounds checked if SLICE_CHECKED_ACCESS is enabled
+    const Symbol &operator[](const size_t index) const {
+#if SLICE_CHECKED_ACCESS
+        return at(index);
+#else
+        return internal_data[index];
+#endif
+    }
+
+    // Returns the length of the longest common prefix of this and other
+    [[nodiscard]] size_t common_prefix_length(const BasicSlice &other) const {
+        return first_mismatch(internal_data, other.internal_data, std::min(internal_length, other.internal_length));
+    }
+
+    bool operator==(const BasicSlice &other) const {
         return internal_length == other.internal_length
-               && std::memcmp(internal_data, other.internal_data, internal_length) == 0;
+               && std::memcmp(internal_data, other.internal_data, internal_length * sizeof(Symbol)) == 0;
     }
 
     // Returns a new slice that starts at pos and has length count.
     // Basically, a view of [pos, pos + count).
-    [[nodiscard]] Slice slice(const size_t pos) const {
+    [[nodiscard]] BasicSlice slice(const size_t pos) const {
         if (pos > internal_length) {
             throw std::out_of_range("Slice out of bounds");
         }
-        const Slice s(internal_data + pos, internal_length - pos);
+        const BasicSlice s(internal_data + pos, internal_length - pos);
         return s;
     }
 
     // Returns a new slice with view [pos, pos + rlen), where rlen is the smaller of count and size() - pos.
-    [[nodiscard]] Slice slice(const size_t pos, const size_t count) const {
+    [[nodiscard]] BasicSlice slice(const size_t pos, const size_t count) const {
         if (pos > internal_length) {
             throw std::out_of_range("Slice out of bounds");
         }
-        const Slice s(internal_data + pos, std::min(count, internal_length - pos));
+        const BasicSlice s(internal_data + pos, std::min(count, internal_length - pos));
         return s;
     }
 
-    friend std::ostream &operator<<(std::ostream &os, const Slice &slice) {
+    // Bytes are printed as characters (or escaped), wider symbols as their numbers in angle brackets
+    friend std::ostream &operator<<(std::ostream &os, const BasicSlice &slice) {
         for (size_t i = 0; i < slice.internal_length; ++i) {
-            if (slice.internal_data[i] >= 32 && slice.internal_data[i] < 127) {
+            if constexpr (sizeof(Symbol) > 1) {
+                os << "<" << static_cast<uint64_t>(slice.internal_data[i]) << ">";
+            } else if (slice.internal_data[i] >= 32 && slice.internal_data[i] < 127) {
                 os << static_cast<char>(slice.internal_data[i]);
             } else {
                 os << "\\x" << std::setw(2) << std::setfill('0') << std::hex
@@ -93,6 +135,8 @@ public:
     }
 };
 
+using Slice = BasicSlice<uint8_t>;
+
 struct SliceHash {
     std::size_t operator()(const Slice &slice) const;
 };
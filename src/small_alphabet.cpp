@@ -0,0 +1,60 @@
+#include "small_alphabet.h"
+#include "lzdr_linear_time.h"
+#include "slice.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+std::optional<SmallAlphabet> SmallAlphabet::detect(const Slice input) {
+    std::array<bool, 256> occurs = {};
+    for (const uint8_t byte: input) {
+        occurs[byte] = true;
+    }
+    SmallAlphabet alphabet;
+    for (size_t byte = 0; byte < occurs.size(); ++byte) {
+        if (occurs[byte]) {
+            if (alphabet.rank_bytes.size() == MAX_SIZE) {
+                return std::nullopt;
+            }
+            alphabet.byte_ranks[byte] = static_cast<uint8_t>(alphabet.rank_bytes.size());
+            alphabet.rank_bytes.push_back(static_cast<uint8_t>(byte));
+        }
+    }
+    return alphabet;
+}
+
+unsigned SmallAlphabet::bits_per_symbol() const {
+    unsigned bits = MIN_BITS;
+    while ((size_t{1} << bits) < rank_bytes.size()) {
+        ++bits;
+    }
+    return bits;
+}
+
+void SmallAlphabet::restore_record_bytes(std::vector<uint8_t> &record) const {
+    const size_t uint_size = (record[0] & lzdr_compressor::WIDE_FORMAT_FLAG) != 0 ? 8 : 4;
+    // Byte operands take one byte, just as the ranks
+    switch (record[0] & ~lzdr_compressor::WIDE_FORMAT_FLAG) {
+        case 0:
+            record[1] = byte(record[1]);
+            record[2] = byte(record[2]);
+            break;
+        case 1:
+        case 6:
+            record[1] = byte(record[1]);
+            break;
+        case 2:
+            record[1 + uint_size] = byte(record[1 + uint_size]);
+            break;
+        case 3:
+        case 4:
+        case 5:
+            break;
+        default:
+            throw std::out_of_range("Unknown factor type");
+    }
+}
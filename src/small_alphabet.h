@@ -0,0 +1,71 @@
+#ifndef SMALL_ALPHABET_H
+#define SMALL_ALPHABET_H
+#include "slice.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Symbol of a small alphabet: the rank of a byte among the distinct bytes of the input (see SmallAlphabet).
+// A rank takes Bits bits, so the children of a trie node are marked in a bitmap of ALPHABET_CAPACITY bits
+// (see RankEdgeArray) instead of being kept in a hash map.
+template<unsigned Bits>
+struct RankSymbol {
+    static constexpr size_t ALPHABET_CAPACITY = size_t{1} << Bits;
+
+    uint8_t rank;
+
+    RankSymbol() = default;
+
+    template<typename Integer>
+    constexpr explicit RankSymbol(const Integer rank) : rank(static_cast<uint8_t>(rank)) {
+    }
+
+    constexpr operator uint8_t() const {
+        return rank;
+    }
+};
+
+// The distinct bytes of an input with at most MAX_SIZE of them (e.g. DNA or proteins), in ascending order.
+// Renaming the bytes to their ranks does not change the factorization, only the byte operands of the records
+class SmallAlphabet {
+    std::array<uint8_t, 256> byte_ranks = {};
+    std::vector<uint8_t> rank_bytes;
+
+public:
+    // Ranks of at most 5 bits fit into the 32-bit child bitmaps of RankEdgeArray
+    static constexpr size_t MAX_SIZE = 32;
+    static constexpr unsigned MIN_BITS = 2;
+
+    // Returns std::nullopt if the input has more than MAX_SIZE distinct bytes
+    static std::optional<SmallAlphabet> detect(Slice input);
+
+    [[nodiscard]] size_t size() const {
+        return rank_bytes.size();
+    }
+
+    // The bits per rank, at least MIN_BITS
+    [[nodiscard]] unsigned bits_per_symbol() const;
+
+    [[nodiscard]] uint8_t byte(const uint8_t rank) const {
+        return rank_bytes[rank];
+    }
+
+    // Requires every byte of the input to be in the alphabet
+    template<unsigned Bits>
+    std::vector<RankSymbol<Bits> > ranks(const Slice input) const {
+        std::vector<RankSymbol<Bits> > ranks(input.size());
+        for (size_t i = 0; i < input.size(); ++i) {
+            ranks[i].rank = byte_ranks[input[i]];
+        }
+        return ranks;
+    }
+
+    // Replaces the ranks of the byte operands of an LZDR record (of the ranks) by their bytes,
+    // which gives the record of the same factor of the byte input
+    void restore_record_bytes(std::vector<uint8_t> &record) const;
+};
+
+#endif //SMALL_ALPHABET_H
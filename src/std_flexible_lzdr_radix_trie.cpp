@@ -3,8 +3,11 @@
 #include "compressor.h"
 #include "slice.h"
 #include "radix_trie.h"
+#include "suffix_array.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
@@ -359,10 +362,104 @@ namespace std_flexible_lzdr_radix_trie_internal {
         // We do not handle empty removals.
         throw std::runtime_error("Empty removal unsupported");
     }
+
+    // The clock is only read every CHECK_INTERVAL factors
+    constexpr size_t CHECK_INTERVAL = 64;
+    // The number of candidates after the first reduction if all candidates are tested
+    constexpr size_t FIRST_REDUCED_CANDIDATES = 16;
+
+    CandidateBudget::CandidateBudget(const double time_budget_seconds, const size_t input_size, const size_t max_candidates)
+        : start(std::chrono::steady_clock::now()), time_budget_seconds(time_budget_seconds), input_size(input_size),
+          max_candidates(max_candidates), current_candidates(max_candidates), num_factors_since_check(0), exhausted(false) {
+    }
+
+    size_t CandidateBudget::candidates_at(const size_t i) {
+        if (time_budget_seconds <= 0 || exhausted || num_factors_since_check++ % CHECK_INTERVAL != 0) {
+            return current_candidates;
+        }
+
+        const double elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const double planned_seconds = time_budget_seconds * static_cast<double>(i) / static_cast<double>(input_size);
+        if (elapsed_seconds >= time_budget_seconds) {
+            exhausted = true;
+            current_candidates = 1;
+            greedy_position = i;
+        } else if (i > 0 && elapsed_seconds > planned_seconds) {
+            if (current_candidates == 0) {
+                current_candidates = FIRST_REDUCED_CANDIDATES;
+            } else {
+                current_candidates = std::max<size_t>(current_candidates / 2, 1);
+            }
+        } else if (elapsed_seconds < 0.8 * planned_seconds && current_candidates != max_candidates) {
+            current_candidates *= 2;
+            if (max_candidates == 0 ? current_candidates > FIRST_REDUCED_CANDIDATES : current_candidates >= max_candidates) {
+                current_candidates = max_candidates;
+            }
+        }
+        if (current_candidates != max_candidates && !first_reduction_position) {
+            first_reduction_position = i;
+        }
+        return current_candidates;
+    }
+
+    void CandidateBudget::print_stats(std::ostream &stats) const {
+        if (time_budget_seconds <= 0) {
+            return;
+        }
+        if (first_reduction_position) {
+            stats << "Time budget: fewer candidates from byte " << *first_reduction_position << std::endl;
+        } else {
+            stats << "Time budget: all candidates tested" << std::endl;
+        }
+        if (greedy_position) {
+            stats << "Time budget: greedy parsing from byte " << *greedy_position << std::endl;
+        }
+    }
+
+    CandidatePruning::CandidatePruning(const Slice input)
+        : max_end(input.size()), num_tested_candidates(0), num_pruned_candidates(0) {
+        const auto fill_max_end = [this](const auto &lpf) {
+            for (size_t p = 0; p < max_end.size(); ++p) {
+                max_end[p] = p + std::max<size_t>(1, lpf[p]);
+            }
+        };
+        if (input.size() <= static_cast<size_t>(INT32_MAX)) {
+            fill_max_end(longest_previous_factor_array<int32_t>(input));
+        } else {
+            fill_max_end(longest_previous_factor_array<int64_t>(input));
+        }
+    }
+
+    bool CandidatePruning::prune(const size_t i, const size_t l, const size_t best_total_length) {
+        ++num_tested_candidates;
+        const size_t next_start = i + l;
+        size_t next_factor_bound = 0;
+        if (next_start < max_end.size()) {
+            const size_t second_part_start = max_end[next_start];
+            next_factor_bound = second_part_start < max_end.size()
+                ? std::min(max_end.size(), max_end[second_part_start]) - next_start
+                : max_end.size() - next_start;
+        }
+        if (l + next_factor_bound > best_total_length) {
+            return false;
+        }
+        ++num_pruned_candidates;
+        return true;
+    }
+
+    void CandidatePruning::print_stats(std::ostream &stats) const {
+        stats << "Num pruned candidates: " << num_pruned_candidates << " of " << num_tested_candidates;
+        if (num_tested_candidates > 0) {
+            stats << " (" << static_cast<double>(num_pruned_candidates) / static_cast<double>(num_tested_candidates) << ")";
+        }
+        stats << std::endl;
+    }
 }
 
 // Returns the number of factors
-size_t std_flexible_lzdr_radix_trie(const Slice input, const bool check_decompressed_equals_input) {
+size_t std_flexible_lzdr_radix_trie(const Slice input, const bool check_decompressed_equals_input, const double time_budget_seconds) {
+    std_flexible_lzdr_radix_trie_internal::CandidateBudget budget(time_budget_seconds, input.size(), 0);
+    std_flexible_lzdr_radix_trie_internal::CandidatePruning pruning(input);
     // LZDR factors: pairs of factor end position and factor slice
     // The end position is inclusive, that means, if input[i] is the last character of the factor,
     // then `i` is the end position.
@@ -432,13 +529,22 @@ size_t std_flexible_lzdr_radix_trie(const Slice input, const bool check_decompre
             }
         }
 
-        // Go through all possible factors between length 1 and |normal_longest_factor|
         Slice normal_longest_factor = lzdr_linear_time_internal::next_longest_factor_counted_trie(
                 input, i, rest_input, rest_input.size(), previous_factors).factor_slice;
+
+        // Go through all possible factors between length 1 and |normal_longest_factor|
+        // (or only the longest ones if the time budget requires it)
+        const size_t num_candidates = budget.candidates_at(i);
+        const size_t min_candidate_length = num_candidates == 0 || num_candidates >= normal_longest_factor.size()
+            ? 1
+            : normal_longest_factor.size() - num_candidates + 1;
         size_t best_factor_length = 0;
         size_t best_total_length = 0;
         bool used_extra_truncation = false;
-        for (size_t l = normal_longest_factor.size(); l >= 1; --l) {
+        for (size_t l = normal_longest_factor.size(); l >= min_candidate_length; --l) {
+            if (pruning.prune(i, l, best_total_length)) {
+                continue;
+            }
             Slice truncated_rest_input = rest_input.slice(0, l);
 #ifndef NDEBUG
             std::cout << "  Testing factor: " << truncated_rest_input << std::endl;
@@ -477,7 +583,8 @@ size_t std_flexible_lzdr_radix_trie(const Slice input, const bool check_decompre
                 std::cout << "    -> No next factor" <<
                         " (total length: " << current_total_length << ")" << std::endl;
 #endif
-            } else {
+            } else if (min_candidate_length < normal_longest_factor.size()) {
+                // (The next factor does not matter if there is only one candidate)
                 Slice next_next_factor = lzdr_linear_time_internal::next_longest_factor_counted_trie(
                     input, i + next_factor.size(), next_rest_input, next_rest_input.size(), previous_factors).factor_slice;
                 current_total_length += next_next_factor.size();
@@ -512,7 +619,7 @@ size_t std_flexible_lzdr_radix_trie(const Slice input, const bool check_decompre
 #endif
 
         if (used_extra_truncation) {
-            if (const uint8_t factor_type = compressed_best_factor[0]; 0 <= factor_type && factor_type <= 3) {
+            if (const uint8_t factor_type = compressed_best_factor[0] & ~lzdr_compressor::WIDE_FORMAT_FLAG; 0 <= factor_type && factor_type <= 3) {
                 num_extra_truncations_combinations += 1;
             } else if (factor_type == 5 || factor_type == 6) {
                 num_extra_truncations_repetitions += 1;
@@ -539,6 +646,8 @@ size_t std_flexible_lzdr_radix_trie(const Slice input, const bool check_decompre
 
     std::cout << "Num extra truncations (combination): " << num_extra_truncations_combinations << std::endl;
     std::cout << "Num extra truncations (repetition): " << num_extra_truncations_repetitions << std::endl;
+    pruning.print_stats(std::cout);
+    budget.print_stats(std::cout);
 
     return factor_count;
 }
@@ -3,11 +3,73 @@
 #include "slice.h"
 #include "radix_trie.h"
 
+#include <chrono>
 #include <cstddef>
+#include <optional>
+#include <ostream>
+#include <vector>
 
-size_t std_flexible_lzdr_radix_trie(Slice input, bool check_decompressed_equals_input);
+// If time_budget_seconds is not 0, fewer candidate lengths are tested when the parsing falls behind the budget
+// (see std_flexible_lzdr_radix_trie_internal::CandidateBudget)
+size_t std_flexible_lzdr_radix_trie(Slice input, bool check_decompressed_equals_input, double time_budget_seconds = 0);
 
 namespace std_flexible_lzdr_radix_trie_internal {
+    // Time budget of a flexible parsing.
+    // The planned time for the first i bytes is the budget times i / |input|. The number of tested candidate lengths
+    // is halved while the parsing is behind this plan and doubled again while it is well ahead of it.
+    // Once the whole budget is used up, only the longest candidate is tested for the rest of the input (greedy parsing).
+    // The clock is read at the first factor and then only every 64 factors, since a candidate often takes less time
+    // than reading it, so the parsing can overrun the budget by the time of up to 64 factors.
+    class CandidateBudget {
+        std::chrono::steady_clock::time_point start;
+        double time_budget_seconds;
+        size_t input_size;
+        // 0 means all candidate lengths
+        size_t max_candidates;
+        size_t current_candidates;
+        size_t num_factors_since_check;
+        bool exhausted;
+        // Positions for the stats
+        std::optional<size_t> first_reduction_position;
+        std::optional<size_t> greedy_position;
+
+    public:
+        // A time budget of 0 disables the budget
+        CandidateBudget(double time_budget_seconds, size_t input_size, size_t max_candidates);
+
+        // Returns the number of candidate lengths to test for the factor starting at position i (0 means all)
+        size_t candidates_at(size_t i);
+
+        // The position from which on the parsing is greedy, if the budget is used up
+        [[nodiscard]] std::optional<size_t> greedy_start() const {
+            return greedy_position;
+        }
+
+        void print_stats(std::ostream &stats) const;
+    };
+
+    // Exact pruning of candidate lengths with an upper bound for the length of the factor after a candidate.
+    // A factor consists of at most two parts (first and second factor of a combination, base and rest of a repetition,
+    // or truncations of these), where each part is a single byte or a previous factor, so it occurs before its
+    // start position p and is at most max(1, lpf[p]) long (lpf is the longest previous factor array).
+    // Since p + max(1, lpf[p]) does not decrease with p, the factor at p ends before
+    // max_end[p + max(1, lpf[p])] with max_end[p] = p + max(1, lpf[p]).
+    // A candidate whose length plus this bound does not exceed the best total length so far cannot win,
+    // because candidates are tested from the longest to the shortest and ties keep the longer candidate.
+    class CandidatePruning {
+        std::vector<size_t> max_end;
+        size_t num_tested_candidates;
+        size_t num_pruned_candidates;
+
+    public:
+        explicit CandidatePruning(Slice input);
+
+        // Returns true if the candidate of length l for the factor at position i can be skipped
+        bool prune(size_t i, size_t l, size_t best_total_length);
+
+        void print_stats(std::ostream &stats) const;
+    };
+
     bool insert_into_radix_trie(CountedRadixTrie &trie, const Slice &insert);
 
     bool remove_from_radix_trie(CountedRadixTrie &trie, const Slice &remove);
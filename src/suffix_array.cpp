@@ -0,0 +1,313 @@
+#include "suffix_array.h"
+#include "slice.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace {
+    constexpr size_t LCP_BLOCK_BITS = 6;
+    constexpr size_t LCP_BLOCK_SIZE = static_cast<size_t>(1) << LCP_BLOCK_BITS;
+
+    size_t floor_log2(size_t value) {
+        size_t result = 0;
+        while (value >>= 1) {
+            ++result;
+        }
+        return result;
+    }
+
+    // Kasai et al., lcp[r] is the length of the longest common prefix of the suffixes with rank r - 1 and r
+    template<typename IndexT>
+    std::vector<IndexT> lcp_array(const uint8_t *data, const size_t n, const std::vector<IndexT> &sa, const std::vector<IndexT> &rank) {
+        std::vector<IndexT> lcp(n, 0);
+        size_t h = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const size_t r = rank[i];
+            if (r == 0) {
+                h = 0;
+                continue;
+            }
+            const size_t j = sa[r - 1];
+            while (i + h < n && j + h < n && data[i + h] == data[j + h]) {
+                ++h;
+            }
+            lcp[r] = static_cast<IndexT>(h);
+            if (h > 0) {
+                --h;
+            }
+        }
+        return lcp;
+    }
+
+    // SA-IS with an implicit sentinel at the end of the text.
+    // Follows the implementation of the AtCoder Library (https://github.com/atcoder/ac-library, CC0),
+    // but works on an arbitrary character type, so the input does not have to be copied on the top level.
+    template<typename IndexT, typename CharT>
+    std::vector<IndexT> sa_is(const CharT *s, const IndexT n, const IndexT upper) {
+        if (n == 0) {
+            return {};
+        }
+        if (n == 1) {
+            return {0};
+        }
+        if (n == 2) {
+            if (s[0] < s[1]) {
+                return {0, 1};
+            }
+            return {1, 0};
+        }
+
+        std::vector<IndexT> sa(n);
+        // true if the suffix is S-type, false if L-type
+        std::vector<bool> ls(n);
+        for (IndexT i = n - 2; i >= 0; --i) {
+            ls[i] = s[i] == s[i + 1] ? ls[i + 1] : s[i] < s[i + 1];
+        }
+        std::vector<IndexT> sum_l(upper + 1), sum_s(upper + 1);
+        for (IndexT i = 0; i < n; ++i) {
+            if (!ls[i]) {
+                sum_s[s[i]]++;
+            } else {
+                sum_l[s[i] + 1]++;
+            }
+        }
+        for (IndexT i = 0; i <= upper; ++i) {
+            sum_s[i] += sum_l[i];
+            if (i < upper) {
+                sum_l[i + 1] += sum_s[i];
+            }
+        }
+
+        std::vector<IndexT> buf(upper + 1);
+        const auto induce = [&](const std::vector<IndexT> &lms) {
+            std::fill(sa.begin(), sa.end(), -1);
+            std::copy(sum_s.begin(), sum_s.end(), buf.begin());
+            for (const IndexT d : lms) {
+                if (d == n) {
+                    continue;
+                }
+                sa[buf[s[d]]++] = d;
+            }
+            std::copy(sum_l.begin(), sum_l.end(), buf.begin());
+            sa[buf[s[n - 1]]++] = n - 1;
+            for (IndexT i = 0; i < n; ++i) {
+                if (const IndexT v = sa[i]; v >= 1 && !ls[v - 1]) {
+                    sa[buf[s[v - 1]]++] = v - 1;
+                }
+            }
+            std::copy(sum_l.begin(), sum_l.end(), buf.begin());
+            for (IndexT i = n - 1; i >= 0; --i) {
+                if (const IndexT v = sa[i]; v >= 1 && ls[v - 1]) {
+                    sa[--buf[s[v - 1] + 1]] = v - 1;
+                }
+            }
+        };
+
+        std::vector<IndexT> lms_map(n + 1, -1);
+        IndexT m = 0;
+        for (IndexT i = 1; i < n; ++i) {
+            if (!ls[i - 1] && ls[i]) {
+                lms_map[i] = m++;
+            }
+        }
+        std::vector<IndexT> lms;
+        lms.reserve(m);
+        for (IndexT i = 1; i < n; ++i) {
+            if (!ls[i - 1] && ls[i]) {
+                lms.push_back(i);
+            }
+        }
+
+        induce(lms);
+
+        if (m) {
+            std::vector<IndexT> sorted_lms;
+            sorted_lms.reserve(m);
+            for (const IndexT v : sa) {
+                if (lms_map[v] != -1) {
+                    sorted_lms.push_back(v);
+                }
+            }
+            // Name the LMS substrings and sort them recursively
+            std::vector<IndexT> rec_s(m);
+            IndexT rec_upper = 0;
+            rec_s[lms_map[sorted_lms[0]]] = 0;
+            for (IndexT i = 1; i < m; ++i) {
+                IndexT l = sorted_lms[i - 1], r = sorted_lms[i];
+                const IndexT end_l = lms_map[l] + 1 < m ? lms[lms_map[l] + 1] : n;
+                const IndexT end_r = lms_map[r] + 1 < m ? lms[lms_map[r] + 1] : n;
+                bool same = true;
+                if (end_l - l != end_r - r) {
+                    same = false;
+                } else {
+                    while (l < end_l) {
+                        if (s[l] != s[r]) {
+                            break;
+                        }
+                        ++l;
+                        ++r;
+                    }
+                    if (l == n || s[l] != s[r]) {
+                        same = false;
+                    }
+                }
+                if (!same) {
+                    ++rec_upper;
+                }
+                rec_s[lms_map[sorted_lms[i]]] = rec_upper;
+            }
+
+            const std::vector<IndexT> rec_sa = sa_is<IndexT, IndexT>(rec_s.data(), m, rec_upper);
+
+            for (IndexT i = 0; i < m; ++i) {
+                sorted_lms[i] = lms[rec_sa[i]];
+            }
+            induce(sorted_lms);
+        }
+        return sa;
+    }
+}
+
+template<typename IndexT>
+std::vector<IndexT> build_suffix_array(const Slice input) {
+    return sa_is<IndexT, uint8_t>(input.data(), static_cast<IndexT>(input.size()), 255);
+}
+
+template<typename IndexT>
+SuffixArrayLce<IndexT>::SuffixArrayLce(const Slice input) : input(input) {
+    const size_t n = input.size();
+
+    // Make sure the suffix array gets deallocated at end of block
+    {
+        const std::vector<IndexT> sa = build_suffix_array<IndexT>(input);
+        rank.resize(n);
+        for (size_t r = 0; r < n; ++r) {
+            rank[sa[r]] = static_cast<IndexT>(r);
+        }
+
+        lcp = lcp_array(input.data(), n, sa, rank);
+    }
+
+    // Sparse table over block minima
+    const size_t num_blocks = (n + LCP_BLOCK_SIZE - 1) / LCP_BLOCK_SIZE;
+    if (num_blocks > 0) {
+        std::vector<IndexT> level(num_blocks);
+        for (size_t b = 0; b < num_blocks; ++b) {
+            const size_t from = b * LCP_BLOCK_SIZE;
+            const size_t to = std::min(n, from + LCP_BLOCK_SIZE);
+            level[b] = *std::min_element(lcp.begin() + from, lcp.begin() + to);
+        }
+        block_minima.push_back(std::move(level));
+        for (size_t k = 1; (static_cast<size_t>(1) << k) <= num_blocks; ++k) {
+            const std::vector<IndexT> &previous = block_minima[k - 1];
+            const size_t half = static_cast<size_t>(1) << (k - 1);
+            std::vector<IndexT> next(num_blocks - (static_cast<size_t>(1) << k) + 1);
+            for (size_t b = 0; b < next.size(); ++b) {
+                next[b] = std::min(previous[b], previous[b + half]);
+            }
+            block_minima.push_back(std::move(next));
+        }
+    }
+}
+
+template<typename IndexT>
+IndexT SuffixArrayLce<IndexT>::min_lcp(const size_t from, const size_t to) const {
+    const size_t from_block = from >> LCP_BLOCK_BITS;
+    const size_t to_block = to >> LCP_BLOCK_BITS;
+    if (from_block == to_block) {
+        return *std::min_element(lcp.begin() + from, lcp.begin() + to + 1);
+    }
+
+    IndexT result = std::min(
+        *std::min_element(lcp.begin() + from, lcp.begin() + (from_block + 1) * LCP_BLOCK_SIZE),
+        *std::min_element(lcp.begin() + to_block * LCP_BLOCK_SIZE, lcp.begin() + to + 1));
+    if (from_block + 1 < to_block) {
+        const size_t k = floor_log2(to_block - from_block - 1);
+        result = std::min({
+            result, block_minima[k][from_block + 1], block_minima[k][to_block - (static_cast<size_t>(1) << k)]
+        });
+    }
+    return result;
+}
+
+template<typename IndexT>
+size_t SuffixArrayLce<IndexT>::lce(const size_t start1, const size_t start2) const {
+    const size_t n = input.size();
+    if (start1 >= n || start2 >= n) {
+        return 0;
+    }
+    if (start1 == start2) {
+        return n - start1;
+    }
+
+    // Most extensions are short, so compare a few bytes directly before querying the LCP array
+    const uint8_t *data = input.data();
+    const size_t direct_limit = std::min<size_t>(8, n - std::max(start1, start2));
+    size_t direct = 0;
+    while (direct < direct_limit && data[start1 + direct] == data[start2 + direct]) {
+        ++direct;
+    }
+    if (direct < 8) {
+        return direct;
+    }
+
+    const size_t rank1 = rank[start1];
+    const size_t rank2 = rank[start2];
+    return min_lcp(std::min(rank1, rank2) + 1, std::max(rank1, rank2));
+}
+
+template<typename IndexT>
+std::vector<IndexT> longest_previous_factor_array(const Slice input) {
+    const size_t n = input.size();
+    const std::vector<IndexT> sa = build_suffix_array<IndexT>(input);
+    std::vector<IndexT> lcp;
+    // Make sure the rank array gets deallocated at end of block
+    {
+        std::vector<IndexT> rank(n);
+        for (size_t r = 0; r < n; ++r) {
+            rank[sa[r]] = static_cast<IndexT>(r);
+        }
+        lcp = lcp_array(input.data(), n, sa, rank);
+    }
+
+    // The longest previous factor of a suffix is shared with the nearest suffix in suffix array order
+    // that starts before it, on either side. Both are found with a stack of suffixes with increasing positions,
+    // where each entry holds the minimum of the LCP array between it and the entry above it (or the current rank).
+    std::vector<IndexT> lpf(n, 0);
+    std::vector<std::pair<IndexT, IndexT> > stack;
+    const auto visit = [&](const size_t r, const IndexT lcp_to_previous) {
+        if (!stack.empty()) {
+            stack.back().second = std::min(stack.back().second, lcp_to_previous);
+        }
+        while (!stack.empty() && stack.back().first > sa[r]) {
+            const IndexT popped_lcp = stack.back().second;
+            stack.pop_back();
+            if (!stack.empty()) {
+                stack.back().second = std::min(stack.back().second, popped_lcp);
+            }
+        }
+        if (!stack.empty()) {
+            lpf[sa[r]] = std::max(lpf[sa[r]], stack.back().second);
+        }
+        stack.emplace_back(sa[r], std::numeric_limits<IndexT>::max());
+    };
+    for (size_t r = 0; r < n; ++r) {
+        visit(r, r > 0 ? lcp[r] : 0);
+    }
+    stack.clear();
+    for (size_t r = n; r-- > 0;) {
+        visit(r, r + 1 < n ? lcp[r + 1] : 0);
+    }
+    return lpf;
+}
+
+template std::vector<int32_t> build_suffix_array<int32_t>(Slice input);
+template std::vector<int64_t> build_suffix_array<int64_t>(Slice input);
+template std::vector<int32_t> longest_previous_factor_array<int32_t>(Slice input);
+template std::vector<int64_t> longest_previous_factor_array<int64_t>(Slice input);
+template class SuffixArrayLce<int32_t>;
+template class SuffixArrayLce<int64_t>;
@@ -0,0 +1,41 @@
+#ifndef SUFFIX_ARRAY_H
+#define SUFFIX_ARRAY_H
+#include "slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Computes the suffix array of the input in linear time (SA-IS).
+// IndexT has to be a signed integer type that can hold the input length.
+template<typename IndexT>
+std::vector<IndexT> build_suffix_array(Slice input);
+
+// Computes the longest previous factor (LPF) array of the input in linear time:
+// lpf[i] is the length of the longest prefix of the suffix at i that also starts at some position before i.
+template<typename IndexT>
+std::vector<IndexT> longest_previous_factor_array(Slice input);
+
+// Answers longest common extension (LCE) queries on the input.
+// Uses the inverse suffix array, the LCP array and a range minimum structure over the LCP array,
+// where the range minimum structure is a sparse table over the minima of fixed-size blocks.
+template<typename IndexT>
+class SuffixArrayLce {
+    Slice input;
+    std::vector<IndexT> rank;
+    // lcp[r] is the length of the longest common prefix of the suffixes with rank r - 1 and r
+    std::vector<IndexT> lcp;
+    // block_minima[k][b] is the minimum of the LCP array in the blocks [b, b + 2^k)
+    std::vector<std::vector<IndexT> > block_minima;
+
+    // Minimum of the LCP array in [from, to]
+    [[nodiscard]] IndexT min_lcp(size_t from, size_t to) const;
+
+public:
+    explicit SuffixArrayLce(Slice input);
+
+    // Returns the length of the longest common prefix of the suffixes starting at start1 and start2
+    [[nodiscard]] size_t lce(size_t start1, size_t start2) const;
+};
+
+#endif //SUFFIX_ARRAY_H
@@ -1,20 +1,48 @@
 #include "test.h"
+#include "algorithm_selection.h"
+#include "compression_level.h"
+#include "compressor.h"
+#include "estimator.h"
+#include "factor_stream.h"
+#include "flat_radix_trie.h"
 #include "flexible_lzw_naive.h"
 #include "lzdr_linear_time.h"
 #include "std_flexible_lzw_naive.h"
 #include "std_flexible_lzdr_radix_trie.h"
 #include "flexible_lzdr_radix_trie.h"
 #include "flexible_lzdr_max_radix_trie.h"
+#include "io_pipeline.h"
 #include "lzd_plus_linear_time.h"
 #include "lzd_radix_tree.h"
+#include "lzw.h"
+#include "lzdr_checkpoint.h"
+#include "lzdr_dictionary.h"
+#include "lzdr_parallel_blocks.h"
+#include "lzdr_pattern_search.h"
+#include "lzdr_random_access.h"
+#include "lzdr_verifier.h"
+#include "mismatch.h"
 #include "radix_trie.h"
 #include "slice.h"
+#include "small_alphabet.h"
+#include "suffix_array.h"
+#include "work_stealing_pool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 void run_tests() {
 #ifdef NDEBUG
@@ -226,6 +254,641 @@ void run_tests() {
 
     std::cout << std::endl;
 
+    // LZDR wide format test: records in the narrow and the wide format can be mixed
+    // (1)ab (2)ababab (3)aba (4)ababa (5)ccc
+    assert(!requires_wide_format(UINT32_MAX));
+    assert(requires_wide_format(static_cast<uint64_t>(UINT32_MAX) + 1));
+    uint8_t u64_bytes[8];
+    u64_to_bytes(0x0123456789ABCDEF, u64_bytes);
+    assert(u64_from_bytes(u64_bytes) == 0x0123456789ABCDEF);
+    std::vector<uint8_t> mixed_format_data;
+    const auto append_record = [&mixed_format_data](Compressor compressor) {
+        const std::vector<uint8_t> record = compressor.data();
+        mixed_format_data.insert(mixed_format_data.end(), record.begin(), record.end());
+    };
+    Compressor wide_record_1 = lzdr_compressor::create_compressor_for_combination(true, true, false);
+    wide_record_1.write_byte('a');
+    wide_record_1.write_byte('b');
+    wide_record_1.write_uint(2, false);
+    append_record(std::move(wide_record_1));
+    Compressor wide_record_2 = lzdr_compressor::create_compressor_for_repetition(false, true);
+    wide_record_2.write_uint(1, true);
+    wide_record_2.write_uint(6, true);
+    append_record(std::move(wide_record_2));
+    Compressor wide_record_3 = lzdr_compressor::create_compressor_for_truncation(true);
+    wide_record_3.write_uint(2, true);
+    wide_record_3.write_uint(3, true);
+    append_record(std::move(wide_record_3));
+    Compressor wide_record_4 = lzdr_compressor::create_compressor_for_combination(false, false, true);
+    wide_record_4.write_uint(1, true);
+    wide_record_4.write_uint(3, true);
+    wide_record_4.write_uint(5, true);
+    append_record(std::move(wide_record_4));
+    Compressor wide_record_5 = lzdr_compressor::create_compressor_for_repetition(true, true);
+    wide_record_5.write_byte('c');
+    wide_record_5.write_uint(3, true);
+    append_record(std::move(wide_record_5));
+    const std::vector<uint8_t> mixed_format_decompressed = lzdr_decompress(mixed_format_data);
+    std::cout << "LZDR wide format: " << Slice(mixed_format_decompressed) << std::endl;
+    assert(Slice(mixed_format_decompressed) == Slice("abababababaababaccc"));
+    const LzdrRandomAccess mixed_format_random_access{Slice(mixed_format_data)};
+    assert(mixed_format_random_access.num_factors() == 5);
+    assert(Slice(mixed_format_random_access.extract(3, 12)) == Slice("babababaa"));
+
+    std::cout << std::endl;
+
+    // Random access on LZDR and LZD+ compressed data has to match the input for all ranges
+    for (const Slice &input: {Slice(input_1), Slice(input_3), Slice(input_7), Slice(input_9), Slice(input_11)}) {
+        std::vector<uint8_t> lzdr_compressed;
+        lzdr_linear_time(input, false, &lzdr_compressed);
+        std::vector<uint8_t> lzd_plus_compressed;
+        lzd_plus_linear_time(input, false, &lzd_plus_compressed);
+        for (const std::vector<uint8_t> &compressed: {lzdr_compressed, lzd_plus_compressed}) {
+            const LzdrRandomAccess random_access{Slice(compressed)};
+            assert(random_access.size() == input.size());
+            for (size_t from = 0; from <= input.size(); ++from) {
+                for (size_t to = from; to <= input.size(); ++to) {
+                    assert(Slice(random_access.extract(from, to)) == input.slice(from, to - from));
+                }
+            }
+
+            // Pattern search has to find the same occurrences as a naive search for all short substrings
+            for (size_t pattern_len = 1; pattern_len <= 5; ++pattern_len) {
+                for (size_t pattern_start = 0; pattern_start + pattern_len <= input.size(); ++pattern_start) {
+                    const Slice pattern = input.slice(pattern_start, pattern_len);
+                    std::vector<uint64_t> expected;
+                    for (size_t start = 0; start + pattern_len <= input.size(); ++start) {
+                        if (input.slice(start, pattern_len) == pattern) {
+                            expected.push_back(start);
+                        }
+                    }
+                    const LzdrPatternSearch search(random_access, pattern);
+                    assert(search.find_all() == expected);
+                    assert(search.count() == expected.size());
+                }
+            }
+            assert(LzdrPatternSearch(random_access, Slice("xyz")).count() == 0);
+        }
+    }
+
+    std::cout << std::endl;
+
+    // Suffix array and LCE queries
+    assert((build_suffix_array<int32_t>(Slice("banana")) == std::vector<int32_t>{5, 3, 1, 0, 4, 2}));
+    const SuffixArrayLce<int32_t> lce_1{Slice(input_1)};
+    for (size_t i = 0; i < Slice(input_1).size(); ++i) {
+        for (size_t j = 0; j < Slice(input_1).size(); ++j) {
+            size_t naive = 0;
+            while (std::max(i, j) + naive < Slice(input_1).size() && input_1[i + naive] == input_1[j + naive]) {
+                ++naive;
+            }
+            assert(lce_1.lce(i, j) == naive);
+        }
+    }
+    assert((longest_previous_factor_array<int32_t>(Slice("abaababa")) == std::vector<int32_t>{0, 0, 1, 3, 2, 3, 2, 1}));
+    for (const Slice &input: {Slice(input_1), Slice(input_3), Slice(input_8), Slice(input_12)}) {
+        const std::vector<int64_t> lpf = longest_previous_factor_array<int64_t>(input);
+        for (size_t i = 0; i < input.size(); ++i) {
+            size_t naive = 0;
+            for (size_t j = 0; j < i; ++j) {
+                size_t common = 0;
+                while (i + common < input.size() && input[j + common] == input[i + common]) {
+                    ++common;
+                }
+                naive = std::max(naive, common);
+            }
+            assert(static_cast<size_t>(lpf[i]) == naive);
+        }
+    }
+
+    // LZDR (suffix array) has to compute the same factorization and compressed data as LZDR (radix trie)
+    for (const Slice &input: {Slice(input_1), Slice(input_3), Slice(input_4), Slice(input_5), Slice(input_6), Slice(input_7), Slice(input_8), Slice(input_8_2), Slice(input_9), Slice(input_10), Slice(input_11), Slice(input_12)}) {
+        std::cout << "LZDR (suffix array)" << std::endl;
+        std::vector<uint8_t> suffix_array_compressed;
+        const size_t lzdr_suffix_array_num_factors = lzdr_suffix_array(input, true, &suffix_array_compressed);
+        std::cout << "Num factors: " << lzdr_suffix_array_num_factors << std::endl;
+        std::vector<uint8_t> trie_compressed;
+        assert(lzdr_suffix_array_num_factors == lzdr_linear_time(input, false, &trie_compressed));
+        assert(suffix_array_compressed == trie_compressed);
+    }
+
+    std::cout << std::endl;
+
+    // Compression levels
+    for (const Slice &input: {Slice(input_1), Slice(input_3), Slice(input_8), Slice(input_10), Slice(input_12)}) {
+        for (int level = MIN_COMPRESSION_LEVEL; level <= MAX_COMPRESSION_LEVEL; ++level) {
+            std::vector<uint8_t> compressed;
+            compress_with_level(level, input, true, &compressed);
+            assert(Slice(lzdr_decompress(compressed)) == input);
+        }
+        // Testing only the longest candidate is the greedy factorization
+        assert(flexible_lzdr_radix_trie(input, true, nullptr, 1) == lzdr_linear_time(input, false));
+    }
+    // A used up time budget falls back to greedy parsing, which is LZDR (the budget is already checked at the first factor)
+    std_flexible_lzdr_radix_trie_internal::CandidateBudget used_up_budget(1e-9, 100, 0);
+    assert(used_up_budget.candidates_at(0) == 1 && used_up_budget.greedy_start() == size_t{0});
+    std::string budget_input;
+    uint32_t budget_seed = 1;
+    for (size_t i = 0; i < 4000; ++i) {
+        budget_seed = budget_seed * 1103515245 + 12345;
+        budget_input.push_back(static_cast<char>('a' + (budget_seed >> 16) % 3));
+    }
+    std::vector<uint8_t> greedy_compressed;
+    [[maybe_unused]] const size_t greedy_num_factors = lzdr_linear_time(Slice(budget_input), false, &greedy_compressed);
+    assert(flexible_lzdr_radix_trie(Slice(budget_input), false) < greedy_num_factors);
+    std::vector<uint8_t> budget_compressed;
+    assert(flexible_lzdr_radix_trie(Slice(budget_input), true, &budget_compressed, 0, 1e-9) == greedy_num_factors);
+    assert(budget_compressed == greedy_compressed);
+    assert(std_flexible_lzdr_radix_trie(Slice(budget_input), false) < greedy_num_factors);
+    assert(std_flexible_lzdr_radix_trie(Slice(budget_input), true, 1e-9) == greedy_num_factors);
+
+    std::cout << std::endl;
+
+    // Estimates from samples: exact if the samples and prefixes are at least as many bytes as the input,
+    // otherwise bounded around the mean
+    [[maybe_unused]] const FactorEstimate exact_estimate = estimate_factors(Slice(budget_input), 2, 4, budget_input.size(), 0, 2);
+    assert(exact_estimate.num_samples == 0);
+    assert(static_cast<size_t>(std::lround(exact_estimate.factors())) == lzdr_linear_time(Slice(budget_input), false));
+    [[maybe_unused]] const FactorEstimate prefixes_exact_estimate = estimate_factors(Slice(budget_input), 2, 34, 100, 400, 2);
+    assert(prefixes_exact_estimate.num_samples == 0);
+    [[maybe_unused]] const FactorEstimate sampled_estimate = estimate_factors(Slice(budget_input), 1, 4, 64, 512, 2);
+    assert(sampled_estimate.num_samples == 4 && sampled_estimate.growth_exponent < 1);
+    assert(sampled_estimate.factors_low() <= sampled_estimate.factors() && sampled_estimate.factors() <= sampled_estimate.factors_high());
+    assert(sampled_estimate.compressed_size() > 0);
+
+    // Input profiles: runs of equal bytes are repetitions, so they choose LZDR, the budget input has hardly any
+    std::string runs_input;
+    for (size_t i = 0; i < 200; ++i) {
+        runs_input.append(1 + i % 37, static_cast<char>('a' + i % 5));
+    }
+    const InputProfile runs_profile = profile_input(Slice(runs_input), runs_input.size());
+    assert(runs_profile.sample_size == runs_input.size() && runs_profile.mean_run_length > LONG_RUN_LENGTH);
+    assert(std::abs(runs_profile.byte_entropy - std::log2(5.0)) < 0.01 && runs_profile.repetition_ratio > 0.01);
+    assert(choose_algorithm(runs_profile, runs_input.size(), 0, 1).level == 2);
+    const InputProfile budget_profile = profile_input(Slice(budget_input), 1000);
+    assert(budget_profile.sample_size == 1000 && budget_profile.long_run_ratio < 0.05);
+    if (budget_profile.repetition_ratio < 0.005) {
+        assert(choose_algorithm(budget_profile, budget_input.size(), 0, 1).level == 1);
+    }
+    // An unreachable throughput target splits a large input into one block per thread, a low one allows Flexible LZDR
+    const AlgorithmChoice blocks_choice = choose_algorithm(runs_profile, 8 * 1024 * 1024, runs_profile.lzdr_throughput * 100, 4);
+    assert(blocks_choice.block_size == 2 * 1024 * 1024 && !blocks_choice.reasons.empty());
+    assert(choose_algorithm(runs_profile, runs_input.size(), runs_profile.lzdr_throughput / 100, 1).level > 2);
+    // The levels get slower from level to level, so a target of the expected throughput of a level chooses that level
+    for (int level = MIN_COMPRESSION_LEVEL + 1; level <= MAX_COMPRESSION_LEVEL; ++level) {
+        assert(compression_level(level).throughput_target < compression_level(level - 1).throughput_target);
+    }
+    [[maybe_unused]] const double level_7_throughput =
+            runs_profile.lzdr_throughput * compression_level(7).throughput_target / compression_level(2).throughput_target;
+    assert(choose_algorithm(runs_profile, runs_input.size(), level_7_throughput, 1).level == 7);
+    // LZD+ for few repetitions is upgraded as well, but not for a hardly compressible input
+    [[maybe_unused]] InputProfile few_repetitions_profile = {1000, 4.0, 1.1, 0.0, 500, 0.0, 1.0};
+    assert(choose_algorithm(few_repetitions_profile, 1000, 0, 1).level == 1);
+    [[maybe_unused]] const double level_5_throughput = compression_level(5).throughput_target / compression_level(2).throughput_target;
+    assert(choose_algorithm(few_repetitions_profile, 1000, level_5_throughput, 1).level == 5);
+    few_repetitions_profile.byte_entropy = 8.0;
+    assert(choose_algorithm(few_repetitions_profile, 1000, level_5_throughput, 1).level == 1);
+
+    // Pipelined I/O: reading the input in tiny blocks results in the same compressed output as the whole input
+    for (const Slice &input: {Slice(input_1), Slice(input_3), Slice(input_8), Slice(input_12), Slice(budget_input), Slice(runs_input)}) {
+        std::FILE *input_file = std::tmpfile();
+        std::FILE *output_file = std::tmpfile();
+        assert(input_file != nullptr && output_file != nullptr);
+        std::fwrite(input.data(), 1, input.size(), input_file);
+        std::rewind(input_file);
+        [[maybe_unused]] size_t pipelined_num_factors;
+        {
+            PipelinedInput pipelined_input(fileno(input_file), input.size(), 3);
+            PipelinedOutput pipelined_output(fileno(output_file), 5);
+            pipelined_num_factors = lzdr_linear_time_pipelined(pipelined_input, true, &pipelined_output);
+            pipelined_output.finish();
+        }
+        std::vector<uint8_t> expected_compressed;
+        assert(pipelined_num_factors == lzdr_linear_time(input, false, &expected_compressed));
+        std::vector<uint8_t> pipelined_compressed(expected_compressed.size() + 1);
+        std::rewind(output_file);
+        assert(std::fread(pipelined_compressed.data(), 1, pipelined_compressed.size(), output_file) == expected_compressed.size());
+        pipelined_compressed.pop_back();
+        assert(pipelined_compressed == expected_compressed);
+        std::fclose(input_file);
+        std::fclose(output_file);
+    }
+
+    // Concurrent verification: reports the index of the first factor that does not decompress to the input
+    {
+        std::vector<uint8_t> verified_compressed;
+        lzdr_linear_time(Slice(budget_input), false, &verified_compressed);
+        std::vector<std::vector<uint8_t> > records;
+        for (size_t i = 0; i < verified_compressed.size(); i += records.back().size()) {
+            const size_t record_size = lzdr_compressor::record_size(verified_compressed[i]);
+            records.emplace_back(verified_compressed.begin() + static_cast<std::ptrdiff_t>(i),
+                                 verified_compressed.begin() + static_cast<std::ptrdiff_t>(i + record_size));
+        }
+        ConcurrentLzdrVerifier verifier{Slice(budget_input)};
+        for (const std::vector<uint8_t> &record: records) {
+            verifier.add(record);
+        }
+        verifier.finish();
+
+        // The last byte of a record is part of its length
+        records[records.size() / 2].back() += 1;
+        std::string verifier_error;
+        try {
+            ConcurrentLzdrVerifier corrupted_verifier{Slice(budget_input)};
+            for (const std::vector<uint8_t> &record: records) {
+                corrupted_verifier.add(record);
+            }
+            corrupted_verifier.finish();
+        } catch (const std::out_of_range &error) {
+            verifier_error = error.what();
+        }
+        assert(verifier_error.rfind("Factor " + std::to_string(records.size() / 2 + 1) + " ", 0) == 0);
+
+        [[maybe_unused]] bool verifier_threw = false;
+        try {
+            ConcurrentLzdrVerifier short_verifier{Slice(budget_input)};
+            short_verifier.add(records[0]);
+            short_verifier.finish();
+        } catch (const std::out_of_range &) {
+            verifier_threw = true;
+        }
+        assert(verifier_threw);
+
+        // finish after a thrown add or finish rethrows the mismatch instead of joining the verifier thread again
+        ConcurrentLzdrVerifier failed_verifier{Slice(budget_input)};
+        [[maybe_unused]] size_t num_verifier_throws = 0;
+        try {
+            for (const std::vector<uint8_t> &record: records) {
+                failed_verifier.add(record);
+            }
+            failed_verifier.finish();
+        } catch (const std::out_of_range &) {
+            num_verifier_throws += 1;
+        }
+        try {
+            failed_verifier.finish();
+        } catch (const std::out_of_range &) {
+            num_verifier_throws += 1;
+        }
+        assert(num_verifier_throws == 2);
+    }
+
+    // Factor streams: the factors cover the input, their records are the compressed data and their first operands
+    // start like them (truncations and extra truncations may shorten the first operand)
+    for (const Slice &input: {Slice(input_1), Slice(input_3), Slice(input_8), Slice(input_12), Slice(budget_input), Slice(runs_input)}) {
+        std::vector<uint8_t> expected_compressed;
+        [[maybe_unused]] const size_t expected_num_factors = lzdr_linear_time(input, false, &expected_compressed);
+        LzdrFactorStream factors(input);
+        std::vector<Slice> texts = {Slice(nullptr, 0)};
+        std::vector<uint8_t> compressed;
+        while (const StreamedFactor *factor = factors.next()) {
+            assert(factor->index == texts.size() && factor->position + factor->length() <= input.size());
+            assert(factor->text == input.slice(factor->position, factor->length()));
+            const Slice first = factor->first_is_byte() ? factor->text.slice(0, 1) : texts[factor->first()];
+            assert(factor->first_is_byte() ? factor->first() == factor->text[0] : factor->first() < factor->index);
+            [[maybe_unused]] const size_t common_length = std::min(first.size(), factor->length());
+            assert(first.slice(0, common_length) == factor->text.slice(0, common_length));
+            if (factor->type() == FactorType::COMBINATION && factor->second_is_byte()) {
+                assert(factor->second() < 256);
+            } else if (factor->type() == FactorType::COMBINATION) {
+                assert(factor->second() < factor->index);
+            }
+            texts.push_back(factor->text);
+            compressed.insert(compressed.end(), factor->record.begin(), factor->record.end());
+        }
+        assert(texts.size() == expected_num_factors + 1 && compressed == expected_compressed);
+
+        expected_compressed.clear();
+        const size_t expected_num_lzd_plus_factors = lzd_plus_linear_time(input, false, &expected_compressed);
+        LzdPlusFactorStream lzd_plus_factors(input);
+        compressed.clear();
+        size_t position = 0;
+        while (const StreamedFactor *factor = lzd_plus_factors.next()) {
+            assert(factor->position == position && factor->type() != FactorType::REPETITION);
+            position += factor->length();
+            compressed.insert(compressed.end(), factor->record.begin(), factor->record.end());
+            if (factor->index == expected_num_lzd_plus_factors) {
+                assert(position == input.size());
+            }
+        }
+        assert(lzd_plus_factors.next() == nullptr && compressed == expected_compressed);
+    }
+
+    // Wide symbols: renaming the bytes to 16-bit or 32-bit symbols results in the same factorizations,
+    // which decompress to the symbols (the records only differ in the width of the symbol operands)
+    for (const Slice &input: {Slice(input_1), Slice(input_3), Slice(input_8), Slice(input_12), Slice(budget_input), Slice(runs_input)}) {
+        std::vector<uint16_t> symbols_16;
+        std::vector<uint32_t> symbols_32;
+        for (const uint8_t byte: input) {
+            symbols_16.push_back(static_cast<uint16_t>(0x1234 + byte * 0x101));
+            symbols_32.push_back(0x12345678u + byte * 0x1010101u);
+        }
+        [[maybe_unused]] const size_t num_lzdr_factors = lzdr_linear_time(input, false);
+        std::vector<uint8_t> compressed_16;
+        assert(lzdr_linear_time(BasicSlice<uint16_t>(symbols_16), true, &compressed_16) == num_lzdr_factors);
+        assert(lzdr_decompress_symbols<uint16_t>(compressed_16) == symbols_16);
+        std::vector<uint8_t> compressed_32;
+        assert(lzdr_linear_time(BasicSlice<uint32_t>(symbols_32), true, &compressed_32) == num_lzdr_factors);
+        assert(lzdr_decompress_symbols<uint32_t>(compressed_32) == symbols_32);
+        // The symbol width is stored, decompressing with another width throws
+        assert(is_lzdr_symbols(compressed_16) && lzdr_symbol_width(compressed_16) == 2 && lzdr_symbol_width(compressed_32) == 4);
+        [[maybe_unused]] bool wrong_width_threw = false;
+        try {
+            lzdr_decompress_symbols<uint32_t>(compressed_16);
+        } catch (const std::runtime_error &) {
+            wrong_width_threw = true;
+        }
+        assert(wrong_width_threw);
+
+        [[maybe_unused]] const size_t num_lzd_plus_factors = lzd_plus_linear_time(input, false);
+        compressed_16.clear();
+        assert(lzd_plus_linear_time(BasicSlice<uint16_t>(symbols_16), true, &compressed_16) == num_lzd_plus_factors);
+        assert(lzdr_decompress_symbols<uint16_t>(compressed_16) == symbols_16);
+        assert(lzd_plus_linear_time(BasicSlice<uint32_t>(symbols_32), true) == num_lzd_plus_factors);
+
+        BasicLzdrFactorStream<uint16_t> symbol_factors{BasicSlice<uint16_t>(symbols_16)};
+        while ([[maybe_unused]] const BasicStreamedFactor<uint16_t> *factor = symbol_factors.next()) {
+            assert(!factor->first_is_byte() || factor->first() == factor->text[0]);
+        }
+    }
+
+    // Small alphabets: factorizing the ranks of the bytes gives the same compressed data as factorizing the bytes,
+    // for every number of bits per rank, and inputs with too many distinct bytes are factorized as bytes
+    std::string protein_input;
+    for (size_t i = 0; i < 600; ++i) {
+        protein_input.push_back(static_cast<char>('A' + (i * i / 7 + i / 50) % 25));
+    }
+    std::string bytes_input;
+    for (size_t i = 0; i < 300; ++i) {
+        bytes_input.push_back(static_cast<char>(i * 37 % 251));
+    }
+    assert(SmallAlphabet::detect(Slice("GATTACA"))->size() == 4 && SmallAlphabet::detect(Slice("GATTACA"))->bits_per_symbol() == 2);
+    assert(SmallAlphabet::detect(Slice("GATTACAN"))->bits_per_symbol() == 3 && SmallAlphabet::detect(Slice("GATTACAN"))->byte(2) == 'G');
+    assert(SmallAlphabet::detect(Slice(protein_input))->bits_per_symbol() == 5);
+    assert(!SmallAlphabet::detect(Slice(bytes_input)));
+    for (const Slice &input: {Slice(input_1), Slice(input_3), Slice(input_8), Slice(input_12), Slice(budget_input), Slice(runs_input),
+                              Slice("GATTACAGATTACAGATTTTTTTTACAGAT"), Slice("ACGTTGCAACGTNNNNNNNNACGTACGTTGCAACGAACGTT"),
+                              Slice(protein_input), Slice(bytes_input)}) {
+        std::vector<uint8_t> expected_compressed;
+        [[maybe_unused]] const size_t expected_num_factors = lzdr_linear_time(input, false, &expected_compressed);
+        std::vector<uint8_t> compressed;
+        assert(lzdr_linear_time_small_alphabet(input, true, &compressed) == expected_num_factors);
+        assert(compressed == expected_compressed);
+    }
+
+    // LZW: the compressed data decompresses to the input for every code width, also with dictionary resets,
+    // and decoding it byte by byte gives the same bytes
+    assert(lzw_compress(Slice("abababab"), true) == 5);
+    for (const Slice &input: {Slice(""), Slice("a"), Slice("aaaaaaaaaaaaaaaaaaaaaaaaa"), Slice(input_1), Slice(budget_input),
+                              Slice(runs_input), Slice(protein_input), Slice(bytes_input)}) {
+        for (const unsigned max_code_bits: {LZW_MIN_CODE_BITS, LZW_DEFAULT_MAX_CODE_BITS, LZW_MAX_CODE_BITS}) {
+            std::vector<uint8_t> compressed;
+            [[maybe_unused]] const size_t num_factors = lzw_compress(input, true, &compressed, max_code_bits);
+            assert(num_factors <= input.size() && (num_factors > 0) == (input.size() > 0));
+            assert(is_lzw(compressed) && input == Slice(lzw_decompress(compressed)));
+
+            LzwDecoder decoder;
+            std::vector<uint8_t> decompressed;
+            std::vector<uint8_t> block;
+            for (size_t i = 0; i < compressed.size(); ++i) {
+                decoder.decode(Slice(compressed).slice(i, 1), block);
+                decompressed.insert(decompressed.end(), block.begin(), block.end());
+                block.clear();
+            }
+            decoder.finish();
+            assert(input == Slice(decompressed));
+
+            [[maybe_unused]] bool lzw_truncated_threw = false;
+            try {
+                lzw_decompress(std::vector<uint8_t>(compressed.begin(), compressed.end() - 1));
+            } catch (const std::runtime_error &) {
+                lzw_truncated_threw = true;
+            }
+            assert(lzw_truncated_threw);
+        }
+    }
+    std::string lzw_reset_input;
+    for (size_t i = 0; i < 20000; ++i) {
+        lzw_reset_input.push_back(static_cast<char>('a' + i * i % 23));
+    }
+    std::vector<uint8_t> lzw_reset_compressed;
+    lzw_compress(Slice(lzw_reset_input), true, &lzw_reset_compressed, LZW_MIN_CODE_BITS);
+    assert(Slice(lzw_decompress(lzw_reset_compressed)) == Slice(lzw_reset_input));
+    std::vector<uint8_t> lzdr_compressed;
+    lzdr_linear_time(Slice(input_1), false, &lzdr_compressed);
+    assert(!is_lzw(lzdr_compressed));
+
+    // Work-stealing pool: every task runs exactly once, also with more workers than tasks
+    for (const size_t num_workers: {1, 3, 8}) {
+        std::vector<std::atomic<size_t> > runs(5);
+        run_work_stealing(num_workers, runs.size(), [&runs, num_workers](const size_t task, [[maybe_unused]] const size_t worker) {
+            assert(worker < num_workers);
+            runs[task] += 1;
+        });
+        assert(std::all_of(runs.begin(), runs.end(), [](const std::atomic<size_t> &count) { return count == 1; }));
+    }
+    std::atomic<size_t> num_finished_tasks = 0;
+    [[maybe_unused]] bool pool_threw = false;
+    try {
+        run_work_stealing(2, 4, [&num_finished_tasks](const size_t task, size_t) {
+            if (task == 0) {
+                throw std::runtime_error("Task failed");
+            }
+            num_finished_tasks += 1;
+        });
+    } catch (const std::runtime_error &) {
+        pool_threw = true;
+    }
+    assert(pool_threw && num_finished_tasks == 3);
+
+    // LZDR with a dictionary
+    const std::vector<Slice> dictionary_inputs = {Slice(input_1), Slice(input_3), Slice(input_4), Slice(input_5), Slice(input_7), Slice(input_8), Slice(input_9), Slice(input_10), Slice(input_11), Slice(input_12)};
+    const LzdrDictionary empty_dictionary = LzdrDictionary::from_bytes(LzdrDictionary::train(Slice("")));
+    assert(empty_dictionary.num_factors() == 0);
+    const LzdrDictionary dictionary = LzdrDictionary::from_bytes(LzdrDictionary::train(Slice(input_3)));
+    assert(dictionary.num_factors() > 0 && dictionary.num_factors() <= lzdr_linear_time(Slice(input_3), false));
+    assert(dictionary.factor(1) == Slice("ab"));
+    for (const Slice &input: dictionary_inputs) {
+        // An empty dictionary has to yield the same compressed data as without a dictionary
+        std::vector<uint8_t> expected_compressed;
+        lzdr_linear_time(input, false, &expected_compressed);
+        std::vector<uint8_t> empty_dictionary_compressed;
+        lzdr_linear_time_with_dictionary(input, empty_dictionary, true, &empty_dictionary_compressed);
+        assert(empty_dictionary_compressed == expected_compressed);
+
+        std::cout << "LZDR (radix trie, dictionary)" << std::endl;
+        std::vector<uint8_t> compressed;
+        const size_t lzdr_dictionary_num_factors = lzdr_linear_time_with_dictionary(input, dictionary, true, &compressed);
+        std::cout << "Num factors: " << lzdr_dictionary_num_factors << std::endl;
+        assert(Slice(lzdr_decompress(compressed, &dictionary)) == input);
+    }
+    // Compressing the corpus itself needs fewer factors
+    assert(lzdr_linear_time_with_dictionary(Slice(input_3), dictionary, true) < lzdr_linear_time(Slice(input_3), false));
+    // With the header, the data is only decompressed with the same dictionary
+    std::vector<uint8_t> marked_compressed;
+    append_dictionary_data_header(marked_compressed, dictionary);
+    lzdr_linear_time_with_dictionary(Slice(input_12), dictionary, false, &marked_compressed);
+    assert(is_lzdr_dictionary_data(marked_compressed) && Slice(lzdr_decompress(marked_compressed, &dictionary)) == Slice(input_12));
+    const LzdrDictionary other_dictionary = LzdrDictionary::from_bytes(LzdrDictionary::train(Slice(input_8)));
+    for (const LzdrDictionary *wrong_dictionary: {static_cast<const LzdrDictionary *>(nullptr), &empty_dictionary, &other_dictionary}) {
+        [[maybe_unused]] bool wrong_dictionary_threw = false;
+        try {
+            lzdr_decompress(marked_compressed, wrong_dictionary);
+        } catch (const std::runtime_error &) {
+            wrong_dictionary_threw = true;
+        }
+        assert(wrong_dictionary_threw);
+    }
+
+    std::cout << std::endl;
+
+    // Parallel blocks with the first block as shared dictionary
+    for (const Slice &input: dictionary_inputs) {
+        for (const size_t block_size: {size_t{1}, size_t{5}, input.size(), input.size() + 1}) {
+            std::vector<uint8_t> compressed;
+            lzdr_parallel_blocks(input, block_size, 3, true, &compressed);
+            assert(is_lzdr_blocks(compressed));
+            assert(Slice(lzdr_blocks_decompress(compressed, 2)) == input);
+        }
+        // A single block is plain LZDR
+        assert(lzdr_parallel_blocks(input, input.size(), 2, false) == lzdr_linear_time(input, false));
+    }
+    std::vector<uint8_t> empty_blocks;
+    assert(lzdr_parallel_blocks(Slice(""), 4, 2, true, &empty_blocks) == 0);
+    assert(lzdr_blocks_decompress(empty_blocks, 2).empty());
+
+    // Continuing a factorization in chunks (appendable files) with separate and merged layers
+    for (const Slice &input: dictionary_inputs) {
+        for (size_t split = 1; split + 1 < input.size(); split += 3) {
+            const Slice chunk_1 = input.slice(0, split);
+            const Slice chunk_2 = input.slice(split, (input.size() - split) / 2);
+            const Slice chunk_3 = input.slice(split + chunk_2.size());
+
+            std::vector<uint8_t> compressed;
+            RadixTrie factors_1;
+            const size_t num_factors_1 = lzdr_linear_time_continued(chunk_1, {}, 0, factors_1, &compressed);
+            std::vector<uint8_t> expected_compressed;
+            lzdr_linear_time(chunk_1, false, &expected_compressed);
+            assert(compressed == expected_compressed);
+            std::vector<uint8_t> layer_1;
+            FlatRadixTrie::serialize(factors_1, layer_1);
+            const FlatRadixTrie layer_trie_1(layer_1.data(), layer_1.size());
+
+            RadixTrie factors_2;
+            const size_t num_factors_2 = lzdr_linear_time_continued(chunk_2, {&layer_trie_1}, num_factors_1, factors_2, &compressed);
+            std::vector<uint8_t> layer_2;
+            FlatRadixTrie::serialize(factors_2, layer_2);
+            const FlatRadixTrie layer_trie_2(layer_2.data(), layer_2.size());
+
+            RadixTrie merged;
+            layer_trie_1.merge_into(merged);
+            layer_trie_2.merge_into(merged);
+            std::vector<uint8_t> merged_layer;
+            FlatRadixTrie::serialize(merged, merged_layer);
+            const FlatRadixTrie merged_trie(merged_layer.data(), merged_layer.size());
+
+            std::vector<uint8_t> separate_compressed = compressed;
+            RadixTrie factors_3;
+            lzdr_linear_time_continued(chunk_3, {&layer_trie_1, &layer_trie_2}, num_factors_1 + num_factors_2, factors_3, &separate_compressed);
+            RadixTrie factors_3_merged;
+            lzdr_linear_time_continued(chunk_3, {&merged_trie}, num_factors_1 + num_factors_2, factors_3_merged, &compressed);
+            assert(compressed == separate_compressed);
+            assert(Slice(lzdr_decompress(compressed)) == input);
+        }
+    }
+
+    // Appending to a file: an empty input creates both files, two appends decompress to both inputs
+    {
+        char directory[] = "/tmp/lzdr_test_XXXXXX";
+        [[maybe_unused]] const bool has_directory = mkdtemp(directory) != nullptr;
+        assert(has_directory);
+        const std::string path = std::string(directory) + "/appended.lzdr";
+        [[maybe_unused]] const auto read_file = [](const std::string &file_path) {
+            std::ifstream file(file_path, std::ios::binary);
+            return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        };
+        [[maybe_unused]] const size_t num_empty_factors = lzdr_append(path, Slice(""));
+        assert(num_empty_factors == 0);
+        assert(std::ifstream(path).good() && std::ifstream(path + ".ckpt").good());
+        assert(read_file(path).empty());
+        const std::string appended = std::string(input_1) + input_12;
+        lzdr_append(path, Slice(input_1));
+        lzdr_append(path, Slice(input_12));
+        assert(Slice(lzdr_decompress(read_file(path))) == Slice(appended.c_str()));
+
+        // Records of an append interrupted before its checkpoint update are truncated by the next append
+        std::ofstream(path, std::ios::binary | std::ios::app) << "partial record";
+        lzdr_append(path, Slice(input_3));
+        const std::string appended_3 = appended + input_3;
+        assert(Slice(lzdr_decompress(read_file(path))) == Slice(appended_3.c_str()));
+
+        // An update interrupted after its journal was written is finished by the next append: the journal holds
+        // the header and all layers, and the checkpoint has lost its layers
+        const std::vector<uint8_t> checkpoint = read_file(path + ".ckpt");
+        const uint64_t layers_offset = sizeof(LzdrCheckpointHeader);
+        {
+            std::ofstream journal(path + ".ckpt.journal", std::ios::binary);
+            journal.write(reinterpret_cast<const char *>(checkpoint.data()), sizeof(LzdrCheckpointHeader));
+            journal.write(reinterpret_cast<const char *>(&layers_offset), sizeof(layers_offset));
+            journal.write(reinterpret_cast<const char *>(checkpoint.data()) + layers_offset,
+                          static_cast<std::streamsize>(checkpoint.size() - layers_offset));
+        }
+        std::ofstream(path + ".ckpt", std::ios::binary).write(reinterpret_cast<const char *>(checkpoint.data()), layers_offset);
+        lzdr_append(path, Slice(input_8));
+        assert(!std::ifstream(path + ".ckpt.journal").good());
+        const std::string appended_8 = appended_3 + input_8;
+        assert(Slice(lzdr_decompress(read_file(path))) == Slice(appended_8.c_str()));
+        std::remove(path.c_str());
+        std::remove((path + ".ckpt").c_str());
+        std::remove(directory);
+    }
+
+    std::cout << std::endl;
+
+    // Slice access
+    const Slice slice_1("abcabd");
+    assert(slice_1.at(5) == 'd');
+    [[maybe_unused]] bool at_threw = false;
+    try {
+        static_cast<void>(slice_1.at(6));
+    } catch (const std::out_of_range &) {
+        at_threw = true;
+    }
+    assert(at_threw);
+    // Tests run in debug builds, where operator[] is checked, too
+    [[maybe_unused]] bool index_threw = false;
+    try {
+        static_cast<void>(slice_1[6]);
+    } catch (const std::out_of_range &) {
+        index_threw = true;
+    }
+    assert(index_threw == (SLICE_CHECKED_ACCESS != 0));
+    assert(slice_1.common_prefix_length(slice_1.slice(3)) == 2);
+    assert(slice_1.common_prefix_length(Slice("abcabdx")) == 6);
+    assert(slice_1.common_prefix_length(Slice::create_empty()) == 0);
+
+    // Mismatch kernels agree with the byte-wise comparison for every length and mismatch position
+    mismatch_internal::NamedKernel kernels[4];
+    const size_t num_kernels = mismatch_internal::supported_kernels(kernels);
+    std::vector<uint8_t> mismatch_a(100);
+    for (size_t i = 0; i < mismatch_a.size(); ++i) {
+        mismatch_a[i] = static_cast<uint8_t>(i * 7);
+    }
+    for (size_t n = 0; n <= mismatch_a.size(); ++n) {
+        for (size_t pos = 0; pos <= n; ++pos) {
+            // Unaligned b, mismatch at pos (none if pos == n)
+            std::vector<uint8_t> mismatch_b(mismatch_a.size() + 1);
+            std::copy(mismatch_a.begin(), mismatch_a.end(), mismatch_b.begin() + 1);
+            if (pos < n) {
+                mismatch_b[pos + 1] ^= 0x80;
+            }
+            for (size_t k = 0; k < num_kernels; ++k) {
+                assert(kernels[k].kernel(mismatch_a.data(), mismatch_b.data() + 1, n) == pos);
+            }
+            assert(first_mismatch(mismatch_a.data(), mismatch_b.data() + 1, n) == pos);
+        }
+    }
+
     // Radix trie, Wikipedia test cases (https://en.wikipedia.org/wiki/Radix_tree)
     RadixTrie trie1;
     assert(lzdr_linear_time_internal::insert_into_radix_trie(trie1, &trie1.root_node, Slice("test")));
@@ -291,6 +954,35 @@ void run_tests() {
     //assert(!lzdr_linear_time_internal::insert_into_radix_trie(trie4, Slice("")));
     //assert(trie4.root_node.debug_representation_json() == "{\"0(0)\":{\"to\":{\"3(3)\":{\"ast\":{\"1(1)\":{}},\"ol\":{\"2(2)\":{}}}}}}");
 
+    // Root jump table is only allocated once the trie is large enough, then kept up to date by insertions
+    RadixTrie trie5;
+    trie5.enable_root_jump_table(2);
+    assert(!trie5.has_root_jump_table());
+    assert(lzdr_linear_time_internal::insert_into_radix_trie(trie5, &trie5.root_node, Slice("toast")));
+    assert(trie5.has_root_jump_table());
+    [[maybe_unused]] const RootJumpEntry jump1 = trie5.root_jump('t', 'o');
+    assert(jump1.first_edge == &trie5.root_node.edges.at('t') && jump1.second_edge == jump1.first_edge);
+    assert(trie5.root_jump('t', 'x').first_edge == jump1.first_edge && trie5.root_jump('t', 'x').second_edge == nullptr);
+    assert(trie5.root_jump('x', 't').first_edge == nullptr);
+    // Split of the root edge directly after its first byte
+    assert(lzdr_linear_time_internal::insert_into_radix_trie(trie5, &trie5.root_node, Slice("t")));
+    [[maybe_unused]] const RootJumpEntry jump2 = trie5.root_jump('t', 'o');
+    assert(jump2.first_edge == jump1.first_edge && jump2.second_edge == &jump1.first_edge->end_node.edges.at('o'));
+    assert(jump2.second_edge->rest_text == Slice("ast"));
+    // New edges below the depth one node (also when the insertion starts there) and below the root node
+    assert(trie5.root_jump('t', 'x').second_edge == nullptr);
+    assert(lzdr_linear_time_internal::insert_into_radix_trie(trie5, &jump1.first_edge->end_node, Slice("x")));
+    assert(trie5.root_jump('t', 'x').second_edge == &jump1.first_edge->end_node.edges.at('x'));
+    assert(lzdr_linear_time_internal::insert_into_radix_trie(trie5, &trie5.root_node, Slice("ty")));
+    assert(trie5.root_jump('t', 'y').second_edge == &jump1.first_edge->end_node.edges.at('y'));
+    assert(lzdr_linear_time_internal::insert_into_radix_trie(trie5, &trie5.root_node, Slice("xt")));
+    assert(trie5.root_jump('x', 't').second_edge == &trie5.root_node.edges.at('x'));
+    assert(trie5.root_jump('x', 'y').first_edge == &trie5.root_node.edges.at('x') && trie5.root_jump('x', 'y').second_edge == nullptr);
+    // Mismatch split of a root edge directly after its first byte
+    assert(lzdr_linear_time_internal::insert_into_radix_trie(trie5, &trie5.root_node, Slice("xy")));
+    assert(trie5.root_jump('x', 't').second_edge == &trie5.root_node.edges.at('x').end_node.edges.at('t'));
+    assert(trie5.root_jump('x', 'y').second_edge == &trie5.root_node.edges.at('x').end_node.edges.at('y'));
+
     std::cout << std::endl;
 
     // Counted radix trie
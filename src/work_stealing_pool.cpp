@@ -0,0 +1,85 @@
+#include "work_stealing_pool.h"
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Tasks are coarse (whole files or blocks), so a mutex per deque is cheap enough
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::optional<size_t> take_own(WorkerQueue &queue) {
+        const std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return std::nullopt;
+        }
+        const size_t task = queue.tasks.front();
+        queue.tasks.pop_front();
+        return task;
+    }
+
+    std::optional<size_t> steal(WorkerQueue &queue) {
+        const std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return std::nullopt;
+        }
+        const size_t task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return task;
+    }
+}
+
+void run_work_stealing(size_t num_workers, const size_t num_tasks, const std::function<void(size_t, size_t)> &task) {
+    if (num_workers == 0) {
+        num_workers = 1;
+    }
+    std::vector<WorkerQueue> queues(num_workers);
+    for (size_t i = 0; i < num_tasks; ++i) {
+        queues[i % num_workers].tasks.push_back(i);
+    }
+
+    std::mutex exception_mutex;
+    std::exception_ptr first_exception;
+    const auto work = [&](const size_t worker) {
+        // No task gets added while running, so a worker is done once all deques are empty
+        while (true) {
+            std::optional<size_t> next = take_own(queues[worker]);
+            for (size_t offset = 1; !next && offset < num_workers; ++offset) {
+                next = steal(queues[(worker + offset) % num_workers]);
+            }
+            if (!next) {
+                return;
+            }
+            try {
+                task(*next, worker);
+            } catch (...) {
+                const std::lock_guard<std::mutex> lock(exception_mutex);
+                if (!first_exception) {
+                    first_exception = std::current_exception();
+                }
+            }
+        }
+    };
+
+    // The calling thread is worker 0
+    std::vector<std::thread> threads;
+    for (size_t worker = 1; worker < num_workers; ++worker) {
+        threads.emplace_back(work, worker);
+    }
+    work(0);
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    if (first_exception) {
+        std::rethrow_exception(first_exception);
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+#include <cstddef>
+#include <functional>
+
+// Runs task(task_index, worker_index) for every task index in [0, num_tasks) on num_workers threads
+// (worker_index is in [0, num_workers)) and returns when all tasks are done.
+//
+// The tasks are dealt round-robin onto one deque per worker in index order. Each worker takes tasks from the front
+// of its own deque and, once it is empty, steals from the back of the other deques. So tasks with small indices
+// are started first (pass the most expensive ones first), and the cheap ones at the end balance the load.
+// If tasks throw, the remaining tasks still run and the first exception is rethrown afterward.
+void run_work_stealing(size_t num_workers, size_t num_tasks, const std::function<void(size_t, size_t)> &task);
+
+#endif //WORK_STEALING_POOL_H